@@ -0,0 +1,129 @@
+/** \file clp-app-mgr-array.c
+ *
+ * \brief Builder for the single block results of the v2 listing APIs
+ *
+ * Implementation of the builder described in clp-app-mgr-array.h.
+ */
+
+#include <string.h>
+#include <glib.h>
+#include "clp-app-mgr-array.h"
+
+#define ARRAY_ALIGN(size)	(((size) + 15) & ~(gsize) 15)	/**< records and strings start on a 16 byte boundary */
+
+typedef struct _ClpAppMgrArrayFixup				/**< String field of a record */
+{
+	gsize		field;					/**< offset of the gchar* field from the start of the records */
+	gsize		string;					/**< offset of the string in the arena */
+}ClpAppMgrArrayFixup;
+
+
+/** \brief Start building a result
+ *
+ * \param builder Builder to initialise
+ * \param record_size Size of one record, for eg sizeof(ClpAppMgrInstalledApp)
+ */
+void
+clp_app_mgr_array_builder_init(ClpAppMgrArrayBuilder *builder, gsize record_size)
+{
+	builder->record_size = record_size;
+	builder->records = g_array_new(FALSE, TRUE, record_size);
+	builder->strings = g_string_new(NULL);
+	builder->fixups = g_array_new(FALSE, FALSE, sizeof(ClpAppMgrArrayFixup));
+}
+
+
+/** \brief Append a zeroed record
+ *
+ * \return The new record. It stays valid until the next append; its string fields must be set with
+ * clp_app_mgr_array_builder_set_string(), not directly.
+ */
+gpointer
+clp_app_mgr_array_builder_append(ClpAppMgrArrayBuilder *builder)
+{
+	g_array_set_size(builder->records, builder->records->len + 1);
+	return builder->records->data + (builder->records->len - 1) * builder->record_size;
+}
+
+
+/** \brief Set a string field of the last record
+ *
+ * \param builder The builder
+ * \param field_offset Offset of the field in the record, G_STRUCT_OFFSET(type, field)
+ * \param str String copied into the arena, NULL leaves the field NULL
+ * \param len Length of str, -1 if it is NUL terminated
+ */
+void
+clp_app_mgr_array_builder_set_string_len(ClpAppMgrArrayBuilder *builder, gsize field_offset, const gchar *str, gssize len)
+{
+	ClpAppMgrArrayFixup fixup;
+
+	g_return_if_fail(builder->records->len > 0);
+	if (str == NULL)
+		return;
+	if (len < 0)
+		len = strlen(str);
+
+	fixup.field = (builder->records->len - 1) * builder->record_size + field_offset;
+	fixup.string = builder->strings->len;
+	g_string_append_len(builder->strings, str, len);
+	g_string_append_c(builder->strings, '\0');
+	g_array_append_val(builder->fixups, fixup);
+}
+
+
+/** \brief Set a NUL terminated string field of the last record */
+void
+clp_app_mgr_array_builder_set_string(ClpAppMgrArrayBuilder *builder, gsize field_offset, const gchar *str)
+{
+	clp_app_mgr_array_builder_set_string_len(builder, field_offset, str, -1);
+}
+
+
+/** \brief Lay the result out in one block and release the builder
+ *
+ * \return The result, to be freed with clp_app_mgr_array_free()
+ */
+ClpAppMgrArray*
+clp_app_mgr_array_builder_finish(ClpAppMgrArrayBuilder *builder)
+{
+	gsize records_size = builder->records->len * builder->record_size;
+	ClpAppMgrArray *array;
+	gchar *records, *strings;
+	guint i;
+
+	array = g_malloc(ARRAY_ALIGN(sizeof(ClpAppMgrArray)) + ARRAY_ALIGN(records_size) + builder->strings->len);
+	records = (gchar *) array + ARRAY_ALIGN(sizeof(ClpAppMgrArray));
+	strings = records + ARRAY_ALIGN(records_size);
+
+	array->n_records = builder->records->len;
+	array->record_size = builder->record_size;
+	array->records = records;
+	memcpy(records, builder->records->data, records_size);
+	memcpy(strings, builder->strings->str, builder->strings->len);
+
+	for (i = 0; i < builder->fixups->len; i++)
+	{
+		ClpAppMgrArrayFixup *fixup = &g_array_index(builder->fixups, ClpAppMgrArrayFixup, i);
+		gchar *str = strings + fixup->string;
+		memcpy(records + fixup->field, &str, sizeof(gchar *));
+	}
+
+	g_array_free(builder->records, TRUE);
+	g_string_free(builder->strings, TRUE);
+	g_array_free(builder->fixups, TRUE);
+	return array;
+}
+
+
+/** \brief Free the result of a v2 listing API
+ *
+ * \param array The result, may be NULL
+ *
+ * The records and their strings live in the same block, nothing else needs to be freed.
+ */
+void
+clp_app_mgr_array_free(ClpAppMgrArray *array)
+{
+	g_free(array);
+}
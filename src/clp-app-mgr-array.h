@@ -0,0 +1,30 @@
+/** \file clp-app-mgr-array.h
+ * \brief Builder for the single block results of the v2 listing APIs
+ *
+ * Records are appended to a growing array and their strings to a growing arena; string fields are recorded as
+ * fixups and turned into pointers once the block is laid out. The result is one g_malloc() block holding the
+ * ClpAppMgrArray header, the records and the strings, freed by clp_app_mgr_array_free().
+ * This header is internal to the library, it is not installed.
+ */
+
+#ifndef __CLP_APP_MGR_ARRAY_H__
+#define __CLP_APP_MGR_ARRAY_H__
+
+#include <glib.h>
+#include "clp-app-mgr.h"
+
+typedef struct _ClpAppMgrArrayBuilder				/**< Result being built */
+{
+	gsize		record_size;				/**< size of one record */
+	GArray		*records;				/**< records appended so far */
+	GString		*strings;				/**< string arena */
+	GArray		*fixups;				/**< string fields to point into the arena */
+}ClpAppMgrArrayBuilder;
+
+void clp_app_mgr_array_builder_init (ClpAppMgrArrayBuilder *builder, gsize record_size);
+gpointer clp_app_mgr_array_builder_append (ClpAppMgrArrayBuilder *builder);
+void clp_app_mgr_array_builder_set_string (ClpAppMgrArrayBuilder *builder, gsize field_offset, const gchar *str);
+void clp_app_mgr_array_builder_set_string_len (ClpAppMgrArrayBuilder *builder, gsize field_offset, const gchar *str, gssize len);
+ClpAppMgrArray* clp_app_mgr_array_builder_finish (ClpAppMgrArrayBuilder *builder);
+
+#endif /*__CLP_APP_MGR_ARRAY_H__ */
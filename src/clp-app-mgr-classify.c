@@ -0,0 +1,784 @@
+/** \file clp-app-mgr-classify.c
+ *
+ * \brief String classifier of the Application Manager Library
+ *
+ * Implementation of the classifier described in clp-app-mgr-classify.h. Every pattern is parsed straight into a
+ * Thompson NFA whose final state accepts the index of the pattern. The bytes are partitioned into the classes
+ * no byte set of the NFA tells apart, and the subset construction turns the NFA into a DFA over these classes.
+ * The classifier is immutable and shared by reference, like the other caches of the library.
+ */
+
+#include <string.h>
+#include <glib.h>
+#include "clp-app-mgr-config.h"
+#include "clp-app-mgr-classify.h"
+#include "clp-app-mgr-desktop-db.h"
+#include "clp-app-mgr-monitor.h"
+#include "clp-app-mgr-keyfile.h"
+
+#define CLASSIFY_SET_ADD(set, c)	((set)->bits[(guchar)(c) >> 5] |= 1u << ((guchar)(c) & 31))
+#define CLASSIFY_SET_HAS(set, c)	(((set)->bits[(guchar)(c) >> 5] >> ((guchar)(c) & 31)) & 1)
+#define CLASSIFY_DEAD			0			/**< DFA state without a way out */
+#define CLASSIFY_START			1			/**< DFA state before the first byte */
+
+typedef struct _ClassifySet					/**< Set of bytes */
+{
+	guint32		bits[8];				/**< one bit per byte value */
+}ClassifySet;
+
+typedef struct _ClassifyNfaState				/**< One NFA state */
+{
+	gint		set;					/**< index of the byte set of the byte edge, -1 if none */
+	gint		next;					/**< target of the byte edge */
+	gint		eps[2];					/**< targets of the epsilon edges, -1 if unused */
+	gint		accept;					/**< pattern accepted in this state, -1 if none */
+}ClassifyNfaState;
+
+typedef struct _ClassifyNfa					/**< NFA of all the patterns */
+{
+	GArray		*states;				/**< ClassifyNfaState */
+	GArray		*sets;					/**< ClassifySet of the byte edges */
+	GArray		*starts;				/**< start state of each pattern, gint */
+}ClassifyNfa;
+
+typedef struct _ClassifyFrag					/**< Part of the NFA with one way in and one way out */
+{
+	gint		start;					/**< entry state */
+	gint		end;					/**< exit state, without edges yet */
+}ClassifyFrag;
+
+typedef struct _ClassifyParser					/**< Pattern being parsed */
+{
+	ClassifyNfa	*nfa;					/**< NFA the pattern is added to */
+	const gchar	*p;					/**< next character of the pattern */
+	gboolean	error;					/**< the pattern is malformed */
+}ClassifyParser;
+
+typedef struct _ClpAppMgrClassifier				/**< Compiled patterns */
+{
+	volatile gint	ref_count;				/**< references held by the library and the callers */
+	guint		generation;				/**< desktop generation the patterns were read at */
+	guint8		class_of[256];				/**< byte class of each byte */
+	guint		n_classes;				/**< number of byte classes */
+	guint		n_states;				/**< number of DFA states, 0 if nothing is classified */
+	guint16		*trans;					/**< next state, indexed by state * n_classes + class */
+	gint		*accept;				/**< pattern accepted in each state, -1 if none */
+	GPtrArray	*results;				/**< interned MIME type of each pattern */
+}ClpAppMgrClassifier;
+
+static ClpAppMgrClassifier *current_classifier = NULL;		/**< classifier shared by all the callers of this process */
+G_LOCK_DEFINE_STATIC (current_classifier);
+
+
+/** \brief Add a state to the NFA
+ *
+ * \return Index of the state
+ */
+static gint
+classify_state_new(ClassifyNfa *nfa)
+{
+	ClassifyNfaState state = { -1, -1, { -1, -1 }, -1 };
+
+	g_array_append_val(nfa->states, state);
+	return nfa->states->len - 1;
+}
+
+
+/** \brief Add an epsilon edge, a state has room for two */
+static void
+classify_eps(ClassifyNfa *nfa, gint from, gint to)
+{
+	ClassifyNfaState *state = &g_array_index(nfa->states, ClassifyNfaState, from);
+
+	if (state->eps[0] < 0)
+		state->eps[0] = to;
+	else
+		state->eps[1] = to;
+}
+
+
+/** \brief Fragment matching one byte of a set */
+static ClassifyFrag
+classify_frag_set(ClassifyNfa *nfa, const ClassifySet *set)
+{
+	ClassifyFrag frag;
+	ClassifyNfaState *state;
+
+	frag.start = classify_state_new(nfa);
+	frag.end = classify_state_new(nfa);
+	g_array_append_val(nfa->sets, *set);
+	state = &g_array_index(nfa->states, ClassifyNfaState, frag.start);
+	state->set = nfa->sets->len - 1;
+	state->next = frag.end;
+	return frag;
+}
+
+
+/** \brief Fragment matching the empty string */
+static ClassifyFrag
+classify_frag_empty(ClassifyNfa *nfa)
+{
+	ClassifyFrag frag;
+
+	frag.start = classify_state_new(nfa);
+	frag.end = classify_state_new(nfa);
+	classify_eps(nfa, frag.start, frag.end);
+	return frag;
+}
+
+
+/** \brief Add the bytes of an escape to a set
+ *
+ * \param c Character following the backslash
+ * \param set Set the bytes are added to
+ */
+static void
+classify_escape(gchar c, ClassifySet *set)
+{
+	ClassifySet class;
+	gint b, i;
+
+	memset(&class, 0, sizeof(class));
+	switch (g_ascii_tolower(c))
+	{
+	case 'd':
+		for (b = '0'; b <= '9'; b++)
+			CLASSIFY_SET_ADD(&class, b);
+		break;
+	case 'w':
+		for (b = 0; b < 256; b++)
+			if (g_ascii_isalnum(b) || b == '_')
+				CLASSIFY_SET_ADD(&class, b);
+		break;
+	case 's':
+		for (b = 0; b < 256; b++)
+			if (g_ascii_isspace(b))
+				CLASSIFY_SET_ADD(&class, b);
+		break;
+	default:
+		if (c == 'n')
+			CLASSIFY_SET_ADD(set, '\n');
+		else if (c == 't')
+			CLASSIFY_SET_ADD(set, '\t');
+		else if (c == 'r')
+			CLASSIFY_SET_ADD(set, '\r');
+		else
+			CLASSIFY_SET_ADD(set, c);
+		return;
+	}
+	/* \D \W \S are the complements */
+	for (i = 0; i < 8; i++)
+		set->bits[i] |= g_ascii_isupper(c) ? ~class.bits[i] : class.bits[i];
+}
+
+
+static ClassifyFrag classify_parse_alt (ClassifyParser *parser);
+
+
+/** \brief Parse a bracket class, the opening bracket already consumed */
+static ClassifyFrag
+classify_parse_class(ClassifyParser *parser)
+{
+	ClassifySet set;
+	gboolean negate = FALSE, first = TRUE;
+	gint i;
+
+	memset(&set, 0, sizeof(set));
+	if (*parser->p == '^')
+	{
+		negate = TRUE;
+		parser->p++;
+	}
+	while (*parser->p && (*parser->p != ']' || first))
+	{
+		guchar low = *parser->p++, high;
+
+		first = FALSE;
+		if (low == '\\' && *parser->p)
+		{
+			classify_escape(*parser->p++, &set);
+			continue;
+		}
+		high = low;
+		if (parser->p[0] == '-' && parser->p[1] && parser->p[1] != ']')
+		{
+			high = parser->p[1];
+			parser->p += 2;
+		}
+		for (i = low; i <= high; i++)
+			CLASSIFY_SET_ADD(&set, i);
+	}
+	if (*parser->p != ']')
+		parser->error = TRUE;
+	else
+		parser->p++;
+
+	if (negate)
+		for (i = 0; i < 8; i++)
+			set.bits[i] = ~set.bits[i];
+	return classify_frag_set(parser->nfa, &set);
+}
+
+
+/** \brief Parse an atom: a byte, a class or a group */
+static ClassifyFrag
+classify_parse_atom(ClassifyParser *parser)
+{
+	ClassifySet set;
+	ClassifyFrag frag;
+	gint i;
+
+	memset(&set, 0, sizeof(set));
+	switch (*parser->p)
+	{
+	case '(':
+		parser->p++;
+		frag = classify_parse_alt(parser);
+		if (*parser->p != ')')
+			parser->error = TRUE;
+		else
+			parser->p++;
+		return frag;
+	case '[':
+		parser->p++;
+		return classify_parse_class(parser);
+	case '.':
+		parser->p++;
+		for (i = 0; i < 256; i++)
+			if (i != '\n')
+				CLASSIFY_SET_ADD(&set, i);
+		return classify_frag_set(parser->nfa, &set);
+	case '\\':
+		parser->p++;
+		if (*parser->p == '\0')
+		{
+			parser->error = TRUE;
+			return classify_frag_empty(parser->nfa);
+		}
+		classify_escape(*parser->p++, &set);
+		return classify_frag_set(parser->nfa, &set);
+	case '*':
+	case '+':
+	case '?':
+		parser->error = TRUE;
+		parser->p++;
+		return classify_frag_empty(parser->nfa);
+	default:
+		CLASSIFY_SET_ADD(&set, *parser->p);
+		parser->p++;
+		return classify_frag_set(parser->nfa, &set);
+	}
+}
+
+
+/** \brief Parse an atom followed by any number of '*', '+' and '?' */
+static ClassifyFrag
+classify_parse_repeat(ClassifyParser *parser)
+{
+	ClassifyFrag atom = classify_parse_atom(parser), frag;
+
+	while (*parser->p == '*' || *parser->p == '+' || *parser->p == '?')
+	{
+		gchar op = *parser->p++;
+
+		frag.start = classify_state_new(parser->nfa);
+		frag.end = classify_state_new(parser->nfa);
+		classify_eps(parser->nfa, frag.start, atom.start);
+		if (op != '+')
+			classify_eps(parser->nfa, frag.start, frag.end);
+		if (op != '?')
+			classify_eps(parser->nfa, atom.end, atom.start);
+		classify_eps(parser->nfa, atom.end, frag.end);
+		atom = frag;
+	}
+	return atom;
+}
+
+
+/** \brief Parse a sequence of repeated atoms, possibly empty */
+static ClassifyFrag
+classify_parse_concat(ClassifyParser *parser)
+{
+	ClassifyFrag frag, next;
+
+	if (*parser->p == '\0' || *parser->p == '|' || *parser->p == ')')
+		return classify_frag_empty(parser->nfa);
+
+	frag = classify_parse_repeat(parser);
+	while (*parser->p && *parser->p != '|' && *parser->p != ')')
+	{
+		next = classify_parse_repeat(parser);
+		classify_eps(parser->nfa, frag.end, next.start);
+		frag.end = next.end;
+	}
+	return frag;
+}
+
+
+/** \brief Parse alternatives separated by '|' */
+static ClassifyFrag
+classify_parse_alt(ClassifyParser *parser)
+{
+	ClassifyFrag frag = classify_parse_concat(parser), alt, next;
+
+	while (*parser->p == '|')
+	{
+		parser->p++;
+		next = classify_parse_concat(parser);
+		alt.start = classify_state_new(parser->nfa);
+		alt.end = classify_state_new(parser->nfa);
+		classify_eps(parser->nfa, alt.start, frag.start);
+		classify_eps(parser->nfa, alt.start, next.start);
+		classify_eps(parser->nfa, frag.end, alt.end);
+		classify_eps(parser->nfa, next.end, alt.end);
+		frag = alt;
+	}
+	return frag;
+}
+
+
+/** \brief Add a pattern to the NFA
+ *
+ * \param nfa The NFA
+ * \param pattern The pattern, matched against the whole string so '^' and '$' around it are ignored
+ * \param index Index of the pattern
+ *
+ * \return TRUE if the pattern was added, FALSE if it is malformed. The states of a malformed pattern are left
+ * unreachable.
+ */
+static gboolean
+classify_nfa_add(ClassifyNfa *nfa, const gchar *pattern, gint index)
+{
+	ClassifyParser parser;
+	ClassifyFrag frag;
+	gchar *body = g_strdup(pattern[0] == '^' ? pattern + 1 : pattern);
+	gsize length = strlen(body);
+
+	if (length > 0 && body[length - 1] == '$' && (length == 1 || body[length - 2] != '\\'))
+		body[length - 1] = '\0';
+
+	parser.nfa = nfa;
+	parser.p = body;
+	parser.error = FALSE;
+	frag = classify_parse_alt(&parser);
+	if (parser.error || *parser.p != '\0')
+	{
+		CLP_APPMGR_WARN_V("Malformed string pattern %s", pattern);
+		g_free(body);
+		return FALSE;
+	}
+	g_free(body);
+
+	g_array_index(nfa->states, ClassifyNfaState, frag.end).accept = index;
+	g_array_append_val(nfa->starts, frag.start);
+	return TRUE;
+}
+
+
+/** \brief Add a state and the states reached from it by epsilon edges to a set of NFA states */
+static void
+classify_closure(ClassifyNfa *nfa, guint32 *states, gint state)
+{
+	GArray *stack = g_array_new(FALSE, FALSE, sizeof(gint));
+
+	g_array_append_val(stack, state);
+	while (stack->len > 0)
+	{
+		const ClassifyNfaState *nfa_state;
+		gint i;
+
+		state = g_array_index(stack, gint, stack->len - 1);
+		g_array_set_size(stack, stack->len - 1);
+		if (states[state >> 5] & (1u << (state & 31)))
+			continue;
+		states[state >> 5] |= 1u << (state & 31);
+
+		nfa_state = &g_array_index(nfa->states, ClassifyNfaState, state);
+		for (i = 0; i < 2; i++)
+			if (nfa_state->eps[i] >= 0)
+				g_array_append_val(stack, nfa_state->eps[i]);
+	}
+	g_array_free(stack, TRUE);
+}
+
+
+/** \brief Key of a set of NFA states in the table of DFA states */
+static gchar*
+classify_states_key(const guint32 *states, guint n_words)
+{
+	return g_base64_encode((const guchar *) states, n_words * sizeof(guint32));
+}
+
+
+/** \brief Compute the byte classes of an NFA
+ *
+ * Two bytes are in the same class when every byte set of the NFA holds both or none of them.
+ */
+static void
+classify_byte_classes(ClpAppMgrClassifier *classifier, ClassifyNfa *nfa)
+{
+	gint remap[256][2];
+	guint i, b;
+
+	memset(classifier->class_of, 0, sizeof(classifier->class_of));
+	classifier->n_classes = 1;
+	for (i = 0; i < nfa->sets->len; i++)
+	{
+		const ClassifySet *set = &g_array_index(nfa->sets, ClassifySet, i);
+		guint n_classes = 0;
+
+		memset(remap, -1, sizeof(remap));
+		for (b = 0; b < 256; b++)
+		{
+			gint *class = &remap[classifier->class_of[b]][CLASSIFY_SET_HAS(set, b)];
+			if (*class < 0)
+				*class = n_classes++;
+			classifier->class_of[b] = *class;
+		}
+		classifier->n_classes = n_classes;
+	}
+}
+
+
+/** \brief Build the DFA of an NFA by subset construction
+ *
+ * \return FALSE if it would have more than CLP_APP_MGR_CLASSIFY_MAX_STATES states
+ */
+static gboolean
+classify_build_dfa(ClpAppMgrClassifier *classifier, ClassifyNfa *nfa)
+{
+	guint n_words = (nfa->states->len + 31) / 32;
+	GPtrArray *dfa_states = g_ptr_array_new();
+	GHashTable *dfa_index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	GArray *trans = g_array_new(FALSE, TRUE, sizeof(guint16));
+	GArray *accept = g_array_new(FALSE, FALSE, sizeof(gint));
+	guint8 representative[256];
+	guint32 *states;
+	gboolean res = TRUE;
+	guint current, i, c;
+	gint b;
+
+	classify_byte_classes(classifier, nfa);
+	for (b = 255; b >= 0; b--)
+		representative[classifier->class_of[b]] = b;
+
+	/* the dead state has no NFA state, the start state all the starts of the patterns */
+	g_ptr_array_add(dfa_states, g_new0(guint32, n_words));
+	states = g_new0(guint32, n_words);
+	for (i = 0; i < nfa->starts->len; i++)
+		classify_closure(nfa, states, g_array_index(nfa->starts, gint, i));
+	g_ptr_array_add(dfa_states, states);
+	g_hash_table_insert(dfa_index, classify_states_key(dfa_states->pdata[CLASSIFY_DEAD], n_words), GINT_TO_POINTER(CLASSIFY_DEAD));
+	g_hash_table_insert(dfa_index, classify_states_key(states, n_words), GINT_TO_POINTER(CLASSIFY_START));
+
+	for (current = 0; current < dfa_states->len && res; current++)
+	{
+		const guint32 *from = dfa_states->pdata[current];
+		gint accepted = -1;
+
+		g_array_set_size(trans, (current + 1) * classifier->n_classes);
+		for (i = 0; i < nfa->states->len; i++)
+		{
+			const ClassifyNfaState *nfa_state;
+
+			if (!(from[i >> 5] & (1u << (i & 31))))
+				continue;
+			nfa_state = &g_array_index(nfa->states, ClassifyNfaState, i);
+			if (nfa_state->accept >= 0 && (accepted < 0 || nfa_state->accept < accepted))
+				accepted = nfa_state->accept;
+		}
+		g_array_append_val(accept, accepted);
+
+		for (c = 0; c < classifier->n_classes; c++)
+		{
+			gchar *key;
+			gpointer target;
+
+			states = g_new0(guint32, n_words);
+			for (i = 0; i < nfa->states->len; i++)
+			{
+				const ClassifyNfaState *nfa_state = &g_array_index(nfa->states, ClassifyNfaState, i);
+
+				if ((from[i >> 5] & (1u << (i & 31))) && nfa_state->set >= 0
+					&& CLASSIFY_SET_HAS(&g_array_index(nfa->sets, ClassifySet, nfa_state->set), representative[c]))
+					classify_closure(nfa, states, nfa_state->next);
+			}
+
+			key = classify_states_key(states, n_words);
+			if (g_hash_table_lookup_extended(dfa_index, key, NULL, &target))
+			{
+				g_free(key);
+				g_free(states);
+			}
+			else if (dfa_states->len == CLP_APP_MGR_CLASSIFY_MAX_STATES)
+			{
+				CLP_APPMGR_WARN_V("The string patterns need more than %d states, strings are not classified", CLP_APP_MGR_CLASSIFY_MAX_STATES);
+				g_free(key);
+				g_free(states);
+				res = FALSE;
+				break;
+			}
+			else
+			{
+				target = GINT_TO_POINTER(dfa_states->len);
+				g_ptr_array_add(dfa_states, states);
+				g_hash_table_insert(dfa_index, key, target);
+			}
+			g_array_index(trans, guint16, current * classifier->n_classes + c) = GPOINTER_TO_INT(target);
+		}
+	}
+
+	if (res)
+	{
+		classifier->n_states = dfa_states->len;
+		classifier->trans = (guint16 *) g_array_free(trans, FALSE);
+		classifier->accept = (gint *) g_array_free(accept, FALSE);
+	}
+	else
+	{
+		g_array_free(trans, TRUE);
+		g_array_free(accept, TRUE);
+	}
+	for (i = 0; i < dfa_states->len; i++)
+		g_free(dfa_states->pdata[i]);
+	g_ptr_array_free(dfa_states, TRUE);
+	g_hash_table_destroy(dfa_index);
+	return res;
+}
+
+
+/** \brief Split a raw desktop file list
+ *
+ * \param value Value as written in the desktop file
+ *
+ * \return The entries, to be freed with g_strfreev(). "\;" is kept in the entry as ';', "\\" as one backslash,
+ * any other backslash is kept as is.
+ */
+static gchar**
+classify_split_list(const gchar *value)
+{
+	GPtrArray *entries = g_ptr_array_new();
+	GString *entry = g_string_new(NULL);
+	const gchar *p;
+
+	for (p = value; *p; p++)
+	{
+		if (p[0] == '\\' && (p[1] == ';' || p[1] == '\\'))
+			g_string_append_c(entry, *++p);
+		else if (*p == ';')
+		{
+			if (entry->len)
+				g_ptr_array_add(entries, g_strdup(entry->str));
+			g_string_truncate(entry, 0);
+		}
+		else
+			g_string_append_c(entry, *p);
+	}
+	if (entry->len)
+		g_ptr_array_add(entries, g_strdup(entry->str));
+	g_string_free(entry, TRUE);
+	g_ptr_array_add(entries, NULL);
+	return (gchar **) g_ptr_array_free(entries, FALSE);
+}
+
+
+/** \brief Collect the patterns of one application
+ *
+ * \param mime_types Value of its MimeType key, NULL if none
+ * \param patterns Value of its X-StringPatterns key, NULL if none
+ * \param declared Returns the declared patterns followed by their MIME types
+ * \param schemes Returns the URI schemes, a set of interned strings
+ */
+static void
+classify_collect(const gchar *mime_types, const gchar *patterns, GPtrArray *declared, GHashTable *schemes)
+{
+	gchar **entries;
+	gint i;
+
+	if (patterns)
+	{
+		entries = classify_split_list(patterns);
+		for (i = 0; entries[i]; i++)
+		{
+			gchar *colon = strchr(entries[i], ':');
+			if (colon == NULL || colon == entries[i])
+			{
+				CLP_APPMGR_WARN_V("String pattern %s has no MIME type", entries[i]);
+				continue;
+			}
+			*colon = '\0';
+			g_ptr_array_add(declared, g_strdup(colon + 1));
+			g_ptr_array_add(declared, (gpointer) g_intern_string(entries[i]));
+		}
+		g_strfreev(entries);
+	}
+
+	if (mime_types)
+	{
+		entries = g_strsplit(mime_types, ";", -1);
+		for (i = 0; entries[i]; i++)
+			if (g_str_has_prefix(entries[i], "x-scheme-handler/") && entries[i][strlen("x-scheme-handler/")])
+				g_hash_table_insert(schemes, (gpointer) g_intern_string(entries[i]), NULL);
+		g_strfreev(entries);
+	}
+}
+
+
+/** \brief Pattern of the strings of a URI scheme
+ *
+ * \param mime_type "x-scheme-handler/<scheme>"
+ *
+ * \return "<scheme>:.*" with every letter matched without case, to be freed
+ */
+static gchar*
+classify_scheme_pattern(const gchar *mime_type)
+{
+	GString *pattern = g_string_new(NULL);
+	const gchar *p;
+
+	for (p = mime_type + strlen("x-scheme-handler/"); *p; p++)
+	{
+		if (g_ascii_isalpha(*p))
+			g_string_append_printf(pattern, "[%c%c]", g_ascii_tolower(*p), g_ascii_toupper(*p));
+		else if (g_ascii_isalnum(*p))
+			g_string_append_c(pattern, *p);
+		else
+			g_string_append_printf(pattern, "\\%c", *p);
+	}
+	g_string_append(pattern, ":.*");
+	return g_string_free(pattern, FALSE);
+}
+
+
+/** \brief Read the patterns of the installed applications and compile them */
+static ClpAppMgrClassifier*
+classify_build(guint generation)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	ClpAppMgrClassifier *classifier = g_new0(ClpAppMgrClassifier, 1);
+	GPtrArray *declared = g_ptr_array_new();
+	GHashTable *schemes = g_hash_table_new(g_direct_hash, g_direct_equal);
+	ClassifyNfa nfa;
+	ClpAppMgrDesktopDb *db;
+	GHashTableIter iter;
+	gpointer scheme;
+	guint i;
+
+	classifier->ref_count = 1;
+	classifier->generation = generation;
+	classifier->results = g_ptr_array_new();
+
+	if ((db = clp_app_mgr_desktop_db_get()) != NULL)
+	{
+		for (i = 0; i < clp_app_mgr_desktop_db_get_n_apps(db); i++)
+			classify_collect(clp_app_mgr_desktop_db_get_value(db, i, "MimeType"),
+				clp_app_mgr_desktop_db_get_value(db, i, CLP_APP_MGR_CLASSIFY_PATTERNS_KEY), declared, schemes);
+		clp_app_mgr_desktop_db_unref(db);
+	}
+	else
+	{
+		GDir *dir = g_dir_open(APPLICATION_INFO_PATH, 0, NULL);
+		const gchar *file_name;
+		const gchar *keys[] = { "MimeType", CLP_APP_MGR_CLASSIFY_PATTERNS_KEY, NULL };
+
+		while (dir && (file_name = g_dir_read_name(dir)))
+		{
+			gchar *path, *values[2];
+
+			if (!g_str_has_suffix(file_name, ".desktop"))
+				continue;
+			path = g_strconcat(APPLICATION_INFO_PATH, file_name, NULL);
+			if (clp_app_mgr_keyfile_get_start_values(path, keys, values))
+			{
+				classify_collect(values[0], values[1], declared, schemes);
+				g_free(values[0]);
+				g_free(values[1]);
+			}
+			g_free(path);
+		}
+		if (dir)
+			g_dir_close(dir);
+	}
+
+	nfa.states = g_array_new(FALSE, FALSE, sizeof(ClassifyNfaState));
+	nfa.sets = g_array_new(FALSE, FALSE, sizeof(ClassifySet));
+	nfa.starts = g_array_new(FALSE, FALSE, sizeof(gint));
+	for (i = 0; i < declared->len; i += 2)
+	{
+		if (classify_nfa_add(&nfa, declared->pdata[i], classifier->results->len))
+			g_ptr_array_add(classifier->results, declared->pdata[i + 1]);
+		g_free(declared->pdata[i]);
+	}
+	g_hash_table_iter_init(&iter, schemes);
+	while (g_hash_table_iter_next(&iter, &scheme, NULL))
+	{
+		gchar *pattern = classify_scheme_pattern(scheme);
+		if (classify_nfa_add(&nfa, pattern, classifier->results->len))
+			g_ptr_array_add(classifier->results, scheme);
+		g_free(pattern);
+	}
+
+	if (classifier->results->len > 0 && classify_build_dfa(classifier, &nfa))
+		CLP_APPMGR_INFO_V("%u string patterns compiled into %u states over %u byte classes",
+			classifier->results->len, classifier->n_states, classifier->n_classes);
+
+	g_array_free(nfa.states, TRUE);
+	g_array_free(nfa.sets, TRUE);
+	g_array_free(nfa.starts, TRUE);
+	g_ptr_array_free(declared, TRUE);
+	g_hash_table_destroy(schemes);
+	CLP_APPMGR_EXIT_FUNCTION();
+	return classifier;
+}
+
+
+/** \brief Release a reference on a classifier */
+static void
+classify_unref(ClpAppMgrClassifier *classifier)
+{
+	if (classifier == NULL || !g_atomic_int_dec_and_test(&classifier->ref_count))
+		return;
+	g_free(classifier->trans);
+	g_free(classifier->accept);
+	g_ptr_array_free(classifier->results, TRUE);
+	g_free(classifier);
+}
+
+
+/** \brief Get the MIME type of a string from the patterns declared by the handlers
+ *
+ * \param text The string
+ *
+ * \return Interned MIME type, NULL if no pattern matches the whole string
+ */
+const gchar*
+clp_app_mgr_classify_string(const gchar *text)
+{
+	ClpAppMgrClassifier *classifier, *stale = NULL;
+	guint generation = clp_app_mgr_monitor_get_generation(CLP_APP_MGR_MONITOR_DESKTOP);
+	const gchar *result = NULL;
+	const guchar *p;
+	guint state;
+
+	G_LOCK(current_classifier);
+	if (current_classifier == NULL || current_classifier->generation != generation)
+	{
+		stale = current_classifier;
+		current_classifier = classify_build(generation);
+	}
+	classifier = current_classifier;
+	g_atomic_int_inc(&classifier->ref_count);
+	G_UNLOCK(current_classifier);
+	classify_unref(stale);
+
+	if (classifier->n_states > 0)
+	{
+		state = CLASSIFY_START;
+		for (p = (const guchar *) text; *p && state != CLASSIFY_DEAD; p++)
+			state = classifier->trans[state * classifier->n_classes + classifier->class_of[*p]];
+		if (classifier->accept[state] >= 0)
+			result = classifier->results->pdata[classifier->accept[state]];
+	}
+	classify_unref(classifier);
+	return result;
+}
@@ -0,0 +1,30 @@
+/** \file clp-app-mgr-classify.h
+ * \brief String classifier of the Application Manager Library
+ *
+ * Handlers declare the strings they take in their desktop files, and clp_app_mgr_handle_string() uses the
+ * declarations to find the MIME type of a string such as a phone number, an e-mail address or a URL:
+ *
+ * - every "x-scheme-handler/<scheme>" of the MimeType key matches the strings starting with "<scheme>:", the
+ *   scheme compared without case;
+ * - the X-StringPatterns key lists "<mime type>:<regular expression>" entries, separated by ';' like any
+ *   desktop file list. The expression must match the whole string. It supports literals, '.', bracket classes
+ *   with ranges and negation, the \\d \\w \\s \\D \\W \\S classes, grouping, '|', '*', '+' and '?'. A backslash
+ *   is written "\\\\" in a desktop file, but a single one before any other character is kept as is.
+ *
+ * All the patterns are compiled at load time into a single DFA over byte classes, so classifying a string is one
+ * table lookup per byte. The patterns declared with X-StringPatterns come first and, among them, the first one
+ * matching wins. The DFA is rebuilt when the desktop files change.
+ * This header is internal to the library, it is not installed.
+ */
+
+#ifndef __CLP_APP_MGR_CLASSIFY_H__
+#define __CLP_APP_MGR_CLASSIFY_H__
+
+#include <glib.h>
+
+#define CLP_APP_MGR_CLASSIFY_PATTERNS_KEY	"X-StringPatterns"	/**< desktop file key of the string patterns */
+#define CLP_APP_MGR_CLASSIFY_MAX_STATES		4096			/**< largest DFA built, beyond it no string is classified */
+
+const gchar* clp_app_mgr_classify_string (const gchar *text);
+
+#endif /*__CLP_APP_MGR_CLASSIFY_H__ */
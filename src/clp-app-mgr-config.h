@@ -11,6 +11,7 @@
 
 #define CLP_APP_MGR_DAEMON_NAME			"ClpAppMgrDaemon"
 #define GCONF_APPS_DIR				"/appmgr"
+#define LIMO_APPS_DIR				"/LiMo/System/AppInfo"
 #define LIBSEGFAULT                             "/usr/lib/libSegFault.so"
 #define JVM					"runMidlet"
 #define CLP_APP_PATH				"CLP_APP_PATH"
@@ -59,6 +60,7 @@
 #define CLP_APP_MGR_DBUS_SIGNAL_FOCUS_LOST		"FocusLost"		/**< 'FocusLost' dbus signal */
 #define CLP_APP_MGR_DBUS_SIGNAL_FOCUS_GAINED		"FocusGained"		/**< 'FocusGained' dbus signal */
 #define CLP_APP_MGR_DBUS_SIGNAL_MESSAGE			"Message"		/**< 'Message' dbus signal */
+#define CLP_APP_MGR_DBUS_SIGNAL_VISIBILITY		"VisibilityChanged"	/**< 'VisibilityChanged' dbus signal */
 
 #define CLP_APP_MGR_APP_INIT_METHOD             	"AppInit"              	/**< AppInit Method exported by Application Manager Daemon*/
 #define CLP_APP_MGR_APP_EXEC_METHOD             	"AppExec"              	/**< AppExec Method exported by Application Manager Daemon*/
@@ -0,0 +1,239 @@
+/** \file clp-app-mgr-counters.c
+ *
+ * \brief Locally maintained instance counters of the running applications
+ *
+ * Implementation of the counters described in clp-app-mgr-counters.h. A reconciliation walks the running
+ * instances once and records the pid of each, so a later AppExit signal can decrement the right counter. An
+ * exit of an unknown pid, such as an instance launched since the last reconciliation, invalidates the counters.
+ * The walk costs one call per application and per instance, so it is never made on behalf of a query: it runs
+ * from a low priority idle callback, outside the lock, and its result is dropped if the counters changed meanwhile.
+ */
+
+#include <time.h>
+#include <sys/types.h>
+#include <glib.h>
+#include <app-manager.h>
+#include "clp-app-mgr-config.h"
+#include "clp-app-mgr-counters.h"
+
+static struct
+{
+	gboolean	valid;					/**< FALSE until the next reconciliation */
+	gint64		reconciled_at;				/**< monotonic time of the last reconciliation, in milliseconds */
+	guint		epoch;					/**< bumped by every update, a reconciliation started before is dropped */
+	guint		reconcile_idle;				/**< idle source of the pending reconciliation, 0 if none */
+	GHashTable	*instances;				/**< application id to number of running instances */
+	GHashTable	*pids;					/**< pid of a running instance to its application id */
+}counters = { FALSE, 0, 0, 0, NULL, NULL };
+G_LOCK_DEFINE_STATIC (counters);
+
+
+/** \brief Current monotonic time in milliseconds */
+static gint64
+counters_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (gint64) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+
+/** \brief Add to the counter of an application
+ *
+ * \param instances Table of application id to number of instances
+ * \param app_id Application id
+ * \param delta Number of instances added, negative if removed
+ */
+static void
+counters_add(GHashTable *instances, gint app_id, gint delta)
+{
+	gint count = GPOINTER_TO_INT(g_hash_table_lookup(instances, GINT_TO_POINTER(app_id))) + delta;
+
+	if (count > 0)
+		g_hash_table_insert(instances, GINT_TO_POINTER(app_id), GINT_TO_POINTER(count));
+	else
+		g_hash_table_remove(instances, GINT_TO_POINTER(app_id));
+}
+
+
+/** \brief Rebuild the counters from the application manager
+ *
+ * Idle callback. The application manager is walked without the lock held, the counters are replaced only if
+ * nothing updated them in the meantime.
+ */
+static gboolean
+counters_reconcile(gpointer data)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	GHashTable *instances = g_hash_table_new(g_direct_hash, g_direct_equal);
+	GHashTable *pids = g_hash_table_new(g_direct_hash, g_direct_equal);
+	gint *apps = NULL;
+	gint num_of_active_apps = 0, i, j;
+	gint return_code;
+	gint64 now = counters_now();
+	guint epoch;
+
+	G_LOCK(counters);
+	counters.reconcile_idle = 0;
+	epoch = counters.epoch;
+	G_UNLOCK(counters);
+
+	return_code = AppMgrAppGetRunningApps(&apps, &num_of_active_apps);
+	if (return_code)
+	{
+		CLP_APPMGR_WARN_V("Unable to get Running Apps !! Error Code %d", return_code);
+		goto out;
+	}
+	for (i = 0; i < num_of_active_apps; i++)
+	{
+		gint *instid = NULL, no_of_active_inst = 0;
+
+		return_code = AppMgrAppGetRunningInstances(apps[i], &instid, &no_of_active_inst);
+		if (return_code)
+		{
+			CLP_APPMGR_WARN_V("Unable to get Running Instance of App %d ! Error Code - %d", apps[i], return_code);
+			goto out;
+		}
+		for (j = 0; j < no_of_active_inst; j++)
+		{
+			gint appid;
+			pid_t pid;
+
+			if (AppMgrAppGetInstInfo(instid[j], &appid, &pid) == 0)
+				g_hash_table_insert(pids, GINT_TO_POINTER(pid), GINT_TO_POINTER(apps[i]));
+		}
+		counters_add(instances, apps[i], no_of_active_inst);
+	}
+
+	G_LOCK(counters);
+	if (counters.epoch == epoch)
+	{
+		GHashTable *old_instances = counters.instances, *old_pids = counters.pids;
+
+		counters.instances = instances;
+		counters.pids = pids;
+		instances = old_instances;
+		pids = old_pids;
+		counters.valid = TRUE;
+		counters.reconciled_at = now;
+		CLP_APPMGR_INFO_V("Instance counters reconciled, %u applications running", g_hash_table_size(counters.instances));
+	}
+	G_UNLOCK(counters);
+
+out:
+	if (instances)
+		g_hash_table_destroy(instances);
+	if (pids)
+		g_hash_table_destroy(pids);
+	CLP_APPMGR_EXIT_FUNCTION();
+	return FALSE;
+}
+
+
+/** \brief Check that the counters are usable, schedule a reconciliation if not
+ *
+ * \return TRUE if the counters are valid and younger than CLP_APP_MGR_COUNTERS_MAX_AGE. If FALSE the caller
+ * asks the application manager the one question it has.
+ *
+ * Must be called with the counters lock held.
+ */
+static gboolean
+counters_is_fresh_locked(void)
+{
+	if (counters.valid && counters_now() - counters.reconciled_at <= CLP_APP_MGR_COUNTERS_MAX_AGE)
+		return TRUE;
+	if (counters.reconcile_idle == 0)
+		counters.reconcile_idle = g_idle_add_full(G_PRIORITY_LOW, counters_reconcile, NULL, NULL);
+	return FALSE;
+}
+
+
+/** \brief Count a successful launch
+ *
+ * \param app_id Application id of the new instance
+ */
+void
+clp_app_mgr_counters_launched(gint app_id)
+{
+	G_LOCK(counters);
+	counters.epoch++;
+	if (counters.valid)
+		counters_add(counters.instances, app_id, 1);
+	G_UNLOCK(counters);
+}
+
+
+/** \brief Count an AppExit signal
+ *
+ * \param pid Pid of the instance that exited
+ */
+void
+clp_app_mgr_counters_exited(gint pid)
+{
+	gpointer app_id;
+
+	G_LOCK(counters);
+	counters.epoch++;
+	if (counters.valid)
+	{
+		if (g_hash_table_lookup_extended(counters.pids, GINT_TO_POINTER(pid), NULL, &app_id))
+		{
+			g_hash_table_remove(counters.pids, GINT_TO_POINTER(pid));
+			counters_add(counters.instances, GPOINTER_TO_INT(app_id), -1);
+		}
+		else
+			counters.valid = FALSE;
+	}
+	G_UNLOCK(counters);
+}
+
+
+/** \brief Invalidate the counters until the next reconciliation
+ *
+ * Used for the lifecycle signals that do not tell which instance changed.
+ */
+void
+clp_app_mgr_counters_invalidate(void)
+{
+	G_LOCK(counters);
+	counters.epoch++;
+	counters.valid = FALSE;
+	G_UNLOCK(counters);
+}
+
+
+/** \brief Get the number of running instances of an application
+ *
+ * \param app_id Application id
+ *
+ * \return Number of instances, -1 if the counters are not usable yet
+ */
+gint
+clp_app_mgr_counters_get_instances(gint app_id)
+{
+	gint count = -1;
+
+	G_LOCK(counters);
+	if (counters_is_fresh_locked())
+		count = GPOINTER_TO_INT(g_hash_table_lookup(counters.instances, GINT_TO_POINTER(app_id)));
+	G_UNLOCK(counters);
+	return count;
+}
+
+
+/** \brief Get the number of running applications
+ *
+ * \return Number of applications with at least one instance, -1 if the counters are not usable yet
+ */
+gint
+clp_app_mgr_counters_get_apps(void)
+{
+	gint count = -1;
+
+	G_LOCK(counters);
+	if (counters_is_fresh_locked())
+		count = g_hash_table_size(counters.instances);
+	G_UNLOCK(counters);
+	return count;
+}
@@ -0,0 +1,25 @@
+/** \file clp-app-mgr-counters.h
+ * \brief Locally maintained instance counters of the running applications
+ *
+ * The number of running instances of every application is kept in the process. Successful launches and AppExit
+ * signals update the counters as they happen, and the counters are reconciled with the application manager
+ * from the main loop whenever they are older than CLP_APP_MGR_COUNTERS_MAX_AGE, so a count is never staler than
+ * that bound. Until a reconciliation completed the getters report the counters as unusable and the callers ask
+ * the application manager directly, as a process without a main loop always does.
+ * This header is internal to the library, it is not installed.
+ */
+
+#ifndef __CLP_APP_MGR_COUNTERS_H__
+#define __CLP_APP_MGR_COUNTERS_H__
+
+#include <glib.h>
+
+#define CLP_APP_MGR_COUNTERS_MAX_AGE		2000		/**< milliseconds after which the counters are reconciled */
+
+void clp_app_mgr_counters_launched (gint app_id);
+void clp_app_mgr_counters_exited (gint pid);
+void clp_app_mgr_counters_invalidate (void);
+gint clp_app_mgr_counters_get_instances (gint app_id);
+gint clp_app_mgr_counters_get_apps (void);
+
+#endif /*__CLP_APP_MGR_COUNTERS_H__ */
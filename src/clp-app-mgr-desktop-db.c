@@ -0,0 +1,829 @@
+/** \file clp-app-mgr-desktop-db.c
+ *
+ * \brief Compiled desktop entry database for the Application Manager Library
+ *
+ * Compiler and reader for the database described in clp-app-mgr-desktop-db.h.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <glib.h>
+#include "clp-app-mgr-config.h"
+#include "clp-app-mgr-desktop-db.h"
+#include "clp-app-mgr-monitor.h"
+#include "clp-app-mgr-keyfile.h"
+
+#define DESKTOP_SUFFIX				".desktop"
+#define MIME_CACHE_GROUP			"MIME Cache"
+
+struct _ClpAppMgrDesktopDb
+{
+	volatile gint	ref_count;				/**< references held by the library and the callers */
+	GMappedFile	*file;					/**< read only shared mapping of the database */
+	const gchar	*data;					/**< start of the mapping */
+	const ClpAppMgrDesktopDbHeader	*header;		/**< header at the start of the mapping */
+	const ClpAppMgrDesktopDbApp	*apps;			/**< application table */
+	const ClpAppMgrDesktopDbKey	*keys;			/**< key table */
+	const ClpAppMgrDesktopDbMime	*mimes;			/**< mime table */
+	const guint32	*refs;					/**< application references of the mime table */
+	const gchar	*strings;				/**< string pool */
+	GHashTable	**reparsed;				/**< per application, key to value read from a desktop file changed since the compilation, NULL if unchanged */
+};
+
+static ClpAppMgrDesktopDb *current_db = NULL;			/**< database shared by all the lookups of this process */
+static gboolean current_db_checked = FALSE;			/**< TRUE once the database was looked for, even if it was not usable */
+static guint current_db_generation = 0;				/**< desktop generation the database was looked for at */
+static guint compile_idle = 0;					/**< idle source of the pending recompilation, 0 if none */
+G_LOCK_DEFINE_STATIC (current_db);
+
+
+/** \brief Check that a table of the database lies inside the mapping
+ *
+ * \return TRUE if the table is in bounds
+ */
+static gboolean
+desktop_db_table_is_valid(gsize length, guint32 offset, guint32 count, gsize record_size)
+{
+	if (offset > length || offset % sizeof(guint32))
+		return FALSE;
+	return (count <= (length - offset) / record_size);
+}
+
+
+/** \brief Stamp a source file with its current size and modification time
+ *
+ * \param path Path of the file
+ * \param stamp Returns the stamp, the size is CLP_APP_MGR_DESKTOP_DB_NO_FILE if the file does not exist
+ */
+static void
+desktop_db_stamp_file(const gchar *path, ClpAppMgrDesktopDbStamp *stamp)
+{
+	struct stat st;
+
+	memset(stamp, 0, sizeof(*stamp));
+	if (stat(path, &st) != 0)
+	{
+		stamp->size = CLP_APP_MGR_DESKTOP_DB_NO_FILE;
+		return;
+	}
+	/* desktop files never come close to 4 GB, a larger size is clamped and left to the mtime */
+	stamp->size = st.st_size < CLP_APP_MGR_DESKTOP_DB_NO_FILE ? (guint32) st.st_size : CLP_APP_MGR_DESKTOP_DB_NO_FILE - 1;
+	stamp->mtime = (guint32) st.st_mtim.tv_sec;
+	stamp->mtime_nsec = (guint32) st.st_mtim.tv_nsec;
+}
+
+
+/** \brief Check a source file against its stamp */
+static gboolean
+desktop_db_stamp_matches(const gchar *path, const ClpAppMgrDesktopDbStamp *stamp)
+{
+	ClpAppMgrDesktopDbStamp current;
+
+	desktop_db_stamp_file(path, &current);
+	return current.size == stamp->size && current.mtime == stamp->mtime && current.mtime_nsec == stamp->mtime_nsec;
+}
+
+
+/** \brief Read the start group of a desktop file changed since the database was compiled
+ *
+ * \param path Path of the desktop file
+ *
+ * \return Table of key to raw value, empty if the file cannot be read
+ */
+static GHashTable*
+desktop_db_reparse(const gchar *path)
+{
+	GHashTable *values = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+	GMappedFile *file = g_mapped_file_new(path, FALSE, NULL);
+	ClpAppMgrKeyFileReader reader;
+	ClpAppMgrKeyFileEntry entry;
+
+	if (file == NULL)
+		return values;
+	clp_app_mgr_keyfile_reader_init(&reader, g_mapped_file_get_contents(file), g_mapped_file_get_length(file));
+	while (clp_app_mgr_keyfile_reader_next(&reader, &entry) && entry.group_index == 0)
+		g_hash_table_replace(values, g_strndup(entry.key, entry.key_len), g_strndup(entry.value, entry.value_len));
+	g_mapped_file_free(file);
+	return values;
+}
+
+
+/** \brief Check the sources of the database and reread the desktop files changed since it was compiled
+ *
+ * \param db The database
+ *
+ * \return TRUE if the directory has the same desktop files as the database and mimeinfo.cache did not change.
+ * The desktop files whose size or modification time changed are read again, their applications are answered
+ * from them and the others from the database.
+ *
+ * Costs one stat() per desktop file, once per desktop generation.
+ */
+static gboolean
+desktop_db_check_sources(ClpAppMgrDesktopDb *db)
+{
+	GDir *dir = g_dir_open(APPLICATION_INFO_PATH, 0, NULL);
+	const gchar *file_name;
+	gboolean current;
+	guint n_files = 0, n_reparsed = 0;
+
+	if (dir == NULL)
+		return FALSE;
+	current = desktop_db_stamp_matches(APPLICATION_INFO_PATH "mimeinfo.cache", &db->header->mime_cache_stamp);
+	while (current && (file_name = g_dir_read_name(dir)))
+	{
+		gchar *name, *path;
+		gint app;
+
+		if (!g_str_has_suffix(file_name, DESKTOP_SUFFIX))
+			continue;
+		n_files++;
+		name = g_strndup(file_name, strlen(file_name) - strlen(DESKTOP_SUFFIX));
+		app = clp_app_mgr_desktop_db_find_app(db, name);
+		path = g_strconcat(APPLICATION_INFO_PATH, file_name, NULL);
+		/* an added desktop file has no place in the sorted tables, the database is compiled again for it */
+		current = app >= 0;
+		if (current && !desktop_db_stamp_matches(path, &db->apps[app].stamp))
+		{
+			if (db->reparsed == NULL)
+				db->reparsed = g_new0(GHashTable *, db->header->n_apps);
+			db->reparsed[app] = desktop_db_reparse(path);
+			n_reparsed++;
+		}
+		g_free(path);
+		g_free(name);
+	}
+	g_dir_close(dir);
+	if (current && n_reparsed)
+		CLP_APPMGR_INFO_V("%u desktop files changed since the desktop database was compiled, they are read again", n_reparsed);
+	return current && n_files == db->header->n_apps;
+}
+
+
+/** \brief Map and validate the database file
+ *
+ * \param path Path of the database
+ *
+ * \return New database with one reference, NULL if it does not exist, is corrupted, or desktop files were added
+ * or removed or mimeinfo.cache changed since it was compiled.
+ */
+static ClpAppMgrDesktopDb*
+desktop_db_open(const gchar *path)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	struct stat db_stat;
+	GError *error = NULL;
+	GMappedFile *file;
+	const ClpAppMgrDesktopDbHeader *header;
+	gsize length;
+
+	if (stat(path, &db_stat) != 0)
+	{
+		CLP_APPMGR_INFO_V("No desktop database at %s, desktop files will be parsed", path);
+		CLP_APPMGR_EXIT_FUNCTION();
+		return NULL;
+	}
+	file = g_mapped_file_new(path, FALSE, &error);
+	if (file == NULL)
+	{
+		CLP_APPMGR_WARN_V("Unable to map desktop database %s : %s", path, error->message);
+		g_error_free(error);
+		CLP_APPMGR_EXIT_FUNCTION();
+		return NULL;
+	}
+
+	length = g_mapped_file_get_length(file);
+	header = (const ClpAppMgrDesktopDbHeader *) g_mapped_file_get_contents(file);
+	if (length < sizeof(ClpAppMgrDesktopDbHeader)
+	    || header->magic != CLP_APP_MGR_DESKTOP_DB_MAGIC
+	    || header->version != CLP_APP_MGR_DESKTOP_DB_VERSION
+	    || !desktop_db_table_is_valid(length, header->apps_offset, header->n_apps, sizeof(ClpAppMgrDesktopDbApp))
+	    || !desktop_db_table_is_valid(length, header->keys_offset, header->n_keys, sizeof(ClpAppMgrDesktopDbKey))
+	    || !desktop_db_table_is_valid(length, header->mimes_offset, header->n_mimes, sizeof(ClpAppMgrDesktopDbMime))
+	    || !desktop_db_table_is_valid(length, header->refs_offset, header->n_refs, sizeof(guint32))
+	    || header->strings_offset > length || header->strings_size > length - header->strings_offset
+	    || header->strings_size == 0 || ((const gchar *) header)[header->strings_offset + header->strings_size - 1] != '\0')
+	{
+		CLP_APPMGR_WARN_V("Desktop database %s is corrupted or has an unknown version", path);
+		g_mapped_file_free(file);
+		CLP_APPMGR_EXIT_FUNCTION();
+		return NULL;
+	}
+
+	ClpAppMgrDesktopDb *db = g_new0(ClpAppMgrDesktopDb, 1);
+	db->ref_count = 1;
+	db->file = file;
+	db->data = (const gchar *) header;
+	db->header = header;
+	db->apps = (const ClpAppMgrDesktopDbApp *) (db->data + header->apps_offset);
+	db->keys = (const ClpAppMgrDesktopDbKey *) (db->data + header->keys_offset);
+	db->mimes = (const ClpAppMgrDesktopDbMime *) (db->data + header->mimes_offset);
+	db->refs = (const guint32 *) (db->data + header->refs_offset);
+	db->strings = db->data + header->strings_offset;
+
+	if (!desktop_db_check_sources(db))
+	{
+		CLP_APPMGR_WARN_V("Desktop files were added or removed or mimeinfo.cache changed since %s was compiled, ignoring it", path);
+		clp_app_mgr_desktop_db_unref(db);
+		CLP_APPMGR_EXIT_FUNCTION();
+		return NULL;
+	}
+
+	CLP_APPMGR_INFO_V("Mapped desktop database %s : %u apps, %u mime types", path, header->n_apps, header->n_mimes);
+	CLP_APPMGR_EXIT_FUNCTION();
+	return db;
+}
+
+
+/** \brief Get the desktop database of the process
+ *
+ * \return A reference to the database, to be released with clp_app_mgr_desktop_db_unref(). NULL if there is no usable database,
+ * in which case the caller falls back to parsing the desktop files.
+ *
+ * The database is mapped on first use and shared by all the callers. It is looked for again once the desktop
+ * generation moved, i.e. after the database or a desktop file changed.
+ */
+ClpAppMgrDesktopDb*
+clp_app_mgr_desktop_db_get(void)
+{
+	ClpAppMgrDesktopDb *db, *stale = NULL;
+	guint generation = clp_app_mgr_monitor_get_generation(CLP_APP_MGR_MONITOR_DESKTOP);
+
+	G_LOCK(current_db);
+	if (!current_db_checked || current_db_generation != generation)
+	{
+		stale = current_db;
+		current_db = desktop_db_open(APPLICATION_INFO_PATH CLP_APP_MGR_DESKTOP_DB_NAME);
+		current_db_checked = TRUE;
+		current_db_generation = generation;
+	}
+	db = current_db;
+	if (db)
+		g_atomic_int_inc(&db->ref_count);
+	G_UNLOCK(current_db);
+
+	clp_app_mgr_desktop_db_unref(stale);
+	return db;
+}
+
+
+/** \brief Release a reference on the database
+ *
+ * \param db Database returned by clp_app_mgr_desktop_db_get()
+ */
+void
+clp_app_mgr_desktop_db_unref(ClpAppMgrDesktopDb *db)
+{
+	if (db == NULL)
+		return;
+	if (g_atomic_int_dec_and_test(&db->ref_count))
+	{
+		guint i;
+
+		for (i = 0; db->reparsed && i < db->header->n_apps; i++)
+			if (db->reparsed[i])
+				g_hash_table_destroy(db->reparsed[i]);
+		g_free(db->reparsed);
+		g_mapped_file_free(db->file);
+		g_free(db);
+	}
+}
+
+
+static inline const gchar*
+desktop_db_string(ClpAppMgrDesktopDb *db, guint32 offset)
+{
+	return (offset < db->header->strings_size) ? db->strings + offset : NULL;
+}
+
+
+/** \brief Number of applications in the database */
+guint
+clp_app_mgr_desktop_db_get_n_apps(ClpAppMgrDesktopDb *db)
+{
+	return db->header->n_apps;
+}
+
+
+/** \brief Find an application in the database
+ *
+ * \param db The database
+ * \param application Application name, i.e. the desktop file name without the .desktop suffix
+ *
+ * \return Index of the application, -1 if it has no desktop file.
+ */
+gint
+clp_app_mgr_desktop_db_find_app(ClpAppMgrDesktopDb *db, const gchar *application)
+{
+	guint low = 0, high = db->header->n_apps;
+
+	while (low < high)
+	{
+		guint mid = (low + high) / 2;
+		const gchar *name = desktop_db_string(db, db->apps[mid].name);
+		gint cmp = strcmp(application, name ? name : "");
+
+		if (cmp == 0)
+			return mid;
+		if (cmp < 0)
+			high = mid;
+		else
+			low = mid + 1;
+	}
+	return -1;
+}
+
+
+/** \brief Name of the application at the given index */
+const gchar*
+clp_app_mgr_desktop_db_get_app_name(ClpAppMgrDesktopDb *db, gint app)
+{
+	if (app < 0 || (guint) app >= db->header->n_apps)
+		return NULL;
+	return desktop_db_string(db, db->apps[app].name);
+}
+
+
+/** \brief Get the raw value of a key of the start group of an application
+ *
+ * \param db The database
+ * \param app Index returned by clp_app_mgr_desktop_db_find_app()
+ * \param key Key name, case sensitive
+ *
+ * \return Pointer into the mapping, or into the values read again if the desktop file changed since the
+ * compilation, valid as long as the reference on db is held. NULL if the key is not set.
+ */
+const gchar*
+clp_app_mgr_desktop_db_get_value(ClpAppMgrDesktopDb *db, gint app, const gchar *key)
+{
+	const ClpAppMgrDesktopDbApp *entry;
+	guint low, high;
+
+	if (app < 0 || (guint) app >= db->header->n_apps)
+		return NULL;
+	if (db->reparsed && db->reparsed[app])
+		return g_hash_table_lookup(db->reparsed[app], key);
+	entry = &db->apps[app];
+	if (entry->first_key > db->header->n_keys || entry->n_keys > db->header->n_keys - entry->first_key)
+		return NULL;
+
+	low = entry->first_key;
+	high = entry->first_key + entry->n_keys;
+	while (low < high)
+	{
+		guint mid = (low + high) / 2;
+		const gchar *name = desktop_db_string(db, db->keys[mid].key);
+		gint cmp = strcmp(key, name ? name : "");
+
+		if (cmp == 0)
+			return desktop_db_string(db, db->keys[mid].value);
+		if (cmp < 0)
+			high = mid;
+		else
+			low = mid + 1;
+	}
+	return NULL;
+}
+
+
+/** \brief Get the handlers of a mime type
+ *
+ * \param db The database
+ * \param mime_type The mime type, compared case insensitively as mimeinfo.cache lookups always were
+ * \param apps Return location for the application indexes, the first one is the default handler
+ *
+ * \return Number of handlers, 0 if the mime type is unknown.
+ */
+guint
+clp_app_mgr_desktop_db_get_handlers(ClpAppMgrDesktopDb *db, const gchar *mime_type, const guint32 **apps)
+{
+	guint low = 0, high = db->header->n_mimes;
+
+	*apps = NULL;
+	while (low < high)
+	{
+		guint mid = (low + high) / 2;
+		const ClpAppMgrDesktopDbMime *mime = &db->mimes[mid];
+		const gchar *name = desktop_db_string(db, mime->mime);
+		/* the table is sorted on the lower case names, so an ascii case insensitive compare keeps the order */
+		gint cmp = g_ascii_strcasecmp(mime_type, name ? name : "");
+
+		if (cmp == 0)
+		{
+			if (mime->first_ref > db->header->n_refs || mime->n_refs > db->header->n_refs - mime->first_ref)
+				return 0;
+			*apps = db->refs + mime->first_ref;
+			return mime->n_refs;
+		}
+		if (cmp < 0)
+			high = mid;
+		else
+			low = mid + 1;
+	}
+	return 0;
+}
+
+
+/* Database compiler */
+
+typedef struct _ClpAppMgrDesktopDbBuilder			/**< State of the compiler */
+{
+	GHashTable	*string_offsets;			/**< interned string -> offset in the pool */
+	GString		*strings;				/**< the string pool */
+	GPtrArray	*app_names;				/**< sorted application names */
+	GArray		*apps;					/**< ClpAppMgrDesktopDbApp records */
+	GArray		*keys;					/**< ClpAppMgrDesktopDbKey records */
+	GArray		*mimes;					/**< ClpAppMgrDesktopDbMime records */
+	GArray		*refs;					/**< application references */
+	ClpAppMgrDesktopDbStamp	mime_cache_stamp;		/**< stamp of mimeinfo.cache */
+}ClpAppMgrDesktopDbBuilder;
+
+
+static guint32
+desktop_db_builder_add_string(ClpAppMgrDesktopDbBuilder *builder, const gchar *str)
+{
+	gpointer offset;
+	guint32 new_offset;
+
+	if (g_hash_table_lookup_extended(builder->string_offsets, str, NULL, &offset))
+		return GPOINTER_TO_UINT(offset);
+
+	new_offset = builder->strings->len;
+	g_string_append_len(builder->strings, str, strlen(str) + 1);
+	g_hash_table_insert(builder->string_offsets, g_strdup(str), GUINT_TO_POINTER(new_offset));
+	return new_offset;
+}
+
+
+static gint
+desktop_db_compare_strings(gconstpointer a, gconstpointer b)
+{
+	return strcmp(*(const gchar **) a, *(const gchar **) b);
+}
+
+
+/** \brief Add a string given by its length to the pool */
+static guint32
+desktop_db_builder_add_string_len(ClpAppMgrDesktopDbBuilder *builder, const gchar *str, gsize len)
+{
+	gchar *copy = g_strndup(str, len);
+	guint32 offset = desktop_db_builder_add_string(builder, copy);
+
+	g_free(copy);
+	return offset;
+}
+
+
+/** \brief Order key file entries by key, then by position in the file */
+static gint
+desktop_db_compare_entries(gconstpointer a, gconstpointer b)
+{
+	const ClpAppMgrKeyFileEntry *entry_a = a, *entry_b = b;
+	gint cmp = memcmp(entry_a->key, entry_b->key, MIN(entry_a->key_len, entry_b->key_len));
+
+	if (cmp == 0)
+		cmp = (entry_a->key_len > entry_b->key_len) - (entry_a->key_len < entry_b->key_len);
+	if (cmp == 0)
+		cmp = (entry_a->key > entry_b->key) - (entry_a->key < entry_b->key);
+	return cmp;
+}
+
+
+/** \brief Read the keys of one group of a key file, sorted by key, keeping the last of a repeated key
+ *
+ * \param file Mapping of the file
+ * \param group Group to read, NULL for the start group
+ *
+ * \return Array of ClpAppMgrKeyFileEntry pointing into the mapping
+ */
+static GArray*
+desktop_db_read_group(GMappedFile *file, const gchar *group)
+{
+	GArray *entries = g_array_new(FALSE, FALSE, sizeof(ClpAppMgrKeyFileEntry));
+	ClpAppMgrKeyFileReader reader;
+	ClpAppMgrKeyFileEntry entry;
+	guint i, n;
+
+	clp_app_mgr_keyfile_reader_init(&reader, g_mapped_file_get_contents(file), g_mapped_file_get_length(file));
+	while (clp_app_mgr_keyfile_reader_next(&reader, &entry))
+	{
+		if (group == NULL && entry.group_index > 0)
+			break;
+		if (group == NULL || clp_app_mgr_keyfile_entry_in_group(&entry, group))
+			g_array_append_val(entries, entry);
+	}
+	g_array_sort(entries, desktop_db_compare_entries);
+
+	for (i = 0, n = 0; i < entries->len; i++)
+	{
+		ClpAppMgrKeyFileEntry *current = &g_array_index(entries, ClpAppMgrKeyFileEntry, i);
+		ClpAppMgrKeyFileEntry *next = &g_array_index(entries, ClpAppMgrKeyFileEntry, i + 1);
+
+		if (i + 1 < entries->len && current->key_len == next->key_len && !memcmp(current->key, next->key, current->key_len))
+			continue;
+		g_array_index(entries, ClpAppMgrKeyFileEntry, n++) = *current;
+	}
+	g_array_set_size(entries, n);
+	return entries;
+}
+
+
+/** \brief Add the start group of one desktop file to the database */
+static void
+desktop_db_builder_add_app(ClpAppMgrDesktopDbBuilder *builder, const gchar *directory, const gchar *app_name)
+{
+	GError *error = NULL;
+	gchar *path = g_strconcat(directory, "/", app_name, DESKTOP_SUFFIX, NULL);
+	GMappedFile *file;
+	ClpAppMgrDesktopDbApp app;
+	GArray *entries;
+	guint i;
+
+	app.name = desktop_db_builder_add_string(builder, app_name);
+	app.first_key = builder->keys->len;
+	app.n_keys = 0;
+	/* stamped before reading, a change made while reading leaves a stamp that no longer matches */
+	desktop_db_stamp_file(path, &app.stamp);
+	file = g_mapped_file_new(path, FALSE, &error);
+
+	if (file == NULL)
+	{
+		CLP_APPMGR_WARN_V("Unable to read %s : %s", path, error->message);
+		g_error_free(error);
+		g_array_append_val(builder->apps, app);
+		g_free(path);
+		return;
+	}
+
+	entries = desktop_db_read_group(file, NULL);
+	for (i = 0; i < entries->len; i++)
+	{
+		const ClpAppMgrKeyFileEntry *entry = &g_array_index(entries, ClpAppMgrKeyFileEntry, i);
+		ClpAppMgrDesktopDbKey key;
+
+		key.key = desktop_db_builder_add_string_len(builder, entry->key, entry->key_len);
+		key.value = desktop_db_builder_add_string_len(builder, entry->value, entry->value_len);
+		g_array_append_val(builder->keys, key);
+		app.n_keys++;
+	}
+	g_array_append_val(builder->apps, app);
+
+	g_array_free(entries, TRUE);
+	g_mapped_file_free(file);
+	g_free(path);
+}
+
+
+typedef struct _ClpAppMgrDesktopDbMimeLine			/**< One line of mimeinfo.cache while compiling */
+{
+	gchar		*mime;					/**< mime type in lower case */
+	const ClpAppMgrKeyFileEntry	*entry;			/**< the line */
+}ClpAppMgrDesktopDbMimeLine;
+
+
+/** \brief Order mimeinfo.cache lines by lower case mime type, then by position in the file */
+static gint
+desktop_db_compare_mime_lines(gconstpointer a, gconstpointer b)
+{
+	const ClpAppMgrDesktopDbMimeLine *line_a = a, *line_b = b;
+	gint cmp = strcmp(line_a->mime, line_b->mime);
+
+	if (cmp == 0)
+		cmp = (line_a->entry->key > line_b->entry->key) - (line_a->entry->key < line_b->entry->key);
+	return cmp;
+}
+
+
+/** \brief Add the mime type -> handlers table of mimeinfo.cache to the database
+ *
+ * Of the lines of a mime type, differing by case or not, the last one is kept as GKeyFile does.
+ */
+static void
+desktop_db_builder_add_mime_cache(ClpAppMgrDesktopDbBuilder *builder, const gchar *directory)
+{
+	GError *error = NULL;
+	gchar *path = g_strconcat(directory, "/mimeinfo.cache", NULL);
+	GMappedFile *file;
+	GArray *entries, *lines;
+	guint i;
+
+	desktop_db_stamp_file(path, &builder->mime_cache_stamp);
+	file = g_mapped_file_new(path, FALSE, &error);
+
+	if (file == NULL)
+	{
+		CLP_APPMGR_WARN_V("Unable to read %s : %s", path, error->message);
+		g_error_free(error);
+		g_free(path);
+		return;
+	}
+
+	entries = desktop_db_read_group(file, MIME_CACHE_GROUP);
+	lines = g_array_sized_new(FALSE, FALSE, sizeof(ClpAppMgrDesktopDbMimeLine), entries->len);
+	for (i = 0; i < entries->len; i++)
+	{
+		ClpAppMgrDesktopDbMimeLine line;
+
+		line.entry = &g_array_index(entries, ClpAppMgrKeyFileEntry, i);
+		line.mime = g_ascii_strdown(line.entry->key, line.entry->key_len);
+		g_array_append_val(lines, line);
+	}
+	g_array_sort(lines, desktop_db_compare_mime_lines);
+
+	for (i = 0; i < lines->len; i++)
+	{
+		const ClpAppMgrDesktopDbMimeLine *line = &g_array_index(lines, ClpAppMgrDesktopDbMimeLine, i);
+		ClpAppMgrDesktopDbMime mime;
+		gchar *value, **handlers;
+		gint j;
+
+		if (i + 1 < lines->len && !strcmp(line->mime, g_array_index(lines, ClpAppMgrDesktopDbMimeLine, i + 1).mime))
+			continue;
+
+		mime.mime = desktop_db_builder_add_string(builder, line->mime);
+		mime.first_ref = builder->refs->len;
+		mime.n_refs = 0;
+
+		value = g_strndup(line->entry->value, line->entry->value_len);
+		handlers = g_strsplit(value, ";", -1);
+		for (j = 0; handlers[j]; j++)
+		{
+			gchar *name = handlers[j];
+			gchar **found;
+			guint32 ref;
+
+			if (g_str_has_suffix(name, DESKTOP_SUFFIX))
+				name[strlen(name) - strlen(DESKTOP_SUFFIX)] = '\0';
+			if (*name == '\0')
+				continue;
+			found = bsearch(&name, builder->app_names->pdata, builder->app_names->len, sizeof(gchar *), desktop_db_compare_strings);
+			if (found == NULL)
+			{
+				CLP_APPMGR_WARN_V("%s handles %s but has no desktop file", name, line->mime);
+				continue;
+			}
+			ref = found - (gchar **) builder->app_names->pdata;
+			g_array_append_val(builder->refs, ref);
+			mime.n_refs++;
+		}
+		g_strfreev(handlers);
+		g_free(value);
+
+		if (mime.n_refs)
+			g_array_append_val(builder->mimes, mime);
+	}
+
+	for (i = 0; i < lines->len; i++)
+		g_free(g_array_index(lines, ClpAppMgrDesktopDbMimeLine, i).mime);
+	g_array_free(lines, TRUE);
+	g_array_free(entries, TRUE);
+	g_mapped_file_free(file);
+	g_free(path);
+}
+
+
+/** \brief Compile the desktop files and mimeinfo.cache into a database
+ *
+ * \param directory Directory containing the desktop files. NULL for APPLICATION_INFO_PATH.
+ * \param output Path of the database to write. NULL for the default location read by the library.
+ * \param error Return location for a file error
+ *
+ * \return TRUE if the database was written
+ *
+ * Meant to be run at install time, after the desktop files and mimeinfo.cache have been updated.
+ * The database is replaced atomically. It records the size and modification time of every source file, so the
+ * library rereads a desktop file rewritten since, and ignores the database as soon as a desktop file is added or
+ * removed or mimeinfo.cache changes.
+ */
+gboolean
+clp_app_mgr_desktop_db_compile(const gchar *directory, const gchar *output, GError **error)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	ClpAppMgrDesktopDbBuilder builder;
+	ClpAppMgrDesktopDbHeader header;
+	GDir *dir;
+	const gchar *file_name;
+	gchar *default_output = NULL;
+	GString *data;
+	gboolean res;
+	guint i;
+
+	if (directory == NULL)
+		directory = APPLICATION_INFO_PATH;
+	if (output == NULL)
+		output = default_output = g_strconcat(directory, "/", CLP_APP_MGR_DESKTOP_DB_NAME, NULL);
+
+	dir = g_dir_open(directory, 0, error);
+	if (dir == NULL)
+	{
+		g_free(default_output);
+		CLP_APPMGR_EXIT_FUNCTION();
+		return FALSE;
+	}
+
+	builder.string_offsets = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	builder.strings = g_string_new(NULL);
+	builder.app_names = g_ptr_array_new();
+	builder.apps = g_array_new(FALSE, FALSE, sizeof(ClpAppMgrDesktopDbApp));
+	builder.keys = g_array_new(FALSE, FALSE, sizeof(ClpAppMgrDesktopDbKey));
+	builder.mimes = g_array_new(FALSE, FALSE, sizeof(ClpAppMgrDesktopDbMime));
+	builder.refs = g_array_new(FALSE, FALSE, sizeof(guint32));
+
+	while ((file_name = g_dir_read_name(dir)))
+	{
+		if (g_str_has_suffix(file_name, DESKTOP_SUFFIX))
+			g_ptr_array_add(builder.app_names, g_strndup(file_name, strlen(file_name) - strlen(DESKTOP_SUFFIX)));
+	}
+	g_dir_close(dir);
+	g_ptr_array_sort(builder.app_names, desktop_db_compare_strings);
+
+	for (i = 0; i < builder.app_names->len; i++)
+		desktop_db_builder_add_app(&builder, directory, g_ptr_array_index(builder.app_names, i));
+	desktop_db_builder_add_mime_cache(&builder, directory);
+
+	/* header, tables, then the string pool. Every record is made of guint32 so the tables stay aligned */
+	memset(&header, 0, sizeof(header));
+	header.magic = CLP_APP_MGR_DESKTOP_DB_MAGIC;
+	header.version = CLP_APP_MGR_DESKTOP_DB_VERSION;
+	header.n_apps = builder.apps->len;
+	header.apps_offset = sizeof(header);
+	header.n_keys = builder.keys->len;
+	header.keys_offset = header.apps_offset + header.n_apps * sizeof(ClpAppMgrDesktopDbApp);
+	header.n_mimes = builder.mimes->len;
+	header.mimes_offset = header.keys_offset + header.n_keys * sizeof(ClpAppMgrDesktopDbKey);
+	header.n_refs = builder.refs->len;
+	header.refs_offset = header.mimes_offset + header.n_mimes * sizeof(ClpAppMgrDesktopDbMime);
+	header.strings_offset = header.refs_offset + header.n_refs * sizeof(guint32);
+	if (builder.strings->len == 0)
+		g_string_append_c(builder.strings, '\0');
+	header.strings_size = builder.strings->len;
+	header.mime_cache_stamp = builder.mime_cache_stamp;
+
+	data = g_string_sized_new(header.strings_offset + header.strings_size);
+	g_string_append_len(data, (const gchar *) &header, sizeof(header));
+	g_string_append_len(data, builder.apps->data, header.n_apps * sizeof(ClpAppMgrDesktopDbApp));
+	g_string_append_len(data, builder.keys->data, header.n_keys * sizeof(ClpAppMgrDesktopDbKey));
+	g_string_append_len(data, builder.mimes->data, header.n_mimes * sizeof(ClpAppMgrDesktopDbMime));
+	g_string_append_len(data, builder.refs->data, header.n_refs * sizeof(guint32));
+	g_string_append_len(data, builder.strings->str, header.strings_size);
+
+	res = g_file_set_contents(output, data->str, data->len, error);
+	if (res)
+		CLP_APPMGR_INFO_V("Wrote %s : %u apps, %u keys, %u mime types, %u bytes of strings", output, header.n_apps, header.n_keys, header.n_mimes, header.strings_size);
+
+	g_string_free(data, TRUE);
+	for (i = 0; i < builder.app_names->len; i++)
+		g_free(g_ptr_array_index(builder.app_names, i));
+	g_ptr_array_free(builder.app_names, TRUE);
+	g_array_free(builder.apps, TRUE);
+	g_array_free(builder.keys, TRUE);
+	g_array_free(builder.mimes, TRUE);
+	g_array_free(builder.refs, TRUE);
+	g_string_free(builder.strings, TRUE);
+	g_hash_table_destroy(builder.string_offsets);
+	g_free(default_output);
+
+	CLP_APPMGR_EXIT_FUNCTION();
+	return res;
+}
+
+
+/** \brief Idle callback recompiling the database of the process */
+static gboolean
+desktop_db_compile_cb(gpointer data)
+{
+	GError *error = NULL;
+
+	G_LOCK(current_db);
+	compile_idle = 0;
+	G_UNLOCK(current_db);
+	if (clp_app_mgr_desktop_db_compile(NULL, NULL, &error))
+		clp_app_mgr_monitor_bump(CLP_APP_MGR_MONITOR_DESKTOP);
+	else
+	{
+		CLP_APPMGR_WARN_V("Unable to recompile the desktop database : %s", error ? error->message : "unknown error");
+		if (error)
+			g_error_free(error);
+	}
+	return FALSE;
+}
+
+
+/** \brief Recompile the database after the library rewrote a desktop file
+ *
+ * Until then the rewritten file is read again by every process that maps the database. The compilation runs
+ * from a low priority idle callback, once for any number of rewrites, and only where a database was installed and
+ * this process may replace it.
+ */
+void
+clp_app_mgr_desktop_db_schedule_compile(void)
+{
+	if (access(APPLICATION_INFO_PATH CLP_APP_MGR_DESKTOP_DB_NAME, F_OK) < 0 || access(APPLICATION_INFO_PATH, W_OK) < 0)
+		return;
+	G_LOCK(current_db);
+	if (compile_idle == 0)
+		compile_idle = g_idle_add_full(G_PRIORITY_LOW, desktop_db_compile_cb, NULL, NULL);
+	G_UNLOCK(current_db);
+}
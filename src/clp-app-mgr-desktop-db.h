@@ -0,0 +1,86 @@
+/** \file clp-app-mgr-desktop-db.h
+ * \brief Compiled desktop entry database for the Application Manager Library
+ *
+ * The desktop files under APPLICATION_INFO_PATH and the mimeinfo.cache are compiled once at install time
+ * (see tools/clp-app-mgr-desktop-db-compiler.c) into a single file which every process maps read-only.
+ * The library answers property, service and mime handler lookups directly from the mapping. The size and
+ * modification time, to the nanosecond, of every source file are recorded in the database. A desktop file
+ * changed since, as clp_app_mgr_set_property() does, is read again and answers for its application while the
+ * others are still answered from the mapping. A database whose desktop files were added or removed, or whose
+ * mimeinfo.cache changed, is not used.
+ * This header is internal to the library and the tools, it is not installed.
+ */
+
+#ifndef __CLP_APP_MGR_DESKTOP_DB_H__
+#define __CLP_APP_MGR_DESKTOP_DB_H__
+
+#include <glib.h>
+
+#define CLP_APP_MGR_DESKTOP_DB_NAME		"appmgr-desktop.db"	/**< File name of the database inside the desktop file directory */
+#define CLP_APP_MGR_DESKTOP_DB_MAGIC		0x42444d41		/**< "AMDB" */
+#define CLP_APP_MGR_DESKTOP_DB_VERSION		2			/**< Bumped on every incompatible layout change */
+#define CLP_APP_MGR_DESKTOP_DB_NO_FILE		G_MAXUINT32		/**< Stamp size of a source file that did not exist */
+
+/* On disk layout. All fields are native endian guint32, all offsets are in bytes from the start of the file,
+ * except string references which are offsets into the string pool. Every string is stored once (interned)
+ * and NUL terminated, so the reader hands out pointers into the mapping without copying. */
+typedef struct _ClpAppMgrDesktopDbStamp				/**< Size and modification time of a source file when it was compiled */
+{
+	guint32		size;					/**< Size in bytes, CLP_APP_MGR_DESKTOP_DB_NO_FILE if the file did not exist */
+	guint32		mtime;					/**< Modification time, seconds, truncated to 32 bits */
+	guint32		mtime_nsec;				/**< Modification time, nanoseconds */
+}ClpAppMgrDesktopDbStamp;
+
+typedef struct _ClpAppMgrDesktopDbHeader			/**< Header at offset 0 of the database */
+{
+	guint32		magic;					/**< CLP_APP_MGR_DESKTOP_DB_MAGIC */
+	guint32		version;				/**< CLP_APP_MGR_DESKTOP_DB_VERSION */
+	guint32		n_apps;					/**< Number of ClpAppMgrDesktopDbApp records, sorted by name */
+	guint32		apps_offset;				/**< Offset of the application table */
+	guint32		n_keys;					/**< Number of ClpAppMgrDesktopDbKey records */
+	guint32		keys_offset;				/**< Offset of the key table, grouped per application and sorted by key */
+	guint32		n_mimes;				/**< Number of ClpAppMgrDesktopDbMime records, sorted by lower case mime type */
+	guint32		mimes_offset;				/**< Offset of the mime table */
+	guint32		n_refs;					/**< Number of application references used by the mime table */
+	guint32		refs_offset;				/**< Offset of the application reference table */
+	guint32		strings_offset;				/**< Offset of the string pool */
+	guint32		strings_size;				/**< Size of the string pool in bytes */
+	ClpAppMgrDesktopDbStamp	mime_cache_stamp;		/**< Stamp of mimeinfo.cache */
+}ClpAppMgrDesktopDbHeader;
+
+typedef struct _ClpAppMgrDesktopDbApp				/**< One desktop file */
+{
+	guint32		name;					/**< Application name (desktop file name without .desktop) */
+	guint32		first_key;				/**< Index of the first key of the application in the key table */
+	guint32		n_keys;					/**< Number of keys of the start group */
+	ClpAppMgrDesktopDbStamp	stamp;				/**< Stamp of the desktop file */
+}ClpAppMgrDesktopDbApp;
+
+typedef struct _ClpAppMgrDesktopDbKey				/**< One key of the start group of a desktop file */
+{
+	guint32		key;					/**< Key name */
+	guint32		value;					/**< Raw (unescaped) value, as g_key_file_get_value() returns it */
+}ClpAppMgrDesktopDbKey;
+
+typedef struct _ClpAppMgrDesktopDbMime				/**< One line of mimeinfo.cache */
+{
+	guint32		mime;					/**< Mime type in lower case */
+	guint32		first_ref;				/**< Index of the first application reference */
+	guint32		n_refs;					/**< Number of handlers, the first one is the default handler */
+}ClpAppMgrDesktopDbMime;
+
+typedef struct _ClpAppMgrDesktopDb ClpAppMgrDesktopDb;		/**< Opaque handle for a mapped database */
+
+ClpAppMgrDesktopDb* clp_app_mgr_desktop_db_get (void);
+void clp_app_mgr_desktop_db_unref (ClpAppMgrDesktopDb *db);
+
+guint clp_app_mgr_desktop_db_get_n_apps (ClpAppMgrDesktopDb *db);
+gint clp_app_mgr_desktop_db_find_app (ClpAppMgrDesktopDb *db, const gchar *application);
+const gchar* clp_app_mgr_desktop_db_get_app_name (ClpAppMgrDesktopDb *db, gint app);
+const gchar* clp_app_mgr_desktop_db_get_value (ClpAppMgrDesktopDb *db, gint app, const gchar *key);
+guint clp_app_mgr_desktop_db_get_handlers (ClpAppMgrDesktopDb *db, const gchar *mime_type, const guint32 **apps);
+
+gboolean clp_app_mgr_desktop_db_compile (const gchar *directory, const gchar *output, GError **error);
+void clp_app_mgr_desktop_db_schedule_compile (void);
+
+#endif /*__CLP_APP_MGR_DESKTOP_DB_H__ */
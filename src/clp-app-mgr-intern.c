@@ -0,0 +1,73 @@
+/** \file clp-app-mgr-intern.c
+ *
+ * \brief Interned names derived from an application name
+ *
+ * Implementation of the name table described in clp-app-mgr-intern.h.
+ */
+
+#include <string.h>
+#include <glib.h>
+#include "clp-app-mgr-lib.h"
+#include "clp-app-mgr-config.h"
+#include "clp-app-mgr-intern.h"
+
+static GHashTable *app_names = NULL;				/**< name -> ClpAppMgrAppNames, entries are never removed */
+G_LOCK_DEFINE_STATIC (app_names);
+
+
+/** \brief Intern a string built with g_strconcat() and free the original
+ *
+ * \return The interned copy
+ */
+static const gchar*
+intern_take(gchar *str)
+{
+	const gchar *interned = g_intern_string(str);
+	g_free(str);
+	return interned;
+}
+
+
+/** \brief Get the names derived from an application or instance name
+ *
+ * \param name Application name, or instance name "app:instance"
+ *
+ * \return Names of the application, owned by the library and valid for the life of the process
+ *
+ * The interface and object path of an instance are the ones the instance registered in clp_app_mgr_init():
+ * the instance id is appended to the application name without separator. The registry keys and desktop file
+ * are those of the application. The table only grows with the applications and instances a process talks to.
+ */
+const ClpAppMgrAppNames*
+clp_app_mgr_app_names_get(const gchar *name)
+{
+	ClpAppMgrAppNames *names;
+	const gchar *colon;
+	gchar *app_name;
+
+	G_LOCK(app_names);
+	if (app_names == NULL)
+		app_names = g_hash_table_new(g_str_hash, g_str_equal);
+
+	names = g_hash_table_lookup(app_names, name);
+	if (names == NULL)
+	{
+		names = g_new(ClpAppMgrAppNames, 1);
+		colon = strchr(name, ':');
+		app_name = colon ? g_strndup(name, colon - name) : g_strdup(name);
+
+		names->name = g_intern_string(name);
+		names->app_name = g_intern_string(app_name);
+		names->interface = intern_take(g_strconcat(CLP_APP_MGR_DBUS_INTERFACE, ".", app_name, colon ? colon + 1 : NULL, NULL));
+		names->object_path = intern_take(g_strconcat(CLP_APP_MGR_DBUS_OBJECT, "/", app_name, colon ? colon + 1 : NULL, NULL));
+		names->info_dir = intern_take(g_strconcat(GCONF_APPS_DIR, "/", app_name, "/info", NULL));
+		names->app_id_key = intern_take(g_strconcat(names->info_dir, "/AppID", NULL));
+		names->last_inst_id_key = intern_take(g_strconcat(GCONF_APPS_DIR, "/", app_name, "/LastInstId", NULL));
+		names->desktop_file = intern_take(g_strconcat(APPLICATION_INFO_PATH, app_name, ".desktop", NULL));
+		g_free(app_name);
+
+		g_hash_table_insert(app_names, (gpointer) names->name, names);
+	}
+	G_UNLOCK(app_names);
+	return names;
+}
@@ -0,0 +1,29 @@
+/** \file clp-app-mgr-intern.h
+ * \brief Interned names derived from an application name
+ *
+ * The dbus interface, object path, registry keys and desktop file of an application are built once per
+ * application or instance name and kept for the life of the process. All the strings are interned with
+ * g_intern_string(), so they can be compared by pointer and must never be freed.
+ * This header is internal to the library, it is not installed.
+ */
+
+#ifndef __CLP_APP_MGR_INTERN_H__
+#define __CLP_APP_MGR_INTERN_H__
+
+#include <glib.h>
+
+typedef struct _ClpAppMgrAppNames				/**< Names derived from an application or instance name */
+{
+	const gchar	*name;					/**< name as given, "app" or "app:instance" */
+	const gchar	*app_name;				/**< application part of the name */
+	const gchar	*interface;				/**< dbus interface the application or instance listens on */
+	const gchar	*object_path;				/**< dbus object path of the application or instance */
+	const gchar	*info_dir;				/**< registry directory of the application information */
+	const gchar	*app_id_key;				/**< registry key of the application id */
+	const gchar	*last_inst_id_key;			/**< registry key of the last instance id */
+	const gchar	*desktop_file;				/**< desktop file of the application */
+}ClpAppMgrAppNames;
+
+const ClpAppMgrAppNames* clp_app_mgr_app_names_get (const gchar *name);
+
+#endif /*__CLP_APP_MGR_INTERN_H__ */
@@ -0,0 +1,174 @@
+/** \file clp-app-mgr-keyfile.c
+ *
+ * \brief Streaming key file reader of the Application Manager Library
+ *
+ * Implementation of the reader described in clp-app-mgr-keyfile.h.
+ */
+
+#include <string.h>
+#include <glib.h>
+#include "clp-app-mgr-config.h"
+#include "clp-app-mgr-keyfile.h"
+
+
+/** \brief Start reading a buffer
+ *
+ * \param reader Reader to initialise
+ * \param data The buffer, it must stay valid while the entries are used
+ * \param length Length of the buffer
+ */
+void
+clp_app_mgr_keyfile_reader_init(ClpAppMgrKeyFileReader *reader, const gchar *data, gsize length)
+{
+	reader->p = data;
+	reader->end = data + length;
+	reader->n_groups = 0;
+	reader->group = NULL;
+	reader->group_len = 0;
+}
+
+
+/** \brief Read the next key
+ *
+ * \param reader The reader
+ * \param entry Returns the key
+ *
+ * \return FALSE at the end of the buffer
+ */
+gboolean
+clp_app_mgr_keyfile_reader_next(ClpAppMgrKeyFileReader *reader, ClpAppMgrKeyFileEntry *entry)
+{
+	while (reader->p < reader->end)
+	{
+		const gchar *line = reader->p;
+		const gchar *eol = memchr(line, '\n', reader->end - line);
+		const gchar *equals, *key_end, *value;
+
+		if (eol == NULL)
+			eol = reader->end;
+		reader->p = eol < reader->end ? eol + 1 : eol;
+		if (eol > line && eol[-1] == '\r')
+			eol--;
+
+		while (line < eol && g_ascii_isspace(*line))
+			line++;
+		if (line == eol || *line == '#')
+			continue;
+
+		if (*line == '[')
+		{
+			const gchar *close = eol;
+
+			while (close > line && *close != ']')
+				close--;
+			if (close > line)
+			{
+				reader->group = line + 1;
+				reader->group_len = close - line - 1;
+				reader->n_groups++;
+			}
+			continue;
+		}
+
+		if (reader->group == NULL || (equals = memchr(line, '=', eol - line)) == NULL || equals == line)
+			continue;
+		for (key_end = equals; key_end > line && g_ascii_isspace(key_end[-1]); key_end--)
+			;
+		for (value = equals + 1; value < eol && g_ascii_isspace(*value); value++)
+			;
+
+		entry->group_index = reader->n_groups - 1;
+		entry->group = reader->group;
+		entry->group_len = reader->group_len;
+		entry->key = line;
+		entry->key_len = key_end - line;
+		entry->value = value;
+		entry->value_len = eol - value;
+		return TRUE;
+	}
+	return FALSE;
+}
+
+
+/** \brief Check the key of an entry
+ *
+ * \return TRUE if the key of the entry is key, compared with case
+ */
+gboolean
+clp_app_mgr_keyfile_entry_is(const ClpAppMgrKeyFileEntry *entry, const gchar *key)
+{
+	return strncmp(entry->key, key, entry->key_len) == 0 && key[entry->key_len] == '\0';
+}
+
+
+/** \brief Check the group of an entry
+ *
+ * \return TRUE if the entry belongs to group, compared with case
+ */
+gboolean
+clp_app_mgr_keyfile_entry_in_group(const ClpAppMgrKeyFileEntry *entry, const gchar *group)
+{
+	return strncmp(entry->group, group, entry->group_len) == 0 && group[entry->group_len] == '\0';
+}
+
+
+/** \brief Read every key of a file
+ *
+ * \param path Path of the file
+ * \param func Called for each key, in file order, until it returns FALSE
+ * \param user_data Passed to func
+ *
+ * \return FALSE if the file cannot be read
+ */
+gboolean
+clp_app_mgr_keyfile_parse(const gchar *path, ClpAppMgrKeyFileFunc func, gpointer user_data)
+{
+	GMappedFile *file = g_mapped_file_new(path, FALSE, NULL);
+	ClpAppMgrKeyFileReader reader;
+	ClpAppMgrKeyFileEntry entry;
+
+	if (file == NULL)
+		return FALSE;
+	clp_app_mgr_keyfile_reader_init(&reader, g_mapped_file_get_contents(file), g_mapped_file_get_length(file));
+	while (clp_app_mgr_keyfile_reader_next(&reader, &entry) && func(&entry, user_data))
+		;
+	g_mapped_file_free(file);
+	return TRUE;
+}
+
+
+/** \brief Read some keys of the start group of a file
+ *
+ * \param path Path of the file
+ * \param keys NULL terminated array of keys
+ * \param values Returns the raw value of each key, NULL if the start group does not have it. To be freed with
+ * g_free() one by one.
+ *
+ * \return FALSE if the file cannot be read, values are then all NULL
+ *
+ * Reading stops at the end of the start group.
+ */
+gboolean
+clp_app_mgr_keyfile_get_start_values(const gchar *path, const gchar * const *keys, gchar **values)
+{
+	GMappedFile *file = g_mapped_file_new(path, FALSE, NULL);
+	ClpAppMgrKeyFileReader reader;
+	ClpAppMgrKeyFileEntry entry;
+	guint i;
+
+	for (i = 0; keys[i]; i++)
+		values[i] = NULL;
+	if (file == NULL)
+		return FALSE;
+
+	clp_app_mgr_keyfile_reader_init(&reader, g_mapped_file_get_contents(file), g_mapped_file_get_length(file));
+	while (clp_app_mgr_keyfile_reader_next(&reader, &entry) && entry.group_index == 0)
+		for (i = 0; keys[i]; i++)
+			if (clp_app_mgr_keyfile_entry_is(&entry, keys[i]))
+			{
+				g_free(values[i]);
+				values[i] = g_strndup(entry.value, entry.value_len);
+			}
+	g_mapped_file_free(file);
+	return TRUE;
+}
@@ -0,0 +1,50 @@
+/** \file clp-app-mgr-keyfile.h
+ * \brief Streaming key file reader of the Application Manager Library
+ *
+ * Desktop files and mimeinfo.cache are only read by the library, never kept. The reader walks a mapped file once
+ * and hands out each key as (group, key, value) slices pointing into the mapping, so reading a file allocates
+ * nothing but the mapping. Lines are found with memchr(), which the C library scans a word or a vector at a time.
+ *
+ * The slices follow GKeyFile: comments and blank lines are skipped, the key loses its trailing blanks, the value
+ * its leading blanks and is left raw, as g_key_file_get_value() returns it. A key repeated in a group is handed out
+ * each time, the last one is the one GKeyFile keeps. Unlike GKeyFile, malformed lines are skipped rather than
+ * failing the whole file.
+ * This header is internal to the library and the tools, it is not installed.
+ */
+
+#ifndef __CLP_APP_MGR_KEYFILE_H__
+#define __CLP_APP_MGR_KEYFILE_H__
+
+#include <glib.h>
+
+typedef struct _ClpAppMgrKeyFileEntry				/**< One key of a key file, pointing into the file */
+{
+	guint		group_index;				/**< index of its group in the file, 0 for the start group */
+	const gchar	*group;					/**< name of its group, not NUL terminated */
+	gsize		group_len;				/**< length of the group name */
+	const gchar	*key;					/**< key, not NUL terminated */
+	gsize		key_len;				/**< length of the key */
+	const gchar	*value;					/**< raw value, not NUL terminated */
+	gsize		value_len;				/**< length of the value */
+}ClpAppMgrKeyFileEntry;
+
+typedef struct _ClpAppMgrKeyFileReader				/**< Position of the reader in a buffer */
+{
+	const gchar	*p;					/**< start of the next line */
+	const gchar	*end;					/**< end of the buffer */
+	guint		n_groups;				/**< groups seen so far */
+	const gchar	*group;					/**< name of the current group, NULL before the first one */
+	gsize		group_len;				/**< length of the current group name */
+}ClpAppMgrKeyFileReader;
+
+typedef gboolean (*ClpAppMgrKeyFileFunc) (const ClpAppMgrKeyFileEntry *entry, gpointer user_data);	/**< return FALSE to stop reading */
+
+void clp_app_mgr_keyfile_reader_init (ClpAppMgrKeyFileReader *reader, const gchar *data, gsize length);
+gboolean clp_app_mgr_keyfile_reader_next (ClpAppMgrKeyFileReader *reader, ClpAppMgrKeyFileEntry *entry);
+gboolean clp_app_mgr_keyfile_entry_is (const ClpAppMgrKeyFileEntry *entry, const gchar *key);
+gboolean clp_app_mgr_keyfile_entry_in_group (const ClpAppMgrKeyFileEntry *entry, const gchar *group);
+
+gboolean clp_app_mgr_keyfile_parse (const gchar *path, ClpAppMgrKeyFileFunc func, gpointer user_data);
+gboolean clp_app_mgr_keyfile_get_start_values (const gchar *path, const gchar * const *keys, gchar **values);
+
+#endif /*__CLP_APP_MGR_KEYFILE_H__ */
@@ -57,6 +57,7 @@ typedef void (*app_resume) (void *);				/**< function pointer for resume handler
 typedef void (*app_rotate) (void *, int);			/**< function pointer for rotate handler*/
 typedef void (*app_death) (void *, int);			/**< function pointer for app death handler param is pid of dying app*/
 typedef void (*app_exec) (guint, gchar **);			/**< function pointer for restore handler*/
+typedef void (*app_exec_fd) (guint, gchar **, gint);		/**< function pointer for restore handler taking a file descriptor*/
 typedef void (*app_list_change) (GList *);			/**< function pointer for app list change handler*/
 typedef void (*app_message) (guint, gchar **);			/**< function pointer for app messaged*/
 
@@ -69,7 +70,7 @@ typedef void (*post_init) (void *);    				/**< function pointer for post_init h
 gint clp_app_mgr_init (const gchar *name, const guint priority, const ClpAppMgrInstanceType instance);
 gint clp_app_mgr_async_init (const gchar *name, const guint priority, const ClpAppMgrInstanceType instance,const post_init post_init_handler);
 gint clp_app_mgr_exec (const gchar *application, ...);
-gint clp_app_mgr_exec_application (const gchar *application, const va_list ap);
+gint clp_app_mgr_exec_application (const gchar *application, va_list ap);
 gint clp_app_mgr_exec_argv (const gchar *application, gint no_of_params, gchar** params_list);
 	
 
@@ -81,11 +82,12 @@ gchar* clp_app_mgr_get_instance_name(void);
 
 /* API for registering the handlers */
 void clp_app_mgr_register_exec_handler(const app_exec exec_handler);
+void clp_app_mgr_register_exec_fd_handler(const app_exec_fd exec_fd_handler);
 void clp_app_mgr_register_stop_handler(const app_stop stop_handler);
 void clp_app_mgr_register_death_handler(const app_death death_handler);
 void clp_app_mgr_register_rotate_handler(const app_rotate rotate_handler);
 void clp_app_mgr_register_message_handler(const app_message message_handler);
-//void clp_app_mgr_register_app_list_change_handler (const app_list_change list_change_handler);
+void clp_app_mgr_register_app_list_change_handler (const app_list_change list_change_handler);
 void clp_app_mgr_wm_register_focus_lost_handler(const app_focus_lost focus_lost_handler);
 void clp_app_mgr_wm_register_focus_gained_handler(const app_focus_gained focus_gained_handler);
 
@@ -107,8 +109,13 @@ gint clp_app_mgr_rotate(const ClpAppMgrRotationType rotationtype);
 gchar* clp_app_mgr_mime_from_file(const gchar *filename);
 gchar* clp_app_mgr_mime_from_string(const gchar *data);
 GSList* clp_app_mgr_get_services(const gchar* mimetype);
+ClpAppMgrArray* clp_app_mgr_get_services_v2(const gchar* mimetype);
+ClpAppMgrArray* clp_app_mgr_get_app_services(const gchar* application);
+ClpAppMgrArray* clp_app_mgr_get_app_mime_types(const gchar* application);
 gint clp_app_mgr_service_invoke(const gchar* application, ...);
+gint clp_app_mgr_service_invoke_argv(const gchar* service, gint no_of_params, gchar** params_list, gint fd);
 gint clp_app_mgr_handle_file(const gchar *filepath);
+gint clp_app_mgr_handle_files(const gchar * const *filepaths);
 gint clp_app_mgr_handle_string(const gchar *data);
 gint clp_app_mgr_handle_mime(const gchar *mime_type, const gchar *mime_data);
 
@@ -0,0 +1,395 @@
+/** \file clp-app-mgr-menu-index.c
+ *
+ * \brief Menu index of the installed applications
+ *
+ * The installed applications are read from the registry once and kept in a trie over the components of their
+ * MenuPath. The applications are stored in one array in depth first order of the trie: the applications of a
+ * folder, sorted by MenuPos, come first, then the subfolders sorted by name. Every folder therefore owns a
+ * contiguous slice of the array for its own applications and another one for its whole subtree, and a lookup
+ * is a walk down the trie without any copy or registry access.
+ *
+ * The index is rebuilt when the registry generation of the cache monitor moves. Callers hold a reference on the
+ * index they use, a rebuild never frees a slice that is still in use.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <glib.h>
+#include <gconf/gconf-client.h>
+#include "clp-app-mgr-lib.h"
+#include "clp-app-mgr-config.h"
+#include "clp-app-mgr-monitor.h"
+#include "clp-app-mgr-registry.h"
+
+typedef struct _ClpAppMgrMenuNode ClpAppMgrMenuNode;
+
+struct _ClpAppMgrMenuNode					/**< One folder of the menu */
+{
+	gchar		*name;					/**< last component of the folder path, NULL for the root */
+	GPtrArray	*children;				/**< subfolders sorted by name */
+	guint		first_app;				/**< index of the first application of the subtree */
+	guint		n_apps;					/**< applications directly in the folder */
+	guint		n_subtree;				/**< applications in the folder and all its subfolders */
+};
+
+struct _ClpAppMgrMenuIndex
+{
+	volatile gint	ref_count;				/**< references held by the library and the callers */
+	guint		generation;				/**< registry generation the index was built at */
+	ClpAppMgrInstalledApp	**apps;				/**< applications in depth first order of the trie */
+	guint		n_apps;					/**< number of applications */
+	ClpAppMgrMenuNode	*root;				/**< root folder "/" */
+};
+
+typedef struct _ClpAppMgrMenuEntry				/**< Application being sorted while the index is built */
+{
+	ClpAppMgrInstalledApp	*app;				/**< the application */
+	gchar		**components;				/**< non empty components of its menu path */
+}ClpAppMgrMenuEntry;
+
+static ClpAppMgrMenuIndex *current_index = NULL;		/**< index shared by all the lookups of this process */
+G_LOCK_DEFINE_STATIC (current_index);
+
+
+/** \brief Split a menu path into its non empty components
+ *
+ * \param path Menu path such as "/Games/Puzzles" or "/Games/Puzzles/"
+ *
+ * \return NULL terminated array of components, empty for the root. Free with g_strfreev().
+ */
+static gchar**
+menu_path_split(const gchar *path)
+{
+	gchar **split = g_strsplit(path ? path : "", "/", -1);
+	gint i, j;
+
+	for (i = 0, j = 0; split[i]; i++)
+	{
+		if (*split[i] == '\0')
+			g_free(split[i]);
+		else
+			split[j++] = split[i];
+	}
+	split[j] = NULL;
+	return split;
+}
+
+
+/** \brief Order of the applications in the index: by folder, component per component, then by MenuPos */
+static gint
+menu_entry_compare(gconstpointer a, gconstpointer b)
+{
+	const ClpAppMgrMenuEntry *entry_a = *(const ClpAppMgrMenuEntry **) a;
+	const ClpAppMgrMenuEntry *entry_b = *(const ClpAppMgrMenuEntry **) b;
+	gint i, res;
+
+	for (i = 0; entry_a->components[i] && entry_b->components[i]; i++)
+	{
+		res = strcmp(entry_a->components[i], entry_b->components[i]);
+		if (res)
+			return res;
+	}
+	/* the applications of a folder come before its subfolders */
+	if (entry_a->components[i] || entry_b->components[i])
+		return entry_a->components[i] ? 1 : -1;
+
+	res = clp_app_mgr_menupos_compare(entry_a->app, entry_b->app);
+	if (res)
+		return res;
+	return strcmp(entry_a->app->name, entry_b->app->name);
+}
+
+
+/** \brief Find a subfolder by name
+ *
+ * \return The subfolder, NULL if there is none
+ */
+static ClpAppMgrMenuNode*
+menu_node_find_child(ClpAppMgrMenuNode *node, const gchar *name)
+{
+	guint low = 0, high = node->children->len;
+
+	while (low < high)
+	{
+		guint mid = (low + high) / 2;
+		ClpAppMgrMenuNode *child = g_ptr_array_index(node->children, mid);
+		gint res = strcmp(name, child->name);
+
+		if (res == 0)
+			return child;
+		if (res < 0)
+			high = mid;
+		else
+			low = mid + 1;
+	}
+	return NULL;
+}
+
+
+static ClpAppMgrMenuNode*
+menu_node_new(const gchar *name, guint first_app)
+{
+	ClpAppMgrMenuNode *node = g_new0(ClpAppMgrMenuNode, 1);
+
+	node->name = g_strdup(name);
+	node->children = g_ptr_array_new();
+	node->first_app = first_app;
+	return node;
+}
+
+
+static void
+menu_node_free(ClpAppMgrMenuNode *node)
+{
+	guint i;
+
+	for (i = 0; i < node->children->len; i++)
+		menu_node_free(g_ptr_array_index(node->children, i));
+	g_ptr_array_free(node->children, TRUE);
+	g_free(node->name);
+	g_free(node);
+}
+
+
+/** \brief Read one application from the registry
+ *
+ * \param client GConf client
+ * \param app_dir Registry directory of the application, for eg /appmgr/calculator
+ *
+ * \return New application, NULL if the registry entry has no name
+ *
+ * All the keys are fetched with a single gconf_client_all_entries() call.
+ */
+static ClpAppMgrInstalledApp*
+menu_index_read_app(GConfClient *client, const gchar *app_dir)
+{
+	ClpAppMgrInstalledApp *app = g_new0(ClpAppMgrInstalledApp, 1);
+	gchar *info_dir = g_strconcat(app_dir, "/info", NULL);
+	GSList *entries = gconf_client_all_entries(client, info_dir, NULL);
+	GSList *iter;
+
+	for (iter = entries; iter; iter = iter->next)
+	{
+		GConfEntry *entry = iter->data;
+		GConfValue *value = gconf_entry_get_value(entry);
+		const gchar *key = strrchr(gconf_entry_get_key(entry), '/');
+
+		key = key ? key + 1 : gconf_entry_get_key(entry);
+		if (value == NULL)
+			;
+		else if (value->type == GCONF_VALUE_STRING)
+		{
+			const gchar *str = gconf_value_get_string(value);
+
+			if (!strcmp(key, "Name"))
+				app->name = g_strdup(str);
+			else if (!strcmp(key, "Command"))
+				app->exec_name = g_strndup(str, strcspn(str, " "));
+			else if (!strcmp(key, "GenericName"))
+				app->generic_name = g_strdup(str);
+			else if (!strcmp(key, "Icon"))
+				app->icon = g_strdup(str);
+			else if (!strcmp(key, "MenuPath"))
+				app->menu_path = g_strdup(str);
+		}
+		else if (value->type == GCONF_VALUE_BOOL && !strcmp(key, "NoDisplay"))
+			app->nodisplay = gconf_value_get_bool(value);
+		else if (value->type == GCONF_VALUE_INT && !strcmp(key, "MenuPos"))
+			app->menupos = gconf_value_get_int(value);
+		gconf_entry_free(entry);
+	}
+	g_slist_free(entries);
+
+	if (app->name == NULL)
+	{
+		CLP_APPMGR_WARN_V("%s has no Name. It means the gconf repository is not properly updated.", info_dir);
+		g_free(app->exec_name);
+		g_free(app->generic_name);
+		g_free(app->icon);
+		g_free(app->menu_path);
+		g_free(app);
+		g_free(info_dir);
+		return NULL;
+	}
+	if (app->exec_name == NULL)
+		CLP_APPMGR_WARN_V("%s has no Command. It means the gconf repository is not properly updated.", info_dir);
+	if (app->generic_name == NULL)
+		CLP_APPMGR_WARN_V("%s has no GenericName. It means the gconf repository is not properly updated.", info_dir);
+	if (app->icon == NULL)
+		app->icon = g_strdup(CLP_APP_MGR_NO_ICON);
+	if (app->menu_path == NULL)
+		app->menu_path = g_strdup("/");
+
+	g_free(info_dir);
+	return app;
+}
+
+
+/** \brief Build the index from the registry
+ *
+ * \param generation Registry generation the registry is read at
+ *
+ * \return New index with one reference
+ */
+static ClpAppMgrMenuIndex*
+menu_index_build(guint generation)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	ClpAppMgrMenuIndex *index = g_new0(ClpAppMgrMenuIndex, 1);
+	GConfClient *client = clp_app_mgr_registry_client();
+	GSList *appdirs = gconf_client_all_dirs(client, GCONF_APPS_DIR, NULL);
+	GPtrArray *entries = g_ptr_array_new();
+	GSList *iter;
+	guint i;
+
+	for (iter = appdirs; iter; iter = iter->next)
+	{
+		ClpAppMgrInstalledApp *app = menu_index_read_app(client, iter->data);
+		g_free(iter->data);
+		if (app == NULL)
+			continue;
+
+		ClpAppMgrMenuEntry *entry = g_new(ClpAppMgrMenuEntry, 1);
+		entry->app = app;
+		entry->components = menu_path_split(app->menu_path);
+		g_ptr_array_add(entries, entry);
+	}
+	g_slist_free(appdirs);
+
+	g_ptr_array_sort(entries, menu_entry_compare);
+
+	index->ref_count = 1;
+	index->generation = generation;
+	index->n_apps = entries->len;
+	index->apps = g_new(ClpAppMgrInstalledApp *, entries->len);
+	index->root = menu_node_new(NULL, 0);
+
+	/* Entries come in depth first order, so a folder is created on its first application and its subfolders
+	 * are appended already sorted */
+	for (i = 0; i < entries->len; i++)
+	{
+		ClpAppMgrMenuEntry *entry = g_ptr_array_index(entries, i);
+		ClpAppMgrMenuNode *node = index->root;
+		gint depth;
+
+		node->n_subtree++;
+		for (depth = 0; entry->components[depth]; depth++)
+		{
+			ClpAppMgrMenuNode *child = NULL;
+
+			if (node->children->len)
+				child = g_ptr_array_index(node->children, node->children->len - 1);
+			if (child == NULL || strcmp(child->name, entry->components[depth]))
+			{
+				child = menu_node_new(entry->components[depth], i);
+				g_ptr_array_add(node->children, child);
+			}
+			node = child;
+			node->n_subtree++;
+		}
+		node->n_apps++;
+
+		index->apps[i] = entry->app;
+		g_strfreev(entry->components);
+		g_free(entry);
+	}
+	g_ptr_array_free(entries, TRUE);
+
+	CLP_APPMGR_INFO_V("Menu index built with %u applications", index->n_apps);
+	CLP_APPMGR_EXIT_FUNCTION();
+	return index;
+}
+
+
+/** \brief Get the menu index of the installed applications
+ *
+ * \return A reference to the index, to be released with clp_app_mgr_menu_index_unref()
+ *
+ * The index is built on first use and rebuilt only after one of the registry keys it is built from changed, see
+ * CLP_APP_MGR_MONITOR_MENU.
+ */
+ClpAppMgrMenuIndex*
+clp_app_mgr_menu_index_get(void)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	ClpAppMgrMenuIndex *index, *stale = NULL;
+	guint generation = clp_app_mgr_monitor_get_generation(CLP_APP_MGR_MONITOR_MENU);
+
+	G_LOCK(current_index);
+	if (current_index == NULL || current_index->generation != generation)
+	{
+		stale = current_index;
+		current_index = menu_index_build(generation);
+	}
+	index = current_index;
+	g_atomic_int_inc(&index->ref_count);
+	G_UNLOCK(current_index);
+
+	clp_app_mgr_menu_index_unref(stale);
+	CLP_APPMGR_EXIT_FUNCTION();
+	return index;
+}
+
+
+/** \brief Release a reference on the menu index
+ *
+ * \param index Index returned by clp_app_mgr_menu_index_get()
+ *
+ * The slices returned by clp_app_mgr_menu_index_lookup() must not be used afterwards.
+ */
+void
+clp_app_mgr_menu_index_unref(ClpAppMgrMenuIndex *index)
+{
+	guint i;
+
+	if (index == NULL)
+		return;
+	if (!g_atomic_int_dec_and_test(&index->ref_count))
+		return;
+
+	for (i = 0; i < index->n_apps; i++)
+	{
+		g_free(index->apps[i]->name);
+		g_free(index->apps[i]->generic_name);
+		g_free(index->apps[i]->icon);
+		g_free(index->apps[i]->exec_name);
+		g_free(index->apps[i]->menu_path);
+		g_free(index->apps[i]);
+	}
+	g_free(index->apps);
+	menu_node_free(index->root);
+	g_free(index);
+}
+
+
+/** \brief Get the applications of a menu folder
+ *
+ * \param index The menu index
+ * \param menu_path Folder such as "/Games", NULL or "/" for the root
+ * \param recursive TRUE to include the applications of all the subfolders
+ * \param n_apps Returns the number of applications in the slice
+ *
+ * \return Slice of the applications, owned by the index. NULL if the folder does not exist.
+ *
+ * The applications of a folder are sorted by MenuPos. With recursive set, each subfolder follows its parent,
+ * subfolders being sorted by name.
+ */
+ClpAppMgrInstalledApp* const*
+clp_app_mgr_menu_index_lookup(ClpAppMgrMenuIndex *index, const gchar *menu_path, gboolean recursive, guint *n_apps)
+{
+	ClpAppMgrMenuNode *node = index->root;
+	gchar **components = menu_path_split(menu_path);
+	gint i;
+
+	for (i = 0; node && components[i]; i++)
+		node = menu_node_find_child(node, components[i]);
+	g_strfreev(components);
+
+	if (node == NULL)
+	{
+		*n_apps = 0;
+		return NULL;
+	}
+	*n_apps = recursive ? node->n_subtree : node->n_apps;
+	return index->apps + node->first_app;
+}
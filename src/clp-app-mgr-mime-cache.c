@@ -0,0 +1,265 @@
+/** \file clp-app-mgr-mime-cache.c
+ *
+ * \brief Cache of the MIME types guessed by the Application Manager Library
+ *
+ * Implementation of the caches described in clp-app-mgr-mime-cache.h. Each LRU is a hash table of entries
+ * threaded on a queue, most recently used first; the queue links are embedded in the entries so a hit only moves a
+ * link. The MIME types are interned, they stay valid when xdgmime reloads its database.
+ */
+
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <glib.h>
+#include <xdgmime.h>
+#include "clp-app-mgr-config.h"
+#include "clp-app-mgr-mime-cache.h"
+#include "clp-app-mgr-monitor.h"
+#include "clp-app-mgr-classify.h"
+
+typedef struct _ClpAppMgrMimeCacheEntry				/**< One cached guess */
+{
+	GList		link;					/**< link of the recency queue, its data is the entry */
+	gchar		*key;					/**< path of the file or the string */
+	dev_t		dev;					/**< device of the file */
+	ino_t		ino;					/**< inode of the file */
+	time_t		mtime;					/**< modification time of the file, seconds */
+	glong		mtime_nsec;				/**< modification time of the file, nanoseconds */
+	off_t		size;					/**< size of the file */
+	const gchar	*mime_type;				/**< interned MIME type guessed */
+}ClpAppMgrMimeCacheEntry;
+
+typedef struct _ClpAppMgrMimeCacheLru				/**< One LRU */
+{
+	GHashTable	*entries;				/**< key to ClpAppMgrMimeCacheEntry, NULL until first used */
+	GQueue		recency;				/**< entries, most recently used first */
+	guint		mime_generation;			/**< shared MIME database generation the entries were guessed at */
+	guint		desktop_generation;			/**< desktop generation the entries were guessed at, strings only */
+	guint		hits;					/**< lookups answered by the cache */
+	guint		misses;					/**< lookups that had to guess */
+}ClpAppMgrMimeCacheLru;
+
+static ClpAppMgrMimeCacheLru mime_cache[CLP_APP_MGR_MIME_CACHE_N_KINDS];
+G_LOCK_DEFINE_STATIC (mime_cache);
+
+
+/** \brief Free an entry, as the value destroy function of the entries table */
+static void
+mime_cache_entry_free(gpointer data)
+{
+	ClpAppMgrMimeCacheEntry *entry = data;
+
+	g_free(entry->key);
+	g_free(entry);
+}
+
+
+/** \brief Drop the entries of an LRU guessed with another MIME database
+ *
+ * Must be called with the cache lock held.
+ */
+static void
+mime_cache_validate_locked(ClpAppMgrMimeCacheKind kind)
+{
+	ClpAppMgrMimeCacheLru *lru = &mime_cache[kind];
+	guint mime_generation = clp_app_mgr_monitor_get_generation(CLP_APP_MGR_MONITOR_SHARED_MIME);
+	guint desktop_generation = kind == CLP_APP_MGR_MIME_CACHE_STRING ?
+		clp_app_mgr_monitor_get_generation(CLP_APP_MGR_MONITOR_DESKTOP) : 0;
+
+	if (lru->entries && lru->mime_generation == mime_generation && lru->desktop_generation == desktop_generation)
+		return;
+
+	if (lru->entries)
+	{
+		CLP_APPMGR_INFO_V("MIME cache %d dropped, %u hits %u misses so far", kind, lru->hits, lru->misses);
+		g_hash_table_destroy(lru->entries);
+	}
+	lru->entries = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, mime_cache_entry_free);
+	g_queue_init(&lru->recency);
+	lru->mime_generation = mime_generation;
+	lru->desktop_generation = desktop_generation;
+}
+
+
+/** \brief Find an entry and make it the most recently used
+ *
+ * Must be called with the cache lock held.
+ */
+static ClpAppMgrMimeCacheEntry*
+mime_cache_lookup_locked(ClpAppMgrMimeCacheKind kind, const gchar *key)
+{
+	ClpAppMgrMimeCacheLru *lru = &mime_cache[kind];
+	ClpAppMgrMimeCacheEntry *entry = g_hash_table_lookup(lru->entries, key);
+
+	if (entry && lru->recency.head != &entry->link)
+	{
+		g_queue_unlink(&lru->recency, &entry->link);
+		g_queue_push_head_link(&lru->recency, &entry->link);
+	}
+	return entry;
+}
+
+
+/** \brief Get the entry of a key, adding it as the most recently used and evicting the least recently used
+ *
+ * \return The entry, to be filled by the caller
+ *
+ * Must be called with the cache lock held.
+ */
+static ClpAppMgrMimeCacheEntry*
+mime_cache_insert_locked(ClpAppMgrMimeCacheKind kind, const gchar *key)
+{
+	ClpAppMgrMimeCacheLru *lru = &mime_cache[kind];
+	ClpAppMgrMimeCacheEntry *entry = mime_cache_lookup_locked(kind, key);
+
+	if (entry)
+		return entry;
+
+	entry = g_new0(ClpAppMgrMimeCacheEntry, 1);
+	entry->key = g_strdup(key);
+	entry->link.data = entry;
+	g_hash_table_insert(lru->entries, entry->key, entry);
+	g_queue_push_head_link(&lru->recency, &entry->link);
+
+	if (lru->recency.length > CLP_APP_MGR_MIME_CACHE_SIZE)
+	{
+		ClpAppMgrMimeCacheEntry *oldest = g_queue_pop_tail_link(&lru->recency)->data;
+		g_hash_table_remove(lru->entries, oldest->key);
+	}
+	return entry;
+}
+
+
+/** \brief Get the MIME type of a file
+ *
+ * \param path Path of the file
+ *
+ * \return Interned MIME type as guessed by xdgmime
+ *
+ * A file that cannot be stat()ed is sniffed every time.
+ */
+const gchar*
+clp_app_mgr_mime_cache_file(const gchar *path)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	ClpAppMgrMimeCacheEntry *entry;
+	const gchar *mime_type;
+	struct stat st;
+
+	if (stat(path, &st) != 0)
+	{
+		CLP_APPMGR_EXIT_FUNCTION();
+		return g_intern_string(xdg_mime_get_mime_type_for_file(path, NULL));
+	}
+
+	G_LOCK(mime_cache);
+	mime_cache_validate_locked(CLP_APP_MGR_MIME_CACHE_FILE);
+	entry = mime_cache_lookup_locked(CLP_APP_MGR_MIME_CACHE_FILE, path);
+	if (entry && entry->dev == st.st_dev && entry->ino == st.st_ino && entry->size == st.st_size
+		&& entry->mtime == st.st_mtim.tv_sec && entry->mtime_nsec == st.st_mtim.tv_nsec)
+	{
+		mime_cache[CLP_APP_MGR_MIME_CACHE_FILE].hits++;
+		mime_type = entry->mime_type;
+		G_UNLOCK(mime_cache);
+		CLP_APPMGR_EXIT_FUNCTION();
+		return mime_type;
+	}
+	mime_cache[CLP_APP_MGR_MIME_CACHE_FILE].misses++;
+	G_UNLOCK(mime_cache);
+
+	/* the file is sniffed unlocked, a concurrent guess of the same file only costs a second sniff */
+	mime_type = g_intern_string(xdg_mime_get_mime_type_for_file(path, &st));
+
+	G_LOCK(mime_cache);
+	mime_cache_validate_locked(CLP_APP_MGR_MIME_CACHE_FILE);
+	entry = mime_cache_insert_locked(CLP_APP_MGR_MIME_CACHE_FILE, path);
+	entry->dev = st.st_dev;
+	entry->ino = st.st_ino;
+	entry->size = st.st_size;
+	entry->mtime = st.st_mtim.tv_sec;
+	entry->mtime_nsec = st.st_mtim.tv_nsec;
+	entry->mime_type = mime_type;
+	G_UNLOCK(mime_cache);
+
+	CLP_APPMGR_EXIT_FUNCTION();
+	return mime_type;
+}
+
+
+/** \brief Guess the MIME type of a string, the string patterns of the handlers first, then xdgmime */
+static const gchar*
+mime_cache_guess_string(const gchar *data)
+{
+	const gchar *mime_type = clp_app_mgr_classify_string(data);
+
+	if (mime_type == NULL)
+		mime_type = g_intern_string(xdg_mime_get_mime_type_from_file_name(data));
+	return mime_type;
+}
+
+
+/** \brief Get the MIME type of a string
+ *
+ * \param data The string
+ *
+ * \return Interned MIME type
+ *
+ * Strings longer than CLP_APP_MGR_MIME_CACHE_MAX_STRING are guessed every time.
+ */
+const gchar*
+clp_app_mgr_mime_cache_string(const gchar *data)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	ClpAppMgrMimeCacheEntry *entry;
+	const gchar *mime_type;
+
+	if (strlen(data) > CLP_APP_MGR_MIME_CACHE_MAX_STRING)
+	{
+		CLP_APPMGR_EXIT_FUNCTION();
+		return mime_cache_guess_string(data);
+	}
+
+	G_LOCK(mime_cache);
+	mime_cache_validate_locked(CLP_APP_MGR_MIME_CACHE_STRING);
+	entry = mime_cache_lookup_locked(CLP_APP_MGR_MIME_CACHE_STRING, data);
+	if (entry)
+	{
+		mime_cache[CLP_APP_MGR_MIME_CACHE_STRING].hits++;
+		mime_type = entry->mime_type;
+		G_UNLOCK(mime_cache);
+		CLP_APPMGR_EXIT_FUNCTION();
+		return mime_type;
+	}
+	mime_cache[CLP_APP_MGR_MIME_CACHE_STRING].misses++;
+	G_UNLOCK(mime_cache);
+
+	mime_type = mime_cache_guess_string(data);
+
+	G_LOCK(mime_cache);
+	mime_cache_validate_locked(CLP_APP_MGR_MIME_CACHE_STRING);
+	mime_cache_insert_locked(CLP_APP_MGR_MIME_CACHE_STRING, data)->mime_type = mime_type;
+	G_UNLOCK(mime_cache);
+
+	CLP_APPMGR_EXIT_FUNCTION();
+	return mime_type;
+}
+
+
+/** \brief Get the hit and miss counters of an LRU
+ *
+ * \param kind The LRU
+ * \param hits Returns the number of lookups answered by the cache since the library was loaded
+ * \param misses Returns the number of lookups that had to guess
+ */
+void
+clp_app_mgr_mime_cache_get_stats(ClpAppMgrMimeCacheKind kind, guint *hits, guint *misses)
+{
+	g_return_if_fail(kind < CLP_APP_MGR_MIME_CACHE_N_KINDS);
+
+	G_LOCK(mime_cache);
+	if (hits)
+		*hits = mime_cache[kind].hits;
+	if (misses)
+		*misses = mime_cache[kind].misses;
+	G_UNLOCK(mime_cache);
+}
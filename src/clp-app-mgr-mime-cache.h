@@ -0,0 +1,31 @@
+/** \file clp-app-mgr-mime-cache.h
+ * \brief Cache of the MIME types guessed by the Application Manager Library
+ *
+ * Sniffing a file opens and reads it even when it did not change since the last query. The MIME types guessed
+ * for files are kept in a bounded LRU keyed by path and validated by the inode, modification time and size of
+ * the file, so a thumbnailer or file browser asking again about the same files costs one stat() each. The MIME
+ * types guessed for strings are kept in a second LRU keyed by the string. Both are dropped when the shared MIME
+ * database changes, the strings also when the desktop files declaring string patterns change.
+ * This header is internal to the library, it is not installed.
+ */
+
+#ifndef __CLP_APP_MGR_MIME_CACHE_H__
+#define __CLP_APP_MGR_MIME_CACHE_H__
+
+#include <glib.h>
+
+#define CLP_APP_MGR_MIME_CACHE_SIZE		256			/**< largest number of entries of each LRU */
+#define CLP_APP_MGR_MIME_CACHE_MAX_STRING	256			/**< longest string cached, in bytes */
+
+typedef enum _ClpAppMgrMimeCacheKind				/**< One of the LRU */
+{
+	CLP_APP_MGR_MIME_CACHE_FILE,				/**< MIME types of files */
+	CLP_APP_MGR_MIME_CACHE_STRING,				/**< MIME types of strings */
+	CLP_APP_MGR_MIME_CACHE_N_KINDS
+}ClpAppMgrMimeCacheKind;
+
+const gchar* clp_app_mgr_mime_cache_file (const gchar *path);
+const gchar* clp_app_mgr_mime_cache_string (const gchar *data);
+void clp_app_mgr_mime_cache_get_stats (ClpAppMgrMimeCacheKind kind, guint *hits, guint *misses);
+
+#endif /*__CLP_APP_MGR_MIME_CACHE_H__ */
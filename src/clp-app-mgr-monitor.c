@@ -0,0 +1,479 @@
+/** \file clp-app-mgr-monitor.c
+ *
+ * \brief Cache invalidation service for the Application Manager Library
+ *
+ * Implementation of the generation counters described in clp-app-mgr-monitor.h.
+ */
+
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <glib.h>
+#include <gconf/gconf-client.h>
+#include "clp-app-mgr-config.h"
+#include "clp-app-mgr-monitor.h"
+#include "clp-app-mgr-registry.h"
+
+#define MONITOR_DIR_EVENTS	(IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF)
+#define MONITOR_BUFFER_SIZE	4096
+
+typedef struct _ClpAppMgrMonitorRule				/**< One domain interested in a watched directory */
+{
+	gchar		*name;					/**< entry of the directory, NULL for every entry */
+	ClpAppMgrMonitorDomain	domain;				/**< domain bumped when the entry changes */
+}ClpAppMgrMonitorRule;
+
+typedef struct _ClpAppMgrMonitorWatch				/**< One inotify watch */
+{
+	gint		wd;					/**< inotify watch descriptor, -1 while the directory is gone */
+	gchar		*path;					/**< watched directory */
+	GSList		*rules;					/**< list of ClpAppMgrMonitorRule */
+}ClpAppMgrMonitorWatch;
+
+static struct
+{
+	gboolean	started;				/**< TRUE once the watches were set up, even if inotify is unavailable */
+	gboolean	signals;				/**< TRUE once the lifecycle signals reach the library */
+	gint		fd;					/**< inotify descriptor, -1 if inotify is unavailable */
+	GSList		*watches;				/**< list of ClpAppMgrMonitorWatch */
+	volatile gint	lost;					/**< number of watches whose directory is gone */
+	volatile gint	generations[CLP_APP_MGR_MONITOR_N_DOMAINS];	/**< generation counter per domain */
+	gint64		polled_at[CLP_APP_MGR_MONITOR_N_DOMAINS];	/**< monotonic time in ms a domain was last bumped outside the main loop */
+	gboolean	registry_notify;			/**< the gconf notification of GCONF_APPS_DIR is installed */
+	gboolean	registry_watched;			/**< GCONF_APPS_DIR was added, its notifications are delivered */
+}monitor = { FALSE, FALSE, -1, NULL, 0, { 0 }, { 0 }, FALSE, FALSE };
+G_LOCK_DEFINE_STATIC (monitor);
+
+
+/** \brief Bump the generation of every domain of a watch
+ *
+ * \param watch The watch
+ * \param name Changed entry of the watched directory, NULL if the directory itself changed
+ */
+static void
+monitor_watch_bump(ClpAppMgrMonitorWatch *watch, const gchar *name)
+{
+	GSList *iter;
+
+	for (iter = watch->rules; iter; iter = iter->next)
+	{
+		ClpAppMgrMonitorRule *rule = iter->data;
+		if (name == NULL || rule->name == NULL || strcmp(rule->name, name) == 0)
+			clp_app_mgr_monitor_bump(rule->domain);
+	}
+}
+
+
+/** \brief Read the pending inotify events and bump the generations they invalidate
+ *
+ * Never blocks, the descriptor is non blocking.
+ */
+static void
+monitor_drain(void)
+{
+	gchar buffer[MONITOR_BUFFER_SIZE] __attribute__ ((aligned (__alignof__ (struct inotify_event))));
+	ssize_t length;
+	gint domain;
+
+	while ((length = read(monitor.fd, buffer, sizeof(buffer))) > 0)
+	{
+		gchar *ptr = buffer;
+
+		G_LOCK(monitor);
+		while (ptr < buffer + length)
+		{
+			struct inotify_event *event = (struct inotify_event *) ptr;
+			GSList *iter;
+
+			ptr += sizeof(struct inotify_event) + event->len;
+
+			if (event->mask & IN_Q_OVERFLOW)
+			{
+				CLP_APPMGR_WARN("inotify queue overflow, invalidating every cache");
+				for (domain = 0; domain < CLP_APP_MGR_MONITOR_N_DOMAINS; domain++)
+					clp_app_mgr_monitor_bump(domain);
+				continue;
+			}
+
+			for (iter = monitor.watches; iter; iter = iter->next)
+			{
+				ClpAppMgrMonitorWatch *watch = iter->data;
+				if (watch->wd != event->wd)
+					continue;
+
+				if (event->mask & (IN_MOVE_SELF | IN_IGNORED))
+				{
+					/* a directory moved away keeps its watch, drop it to watch the path again */
+					CLP_APPMGR_WARN_V("%s is gone, it is watched again once it is back", watch->path);
+					if (event->mask & IN_MOVE_SELF)
+						inotify_rm_watch(monitor.fd, watch->wd);
+					watch->wd = -1;
+					g_atomic_int_inc(&monitor.lost);
+				}
+				/* the same directory may have several watches, see monitor_rearm() */
+				monitor_watch_bump(watch, event->len ? event->name : NULL);
+			}
+		}
+		G_UNLOCK(monitor);
+	}
+	if (length < 0 && errno != EAGAIN && errno != EINTR)
+		CLP_APPMGR_WARN_V("Failed to read inotify events : %s", g_strerror(errno));
+}
+
+
+/** \brief Watch again the directories that were removed or moved away
+ *
+ * A directory that is back is watched again and its domains are bumped, its entries may have changed while it
+ * was gone. The domains of a directory still missing are bumped on every call, so no cache outlives it.
+ */
+static void
+monitor_rearm(void)
+{
+	GSList *iter;
+
+	if (g_atomic_int_get(&monitor.lost) == 0)
+		return;
+
+	G_LOCK(monitor);
+	for (iter = monitor.watches; iter; iter = iter->next)
+	{
+		ClpAppMgrMonitorWatch *watch = iter->data;
+		if (watch->wd >= 0)
+			continue;
+
+		/* a watch added meanwhile for the same directory gets the same descriptor, both are kept */
+		watch->wd = inotify_add_watch(monitor.fd, watch->path, MONITOR_DIR_EVENTS);
+		if (watch->wd >= 0)
+		{
+			CLP_APPMGR_INFO_V("%s is back, it is watched again", watch->path);
+			g_atomic_int_add(&monitor.lost, -1);
+		}
+		monitor_watch_bump(watch, NULL);
+	}
+	G_UNLOCK(monitor);
+}
+
+
+/** \brief Main loop callback of the inotify descriptor */
+static gboolean
+monitor_io_func(GIOChannel *channel, GIOCondition condition, gpointer data)
+{
+	monitor_drain();
+	return TRUE;
+}
+
+
+/** \brief Check whether a registry key is one of the given application information keys
+ *
+ * \param key Full gconf key
+ * \param info_keys NULL terminated list of key names
+ *
+ * \return TRUE for GCONF_APPS_DIR/<app>/info/<key> with <key> in info_keys
+ */
+static gboolean
+monitor_is_info_key(const gchar *key, const gchar * const *info_keys)
+{
+	const gchar *name;
+	guint i;
+
+	if (!g_str_has_prefix(key, GCONF_APPS_DIR "/"))
+		return FALSE;
+	name = strchr(key + strlen(GCONF_APPS_DIR "/"), '/');
+	if (name == NULL || !g_str_has_prefix(name, "/info/"))
+		return FALSE;
+	name += strlen("/info/");
+	for (i = 0; info_keys[i]; i++)
+		if (!strcmp(name, info_keys[i]))
+			return TRUE;
+	return FALSE;
+}
+
+
+/** \brief Check whether a domain fed by registry notifications is to be reported as changed outside the main loop
+ *
+ * \param domain CLP_APP_MGR_MONITOR_MENU or CLP_APP_MGR_MONITOR_DBUS
+ *
+ * \return TRUE at most once per CLP_APP_MGR_MONITOR_POLL_MAX_AGE
+ */
+static gboolean
+monitor_poll_due(ClpAppMgrMonitorDomain domain)
+{
+	struct timespec ts;
+	gint64 now;
+	gboolean due;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	now = (gint64) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+	G_LOCK(monitor);
+	due = monitor.polled_at[domain] == 0 || now - monitor.polled_at[domain] >= CLP_APP_MGR_MONITOR_POLL_MAX_AGE;
+	if (due)
+		monitor.polled_at[domain] = now;
+	G_UNLOCK(monitor);
+	return due;
+}
+
+
+/** \brief gconf notification of any change below GCONF_APPS_DIR
+ *
+ * The menu and dbus domains are bumped only for the keys they are built from, the instance keys written at
+ * every start (PID, Visibility, LastInstId...) leave them alone.
+ */
+static void
+monitor_registry_changed(GConfClient *client, guint cnxn_id, GConfEntry *entry, gpointer data)
+{
+	static const gchar *menu_keys[] = { CLP_APP_MGR_MONITOR_MENU_KEYS, NULL };
+	static const gchar *dbus_keys[] = { CLP_APP_MGR_MONITOR_DBUS_KEYS, NULL };
+	const gchar *key = gconf_entry_get_key(entry);
+
+	clp_app_mgr_monitor_bump(CLP_APP_MGR_MONITOR_REGISTRY);
+	if (monitor_is_info_key(key, menu_keys))
+		clp_app_mgr_monitor_bump(CLP_APP_MGR_MONITOR_MENU);
+	if (monitor_is_info_key(key, dbus_keys))
+		clp_app_mgr_monitor_bump(CLP_APP_MGR_MONITOR_DBUS);
+}
+
+
+/** \brief Add a rule to the watch of a directory, creating the watch if needed
+ *
+ * \param directory Directory to watch
+ * \param name Entry of the directory, NULL for every entry
+ * \param domain Domain bumped on a change
+ *
+ * \return TRUE if the directory is watched
+ *
+ * Must be called with the monitor lock held.
+ */
+static gboolean
+monitor_watch_locked(const gchar *directory, const gchar *name, ClpAppMgrMonitorDomain domain)
+{
+	ClpAppMgrMonitorWatch *watch = NULL;
+	ClpAppMgrMonitorRule *rule;
+	GSList *iter;
+	gint wd;
+
+	if (monitor.fd < 0)
+		return FALSE;
+
+	wd = inotify_add_watch(monitor.fd, directory, MONITOR_DIR_EVENTS);
+	if (wd < 0)
+	{
+		CLP_APPMGR_WARN_V("Unable to watch %s : %s", directory, g_strerror(errno));
+		return FALSE;
+	}
+
+	/* inotify hands back the same descriptor for a directory watched twice */
+	for (iter = monitor.watches; iter; iter = iter->next)
+		if (((ClpAppMgrMonitorWatch *) iter->data)->wd == wd)
+			watch = iter->data;
+	if (watch == NULL)
+	{
+		watch = g_new0(ClpAppMgrMonitorWatch, 1);
+		watch->wd = wd;
+		watch->path = g_strdup(directory);
+		monitor.watches = g_slist_prepend(monitor.watches, watch);
+	}
+
+	rule = g_new0(ClpAppMgrMonitorRule, 1);
+	rule->name = g_strdup(name);
+	rule->domain = domain;
+	watch->rules = g_slist_prepend(watch->rules, rule);
+	CLP_APPMGR_INFO_V("Watching %s%s%s", directory, name ? "/" : "", name ? name : "");
+	return TRUE;
+}
+
+
+/** \brief Set up the inotify descriptor and the default watches on first use */
+static void
+monitor_ensure_started(void)
+{
+	G_LOCK(monitor);
+	if (monitor.started)
+	{
+		G_UNLOCK(monitor);
+		return;
+	}
+	monitor.started = TRUE;
+
+	monitor.fd = inotify_init();
+	if (monitor.fd < 0)
+	{
+		CLP_APPMGR_WARN_V("inotify is unavailable (%s), caches are revalidated on every lookup", g_strerror(errno));
+		G_UNLOCK(monitor);
+		return;
+	}
+	fcntl(monitor.fd, F_SETFL, fcntl(monitor.fd, F_GETFL) | O_NONBLOCK);
+	fcntl(monitor.fd, F_SETFD, FD_CLOEXEC);
+
+	GIOChannel *channel = g_io_channel_unix_new(monitor.fd);
+	g_io_add_watch(channel, G_IO_IN, monitor_io_func, NULL);
+	g_io_channel_unref(channel);
+
+	monitor_watch_locked(APPLICATION_INFO_PATH, NULL, CLP_APP_MGR_MONITOR_DESKTOP);
+	monitor_watch_locked(APPLICATION_INFO_PATH, "mimeinfo.cache", CLP_APP_MGR_MONITOR_MIME);
+	monitor_watch_locked(MIME_INFO_PATH, NULL, CLP_APP_MGR_MONITOR_SHARED_MIME);
+	G_UNLOCK(monitor);
+}
+
+
+/** \brief Subscribe to the registry notifications on first use
+ *
+ * \return TRUE if the registry notifications reach the caller: the directory is watched and the caller runs the
+ * default main loop that delivers them
+ *
+ * Only the processes that cache the registry subscribe to its notifications, see clp_app_mgr_registry_watch().
+ */
+static gboolean
+monitor_registry_notified(void)
+{
+	gboolean install, watched, newly_watched;
+
+	G_LOCK(monitor);
+	install = !monitor.registry_notify;
+	monitor.registry_notify = TRUE;
+	G_UNLOCK(monitor);
+	if (install)
+		gconf_client_notify_add(clp_app_mgr_registry_client(), GCONF_APPS_DIR, monitor_registry_changed, NULL, NULL, NULL);
+	clp_app_mgr_registry_watch();
+
+	watched = clp_app_mgr_registry_is_watched();
+	G_LOCK(monitor);
+	newly_watched = watched && !monitor.registry_watched;
+	monitor.registry_watched = watched;
+	G_UNLOCK(monitor);
+	if (newly_watched)
+	{
+		/* changes made before the directory was watched were not notified */
+		clp_app_mgr_monitor_bump(CLP_APP_MGR_MONITOR_REGISTRY);
+		clp_app_mgr_monitor_bump(CLP_APP_MGR_MONITOR_MENU);
+		clp_app_mgr_monitor_bump(CLP_APP_MGR_MONITOR_DBUS);
+	}
+	return watched && g_main_context_is_owner(g_main_context_default());
+}
+
+
+/** \brief Get the current generation of a domain
+ *
+ * \param domain The domain a cache depends on
+ *
+ * \return Generation counter, a cache built at another generation must be revalidated
+ *
+ * Events are normally delivered by the default main loop. When the caller does not own the default main context
+ * (no main loop is running, or the call comes from another thread) the pending inotify events are read here instead,
+ * and the registry, whose gconf notifications only arrive through the main loop, is reported as changed. So it is
+ * until the main loop thread first asks for a registry domain, which adds the registry directory. The menu
+ * and dbus domains, whose caches are costly to rebuild, are reported as changed at most once per
+ * CLP_APP_MGR_MONITOR_POLL_MAX_AGE.
+ * A watched directory that is gone is looked for again on every call, see monitor_rearm().
+ * Without inotify every call reports a change. The running applications are reported as changed unless the
+ * lifecycle signals are delivered, see clp_app_mgr_monitor_signals_connected().
+ */
+guint
+clp_app_mgr_monitor_get_generation(ClpAppMgrMonitorDomain domain)
+{
+	monitor_ensure_started();
+
+	if (domain == CLP_APP_MGR_MONITOR_ACTIVE)
+	{
+		if (!monitor.signals || !g_main_context_is_owner(g_main_context_default()))
+			clp_app_mgr_monitor_bump(domain);
+	}
+	else if (domain == CLP_APP_MGR_MONITOR_REGISTRY || domain == CLP_APP_MGR_MONITOR_MENU || domain == CLP_APP_MGR_MONITOR_DBUS)
+	{
+		if (!monitor_registry_notified() && (domain == CLP_APP_MGR_MONITOR_REGISTRY || monitor_poll_due(domain)))
+			clp_app_mgr_monitor_bump(domain);
+	}
+	else if (monitor.fd < 0)
+		clp_app_mgr_monitor_bump(domain);
+	else
+	{
+		if (!g_main_context_is_owner(g_main_context_default()))
+			monitor_drain();
+		monitor_rearm();
+	}
+	return (guint) g_atomic_int_get(&monitor.generations[domain]);
+}
+
+
+/** \brief Invalidate every cache of a domain
+ *
+ * \param domain The domain
+ *
+ * Used by the library itself after it changed the data behind a domain, so the change is seen immediately
+ * instead of on the next inotify event.
+ */
+void
+clp_app_mgr_monitor_bump(ClpAppMgrMonitorDomain domain)
+{
+	g_return_if_fail(domain < CLP_APP_MGR_MONITOR_N_DOMAINS);
+	g_atomic_int_inc(&monitor.generations[domain]);
+}
+
+
+/** \brief Watch a snapshot file
+ *
+ * \param path Absolute path of the file, it does not need to exist yet
+ * \param domain Domain bumped whenever the file is created, rewritten, replaced or removed
+ *
+ * \return TRUE if the file is watched. FALSE if it cannot be, the domain is then never bumped for it.
+ *
+ * The parent directory is watched, so a file replaced by rename (g_file_set_contents()) is still seen.
+ */
+gboolean
+clp_app_mgr_monitor_add_file(const gchar *path, ClpAppMgrMonitorDomain domain)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	gchar *directory, *name;
+	gboolean res;
+
+	monitor_ensure_started();
+
+	directory = g_path_get_dirname(path);
+	name = g_path_get_basename(path);
+	G_LOCK(monitor);
+	res = monitor_watch_locked(directory, name, domain);
+	G_UNLOCK(monitor);
+	g_free(directory);
+	g_free(name);
+
+	CLP_APPMGR_EXIT_FUNCTION();
+	return res;
+}
+
+
+/** \brief Watch every entry of a directory
+ *
+ * \param directory Absolute path of the directory, it must exist
+ * \param domain Domain bumped whenever an entry of the directory changes
+ *
+ * \return TRUE if the directory is watched. FALSE if it cannot be, the domain is then never bumped for it.
+ */
+gboolean
+clp_app_mgr_monitor_add_dir(const gchar *directory, ClpAppMgrMonitorDomain domain)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	gboolean res;
+
+	monitor_ensure_started();
+
+	G_LOCK(monitor);
+	res = monitor_watch_locked(directory, NULL, domain);
+	G_UNLOCK(monitor);
+
+	CLP_APPMGR_EXIT_FUNCTION();
+	return res;
+}
+
+
+/** \brief Tell the monitor the lifecycle signals are delivered
+ *
+ * Called by clp_app_mgr_init() once the signal filter is installed. Until then nothing bumps
+ * CLP_APP_MGR_MONITOR_ACTIVE, so every query reports it as changed.
+ */
+void
+clp_app_mgr_monitor_signals_connected(void)
+{
+	monitor.signals = TRUE;
+}
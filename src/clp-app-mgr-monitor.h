@@ -0,0 +1,42 @@
+/** \file clp-app-mgr-monitor.h
+ * \brief Cache invalidation service for the Application Manager Library
+ *
+ * A single inotify descriptor, attached to the default main loop, watches the desktop file directory, the shared
+ * MIME database and any snapshot file a cache registers. A watched directory that is removed or moved away is
+ * watched again once it is back; until then its domains are reported as changed on every lookup. The gconf application registry is
+ * watched through a gconf notification and the running applications through the lifecycle signals of the
+ * application manager. Every change bumps the generation counter of its domain; a cache remembers the generation
+ * it was built at and revalidates only when the counter moved, so a lookup costs one integer compare.
+ * This header is internal to the library, it is not installed.
+ */
+
+#ifndef __CLP_APP_MGR_MONITOR_H__
+#define __CLP_APP_MGR_MONITOR_H__
+
+#include <glib.h>
+
+#define CLP_APP_MGR_MONITOR_MENU_KEYS		"Name", "Command", "GenericName", "Icon", "MenuPath", "MenuPos", \
+						"NoDisplay"		/**< keys of GCONF_APPS_DIR/<app>/info the menu is built from */
+#define CLP_APP_MGR_MONITOR_DBUS_KEYS		"DBusService", "DBusObjPath", "DBusInterface"	/**< keys of GCONF_APPS_DIR/<app>/info locating a middleware module */
+#define CLP_APP_MGR_MONITOR_POLL_MAX_AGE	1000			/**< longest time, in ms, the menu and dbus domains stay unchanged outside the main loop */
+
+typedef enum _ClpAppMgrMonitorDomain				/**< What a change invalidates */
+{
+	CLP_APP_MGR_MONITOR_DESKTOP,				/**< desktop files and the compiled desktop database */
+	CLP_APP_MGR_MONITOR_MIME,				/**< mimeinfo.cache */
+	CLP_APP_MGR_MONITOR_REGISTRY,				/**< application registry in gconf */
+	CLP_APP_MGR_MONITOR_ACTIVE,				/**< running applications, bumped by the lifecycle signals */
+	CLP_APP_MGR_MONITOR_OVERLAY,				/**< overlay property logs */
+	CLP_APP_MGR_MONITOR_SHARED_MIME,			/**< shared MIME database used by xdgmime */
+	CLP_APP_MGR_MONITOR_MENU,				/**< registry keys of the application menu, see CLP_APP_MGR_MONITOR_MENU_KEYS */
+	CLP_APP_MGR_MONITOR_DBUS,				/**< registry keys of the middleware modules, see CLP_APP_MGR_MONITOR_DBUS_KEYS */
+	CLP_APP_MGR_MONITOR_N_DOMAINS
+}ClpAppMgrMonitorDomain;
+
+guint clp_app_mgr_monitor_get_generation (ClpAppMgrMonitorDomain domain);
+void clp_app_mgr_monitor_bump (ClpAppMgrMonitorDomain domain);
+gboolean clp_app_mgr_monitor_add_file (const gchar *path, ClpAppMgrMonitorDomain domain);
+gboolean clp_app_mgr_monitor_add_dir (const gchar *directory, ClpAppMgrMonitorDomain domain);
+void clp_app_mgr_monitor_signals_connected (void);
+
+#endif /*__CLP_APP_MGR_MONITOR_H__ */
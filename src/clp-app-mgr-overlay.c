@@ -0,0 +1,306 @@
+/** \file clp-app-mgr-overlay.c
+ *
+ * \brief Overlay property store of the Application Manager Library
+ *
+ * Implementation of the store described in clp-app-mgr-overlay.h. A log holds one "key=value" line per write,
+ * the value escaped with g_strescape(). A batch of values is appended with a single write() under an exclusive
+ * flock(), which is also held while the log is compacted; readers take no lock and ignore an incomplete last line.
+ * The parsed logs are cached per application until the overlay generation moves.
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <glib.h>
+#include "clp-app-mgr-config.h"
+#include "clp-app-mgr-overlay.h"
+#include "clp-app-mgr-monitor.h"
+#include "clp-app-mgr-intern.h"
+#include "clp-app-mgr-classify.h"
+#include "clp-app-mgr-desktop-db.h"
+
+static struct
+{
+	gboolean	dir_checked;				/**< the directory was created and watched, or could not be */
+	gboolean	dir_usable;				/**< the directory exists and is writable */
+	guint		generation;				/**< overlay generation the cache was filled at */
+	GHashTable	*cache;					/**< interned application name to its parsed log, a GHashTable */
+}overlay = { FALSE, FALSE, 0, NULL };
+G_LOCK_DEFINE_STATIC (overlay);
+
+
+/** \brief Check whether a batch sets a key read from the desktop files by the library
+ *
+ * \return TRUE if one of the properties is in CLP_APP_MGR_OVERLAY_WRITE_THROUGH_KEYS
+ */
+static gboolean
+overlay_needs_write_through(const gchar * const *properties, guint n_properties)
+{
+	static const gchar *keys[] = { CLP_APP_MGR_OVERLAY_WRITE_THROUGH_KEYS, NULL };
+	guint i, j;
+
+	for (i = 0; i < n_properties; i++)
+		for (j = 0; keys[j]; j++)
+			if (!strcmp(properties[i], keys[j]))
+				return TRUE;
+	return FALSE;
+}
+
+
+/** \brief Path of the log of an application, to be freed */
+static gchar*
+overlay_path(const ClpAppMgrAppNames *names)
+{
+	return g_strconcat(CLP_APP_MGR_OVERLAY_DIR, names->app_name, CLP_APP_MGR_OVERLAY_SUFFIX, NULL);
+}
+
+
+/** \brief Parse the complete lines of a log
+ *
+ * \param data Content of the log
+ * \param length Its length
+ * \param table Table of key to value the lines are added to, later lines replace earlier ones
+ */
+static void
+overlay_parse(const gchar *data, gsize length, GHashTable *table)
+{
+	const gchar *line = data, *end = data + length;
+	const gchar *eol, *equal;
+
+	while (line < end && (eol = memchr(line, '\n', end - line)) != NULL)
+	{
+		equal = memchr(line, '=', eol - line);
+		if (equal && equal > line)
+		{
+			gchar *escaped = g_strndup(equal + 1, eol - equal - 1);
+			g_hash_table_replace(table, g_strndup(line, equal - line), g_strcompress(escaped));
+			g_free(escaped);
+		}
+		line = eol + 1;
+	}
+}
+
+
+/** \brief Create and watch the directory of the logs on first use
+ *
+ * \return TRUE if the logs can be written
+ *
+ * Must be called with the overlay lock held.
+ */
+static gboolean
+overlay_ensure_dir_locked(void)
+{
+	if (overlay.dir_checked)
+		return overlay.dir_usable;
+	overlay.dir_checked = TRUE;
+
+	if (g_mkdir_with_parents(CLP_APP_MGR_OVERLAY_DIR, 0755) < 0 || access(CLP_APP_MGR_OVERLAY_DIR, W_OK) < 0)
+	{
+		CLP_APPMGR_WARN_V("%s is not writable (%s), properties are written to the desktop files", CLP_APP_MGR_OVERLAY_DIR, g_strerror(errno));
+		return FALSE;
+	}
+	overlay.dir_usable = TRUE;
+	clp_app_mgr_monitor_add_dir(CLP_APP_MGR_OVERLAY_DIR, CLP_APP_MGR_MONITOR_OVERLAY);
+	return TRUE;
+}
+
+
+/** \brief Get the parsed log of an application
+ *
+ * \return Table of key to value, owned by the cache
+ *
+ * Must be called with the overlay lock held.
+ */
+static GHashTable*
+overlay_get_locked(const ClpAppMgrAppNames *names)
+{
+	guint generation = clp_app_mgr_monitor_get_generation(CLP_APP_MGR_MONITOR_OVERLAY);
+	GHashTable *table;
+	gchar *path, *data;
+	gsize length;
+
+	if (overlay.cache == NULL)
+		overlay.cache = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) g_hash_table_destroy);
+	else if (overlay.generation != generation)
+		g_hash_table_remove_all(overlay.cache);
+	overlay.generation = generation;
+
+	table = g_hash_table_lookup(overlay.cache, names->app_name);
+	if (table)
+		return table;
+
+	table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+	path = overlay_path(names);
+	if (g_file_get_contents(path, &data, &length, NULL))
+	{
+		overlay_parse(data, length, table);
+		g_free(data);
+	}
+	g_free(path);
+	g_hash_table_insert(overlay.cache, (gpointer) names->app_name, table);
+	return table;
+}
+
+
+/** \brief Write the log of an application into its desktop file and empty it
+ *
+ * \param names Names of the application
+ * \param fd Descriptor of the log, locked exclusively by the caller
+ * \param path Path of the log
+ * \param properties Property names written after the log, NULL if none
+ * \param values Their values
+ * \param n_properties Number of properties
+ *
+ * \return TRUE if the log was compacted
+ */
+static gboolean
+overlay_compact(const ClpAppMgrAppNames *names, gint fd, const gchar *path,
+		const gchar * const *properties, const gchar * const *values, guint n_properties)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	GHashTable *table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+	GKeyFile *keyfile = g_key_file_new();
+	GHashTableIter iter;
+	gpointer key, value;
+	gchar *data = NULL;
+	gsize length;
+	gboolean res = FALSE;
+	guint i;
+
+	if (!g_file_get_contents(path, &data, &length, NULL)
+		|| !g_key_file_load_from_file(keyfile, names->desktop_file, G_KEY_FILE_KEEP_COMMENTS | G_KEY_FILE_KEEP_TRANSLATIONS, NULL))
+		goto out;
+	overlay_parse(data, length, table);
+	g_free(data);
+
+	g_hash_table_iter_init(&iter, table);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+		g_key_file_set_value(keyfile, g_key_file_get_start_group(keyfile), key, value);
+	for (i = 0; i < n_properties; i++)
+		g_key_file_set_value(keyfile, g_key_file_get_start_group(keyfile), properties[i], values[i] ? values[i] : "");
+
+	data = g_key_file_to_data(keyfile, &length, NULL);
+	if (data == NULL || !g_file_set_contents(names->desktop_file, data, length, NULL))
+	{
+		CLP_APPMGR_WARN_V("Unable to compact %s into %s", path, names->desktop_file);
+		goto out;
+	}
+	if (ftruncate(fd, 0) < 0)
+		CLP_APPMGR_WARN_V("Unable to empty %s : %s", path, g_strerror(errno));
+	else
+	{
+		CLP_APPMGR_INFO_V("%s compacted into %s", path, names->desktop_file);
+		res = TRUE;
+	}
+
+out:
+	g_free(data);
+	g_key_file_free(keyfile);
+	g_hash_table_destroy(table);
+	CLP_APPMGR_EXIT_FUNCTION();
+	return res;
+}
+
+
+/** \brief Look a property up in the log of an application
+ *
+ * \param application Name of the application
+ * \param property The property name
+ * \param value Returns the value, to be freed, if the property is in the log
+ *
+ * \return TRUE if the property is in the log, else the desktop file is to be read
+ */
+gboolean
+clp_app_mgr_overlay_lookup(const gchar *application, const gchar *property, gchar **value)
+{
+	const ClpAppMgrAppNames *names = clp_app_mgr_app_names_get(application);
+	const gchar *found;
+
+	G_LOCK(overlay);
+	found = g_hash_table_lookup(overlay_get_locked(names), property);
+	if (found)
+		*value = g_strdup(found);
+	G_UNLOCK(overlay);
+	return found != NULL;
+}
+
+
+/** \brief Append properties to the log of an application
+ *
+ * \param application Name of the application
+ * \param properties The property names
+ * \param values Their values
+ * \param n_properties Number of properties
+ *
+ * \return TRUE if the values were appended, or written to the desktop file with the log. FALSE if the log cannot
+ * be written, the desktop file is to be rewritten instead.
+ */
+gboolean
+clp_app_mgr_overlay_set(const gchar *application, const gchar * const *properties, const gchar * const *values, guint n_properties)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	const ClpAppMgrAppNames *names = clp_app_mgr_app_names_get(application);
+	GString *record;
+	gchar *path;
+	struct stat st;
+	gboolean res = FALSE, compacted = FALSE, write_through = overlay_needs_write_through(properties, n_properties);
+	gint fd;
+	guint i;
+
+	G_LOCK(overlay);
+	res = overlay_ensure_dir_locked();
+	G_UNLOCK(overlay);
+	if (!res)
+	{
+		CLP_APPMGR_EXIT_FUNCTION();
+		return FALSE;
+	}
+
+	record = g_string_new(NULL);
+	for (i = 0; i < n_properties; i++)
+	{
+		gchar *escaped = g_strescape(values[i] ? values[i] : "", NULL);
+		g_string_append_printf(record, "%s=%s\n", properties[i], escaped);
+		g_free(escaped);
+	}
+
+	path = overlay_path(names);
+	fd = open(path, O_WRONLY | O_APPEND | O_CREAT, 0644);
+	if (fd < 0 || flock(fd, LOCK_EX) < 0 || fstat(fd, &st) < 0)
+	{
+		CLP_APPMGR_WARN_V("Unable to open %s : %s", path, g_strerror(errno));
+		res = FALSE;
+	}
+	else if (write_through)
+	{
+		/* the log goes first so none of its older values shadows the batch afterwards */
+		res = compacted = overlay_compact(names, fd, path, properties, values, n_properties);
+	}
+	else if (write(fd, record->str, record->len) != (ssize_t) record->len)
+	{
+		CLP_APPMGR_WARN_V("Unable to append to %s : %s", path, g_strerror(errno));
+		/* drop a partial line, the next append must start on a line of its own */
+		ftruncate(fd, st.st_size);
+		res = FALSE;
+	}
+	else if (fstat(fd, &st) == 0 && st.st_size > CLP_APP_MGR_OVERLAY_MAX_SIZE)
+		compacted = overlay_compact(names, fd, path, NULL, NULL, 0);
+	if (fd >= 0)
+		close(fd);
+	g_free(path);
+	g_string_free(record, TRUE);
+
+	/* Revalidate the caches now rather than on the inotify event */
+	if (res)
+		clp_app_mgr_monitor_bump(CLP_APP_MGR_MONITOR_OVERLAY);
+	if (compacted)
+	{
+		clp_app_mgr_monitor_bump(CLP_APP_MGR_MONITOR_DESKTOP);
+		clp_app_mgr_desktop_db_schedule_compile();
+	}
+	CLP_APPMGR_EXIT_FUNCTION();
+	return res;
+}
@@ -0,0 +1,30 @@
+/** \file clp-app-mgr-overlay.h
+ * \brief Overlay property store of the Application Manager Library
+ *
+ * clp_app_mgr_set_property() appends the new values to a small per application log under
+ * CLP_APP_MGR_OVERLAY_DIR instead of rewriting the desktop file. clp_app_mgr_get_property() reads the log over
+ * the desktop file, the last value appended for a key wins. Once a log grows past CLP_APP_MGR_OVERLAY_MAX_SIZE
+ * it is compacted: its values are written into the desktop file with one atomic rewrite and the log is emptied.
+ * The keys the library itself reads from the desktop files, through the desktop database, the service index
+ * or the string classifier (see CLP_APP_MGR_OVERLAY_WRITE_THROUGH_KEYS), are not kept in the log: a batch
+ * setting one of them compacts the log together with the batch right away.
+ * The directory is watched by the monitor (CLP_APP_MGR_MONITOR_OVERLAY), so an append by another process is seen
+ * on the next lookup.
+ * This header is internal to the library, it is not installed.
+ */
+
+#ifndef __CLP_APP_MGR_OVERLAY_H__
+#define __CLP_APP_MGR_OVERLAY_H__
+
+#include <glib.h>
+
+#define CLP_APP_MGR_OVERLAY_DIR			CLP_APP_MGR_STATE_DIR "overlay/"	/**< directory of the logs */
+#define CLP_APP_MGR_OVERLAY_SUFFIX		".log"				/**< suffix of a log, after the application name */
+#define CLP_APP_MGR_OVERLAY_MAX_SIZE		4096				/**< size in bytes above which a log is compacted */
+#define CLP_APP_MGR_OVERLAY_WRITE_THROUGH_KEYS	"Name", "Exec", "ExecType", "X-ExecType", "Services", "X-Services", \
+						"MimeType", CLP_APP_MGR_CLASSIFY_PATTERNS_KEY	/**< keys written to the desktop file at once */
+
+gboolean clp_app_mgr_overlay_lookup (const gchar *application, const gchar *property, gchar **value);
+gboolean clp_app_mgr_overlay_set (const gchar *application, const gchar * const *properties, const gchar * const *values, guint n_properties);
+
+#endif /*__CLP_APP_MGR_OVERLAY_H__ */
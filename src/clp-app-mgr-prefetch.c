@@ -0,0 +1,85 @@
+/** \file clp-app-mgr-prefetch.c
+ *
+ * \brief Parallel read-ahead of files of the Application Manager Library
+ *
+ * Implementation of the read-ahead described in clp-app-mgr-prefetch.h. A pool is created for each batch and
+ * freed once every file of the batch has been read, so no thread outlives the call.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <glib.h>
+#include "clp-app-mgr-config.h"
+#include "clp-app-mgr-prefetch.h"
+
+
+/** \brief Read the start of one file, run by the workers
+ *
+ * \param data Path of the file
+ * \param user_data Number of bytes to read
+ */
+static void
+prefetch_read(gpointer data, gpointer user_data)
+{
+	gsize length = GPOINTER_TO_SIZE(user_data);
+	struct stat st;
+	gchar *buffer;
+	gint fd;
+
+	fd = open((const gchar*) data, O_RDONLY);
+	if (fd < 0)
+		return;
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+	{
+		buffer = g_malloc(length);
+		while (read(fd, buffer, length) < 0 && errno == EINTR)
+			;
+		g_free(buffer);
+	}
+	close(fd);
+}
+
+
+/** \brief Read the start of many files in parallel
+ *
+ * \param paths Paths of the files
+ * \param n_paths Number of paths
+ * \param length Number of bytes to read from the start of each file, CLP_APP_MGR_PREFETCH_LENGTH at least
+ *
+ * Returns once all the files have been read. Nothing is done for a single file, nor when no thread can be
+ * started, which includes a caller that did not go through clp_app_mgr_init(), where the thread system is
+ * initialised: the files are then read by whoever sniffs them, as before.
+ */
+void
+clp_app_mgr_prefetch_files(const gchar * const *paths, guint n_paths, gsize length)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	GThreadPool *pool;
+	GError *error = NULL;
+	guint i;
+
+	if (n_paths < 2 || !g_thread_supported())
+	{
+		CLP_APPMGR_EXIT_FUNCTION();
+		return;
+	}
+
+	pool = g_thread_pool_new(prefetch_read, GSIZE_TO_POINTER(MAX(length, CLP_APP_MGR_PREFETCH_LENGTH)),
+		MIN(n_paths, CLP_APP_MGR_PREFETCH_THREADS), TRUE, &error);
+	if (pool == NULL)
+	{
+		CLP_APPMGR_WARN_V("Unable to start the read-ahead threads: %s", error ? error->message : "unknown error");
+		if (error)
+			g_error_free(error);
+		CLP_APPMGR_EXIT_FUNCTION();
+		return;
+	}
+	for (i = 0; i < n_paths; i++)
+		if (paths[i])
+			g_thread_pool_push(pool, (gpointer) paths[i], NULL);
+	g_thread_pool_free(pool, FALSE, TRUE);
+
+	CLP_APPMGR_EXIT_FUNCTION();
+}
@@ -0,0 +1,21 @@
+/** \file clp-app-mgr-prefetch.h
+ * \brief Parallel read-ahead of files of the Application Manager Library
+ *
+ * Sniffing the MIME type of a file opens it and reads its first bytes. When many files are handled at once, the
+ * reads are issued from a small pool of worker threads before the files are sniffed, so the sniffing itself,
+ * which xdgmime does not allow from several threads, runs from the page cache. The workers only read, the
+ * result of a failed read is the one the sniffing will find again.
+ * This header is internal to the library, it is not installed.
+ */
+
+#ifndef __CLP_APP_MGR_PREFETCH_H__
+#define __CLP_APP_MGR_PREFETCH_H__
+
+#include <glib.h>
+
+#define CLP_APP_MGR_PREFETCH_THREADS		4			/**< largest number of files read at the same time */
+#define CLP_APP_MGR_PREFETCH_LENGTH		4096			/**< bytes read at least from the start of each file */
+
+void clp_app_mgr_prefetch_files (const gchar * const *paths, guint n_paths, gsize length);
+
+#endif /*__CLP_APP_MGR_PREFETCH_H__ */
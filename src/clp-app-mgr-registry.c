@@ -0,0 +1,77 @@
+/** \file clp-app-mgr-registry.c
+ *
+ * \brief Shared gconf client of the Application Manager Library
+ *
+ * Implementation of the client described in clp-app-mgr-registry.h.
+ */
+
+#include <glib.h>
+#include <gconf/gconf-client.h>
+#include "clp-app-mgr-config.h"
+#include "clp-app-mgr-registry.h"
+
+static struct
+{
+	GConfClient	*client;				/**< client shared by the whole library */
+	gboolean	watch_requested;			/**< a module of the library installed a notification */
+	gboolean	watched;				/**< GCONF_APPS_DIR was added to the client and preloaded */
+}registry = { NULL, FALSE, FALSE };
+G_LOCK_DEFINE_STATIC (registry);
+
+
+/** \brief Get the shared gconf client
+ *
+ * \return The client, owned by the library: it must not be unreffed
+ *
+ * Once a notification was requested, see clp_app_mgr_registry_watch(), the first call made from the thread
+ * owning the default main context adds GCONF_APPS_DIR to the client and preloads it. From then on gconf keeps
+ * the cache current through the notifications the main loop delivers.
+ */
+GConfClient*
+clp_app_mgr_registry_client(void)
+{
+	G_LOCK(registry);
+	if (registry.client == NULL)
+		registry.client = gconf_client_get_default();
+	if (registry.watch_requested && !registry.watched && g_main_context_is_owner(g_main_context_default()))
+	{
+		CLP_APPMGR_INFO_V("Watching and preloading %s", GCONF_APPS_DIR);
+		gconf_client_add_dir(registry.client, GCONF_APPS_DIR, GCONF_CLIENT_PRELOAD_RECURSIVE, NULL);
+		registry.watched = TRUE;
+	}
+	G_UNLOCK(registry);
+
+	return registry.client;
+}
+
+
+/** \brief Have the gconf notifications of GCONF_APPS_DIR delivered to the process
+ *
+ * Called by the modules installing a notification on GCONF_APPS_DIR. The directory is added right away when
+ * called from the thread owning the default main context, else on the next clp_app_mgr_registry_client() call
+ * made from it.
+ */
+void
+clp_app_mgr_registry_watch(void)
+{
+	G_LOCK(registry);
+	registry.watch_requested = TRUE;
+	G_UNLOCK(registry);
+	clp_app_mgr_registry_client();
+}
+
+
+/** \brief Check that the gconf notifications of GCONF_APPS_DIR are delivered
+ *
+ * \return TRUE once GCONF_APPS_DIR was added to the client, until then a notification never fires
+ */
+gboolean
+clp_app_mgr_registry_is_watched(void)
+{
+	gboolean watched;
+
+	G_LOCK(registry);
+	watched = registry.watched;
+	G_UNLOCK(registry);
+	return watched;
+}
@@ -0,0 +1,22 @@
+/** \file clp-app-mgr-registry.h
+ * \brief Shared gconf client of the Application Manager Library
+ *
+ * The library reads the application registry through one GConfClient for the whole process. Until something in
+ * the process watches the registry, no directory is added to the client: nothing is cached and every read goes
+ * to gconfd, as it always did. A module that installs a gconf notification calls clp_app_mgr_registry_watch().
+ * GCONF_APPS_DIR is then added and preloaded by the thread running the default main loop, which delivers the
+ * notifications that keep the client side cache current. gconf is not thread safe, the cache is only ever filled
+ * from that thread.
+ * This header is internal to the library, it is not installed.
+ */
+
+#ifndef __CLP_APP_MGR_REGISTRY_H__
+#define __CLP_APP_MGR_REGISTRY_H__
+
+#include <gconf/gconf-client.h>
+
+GConfClient* clp_app_mgr_registry_client (void);
+void clp_app_mgr_registry_watch (void);
+gboolean clp_app_mgr_registry_is_watched (void);
+
+#endif /*__CLP_APP_MGR_REGISTRY_H__ */
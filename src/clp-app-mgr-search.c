@@ -0,0 +1,386 @@
+/** \file clp-app-mgr-search.c
+ *
+ * \brief Search over the installed applications
+ *
+ * The Name, GenericName and exec name of every application of the menu index are case folded once, and every
+ * byte trigram of them is posted in a hash table. A query first narrows the applications down with the posting
+ * lists of its trigrams, then checks the few remaining ones with strstr() and ranks them. Applications sharing
+ * enough trigrams with the query without containing it are returned after the exact matches, so a typo still
+ * finds the application.
+ *
+ * A ClpAppMgrSearch handle keeps the matches of the previous query: when the user types one more character the
+ * new query contains the old one, and only the previous matches need to be checked again.
+ */
+
+#include <string.h>
+#include <glib.h>
+#include "clp-app-mgr-lib.h"
+#include "clp-app-mgr-config.h"
+
+#define SEARCH_FIELD_NAME		0
+#define SEARCH_FIELD_GENERIC_NAME	1
+#define SEARCH_FIELD_EXEC_NAME		2
+#define SEARCH_N_FIELDS			3
+
+#define SEARCH_TRIGRAM(s)		(((guint32)(guchar)(s)[0] << 16) | ((guint32)(guchar)(s)[1] << 8) | (guint32)(guchar)(s)[2])
+
+typedef struct _ClpAppMgrSearchIndex				/**< Search index of one menu index */
+{
+	volatile gint	ref_count;				/**< references held by the library and the search handles */
+	ClpAppMgrMenuIndex	*menu;				/**< menu index the records belong to */
+	ClpAppMgrInstalledApp * const	*apps;			/**< all the applications, in menu order */
+	guint		n_apps;					/**< number of applications */
+	gchar		**folded;				/**< SEARCH_N_FIELDS case folded strings per application, NULL if unset */
+	GHashTable	*postings;				/**< trigram -> GArray of sorted application indices */
+}ClpAppMgrSearchIndex;
+
+struct _ClpAppMgrSearch
+{
+	ClpAppMgrSearchIndex	*index;				/**< index the state below refers to */
+	gchar		*query;					/**< case folded previous query, NULL if none */
+	GArray		*matches;				/**< indices of the applications containing the previous query */
+	GArray		*ranked;				/**< scratch array of ClpAppMgrSearchHit */
+	GPtrArray	*results;				/**< records returned by the last update */
+	guint		*hits;					/**< scratch trigram hit counter per application */
+};
+
+typedef struct _ClpAppMgrSearchHit				/**< One ranked match */
+{
+	guint		app;					/**< application index */
+	gint		score;					/**< higher is better */
+}ClpAppMgrSearchHit;
+
+static ClpAppMgrSearchIndex *current_search_index = NULL;	/**< search index shared by all the handles of this process */
+G_LOCK_DEFINE_STATIC (current_search_index);
+
+
+static void
+search_posting_free(gpointer posting)
+{
+	g_array_free(posting, TRUE);
+}
+
+
+/** \brief Post every trigram of a string for an application */
+static void
+search_index_add(ClpAppMgrSearchIndex *index, const gchar *folded, guint app)
+{
+	gsize len, i;
+
+	if (folded == NULL)
+		return;
+	len = strlen(folded);
+	for (i = 0; i + 3 <= len; i++)
+	{
+		gpointer key = GUINT_TO_POINTER(SEARCH_TRIGRAM(folded + i));
+		GArray *posting = g_hash_table_lookup(index->postings, key);
+
+		if (posting == NULL)
+		{
+			posting = g_array_new(FALSE, FALSE, sizeof(guint));
+			g_hash_table_insert(index->postings, key, posting);
+		}
+		/* applications are added in increasing order, a repeated trigram is the last entry */
+		if (posting->len == 0 || g_array_index(posting, guint, posting->len - 1) != app)
+			g_array_append_val(posting, app);
+	}
+}
+
+
+static void
+search_index_unref(ClpAppMgrSearchIndex *index)
+{
+	guint i;
+
+	if (index == NULL || !g_atomic_int_dec_and_test(&index->ref_count))
+		return;
+	for (i = 0; i < index->n_apps * SEARCH_N_FIELDS; i++)
+		g_free(index->folded[i]);
+	g_free(index->folded);
+	g_hash_table_destroy(index->postings);
+	clp_app_mgr_menu_index_unref(index->menu);
+	g_free(index);
+}
+
+
+/** \brief Get the search index of the current menu index, building it if the menu index was rebuilt
+ *
+ * \return A reference to the index
+ */
+static ClpAppMgrSearchIndex*
+search_index_get(void)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	ClpAppMgrMenuIndex *menu = clp_app_mgr_menu_index_get();
+	ClpAppMgrSearchIndex *index, *stale = NULL;
+	guint i;
+
+	G_LOCK(current_search_index);
+	if (current_search_index && current_search_index->menu == menu)
+	{
+		index = current_search_index;
+		clp_app_mgr_menu_index_unref(menu);
+	}
+	else
+	{
+		stale = current_search_index;
+		index = g_new0(ClpAppMgrSearchIndex, 1);
+		index->ref_count = 1;
+		index->menu = menu;
+		index->apps = clp_app_mgr_menu_index_lookup(menu, "/", TRUE, &index->n_apps);
+		index->folded = g_new0(gchar *, index->n_apps * SEARCH_N_FIELDS + 1);
+		index->postings = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, search_posting_free);
+
+		for (i = 0; i < index->n_apps; i++)
+		{
+			gchar **fields = index->folded + i * SEARCH_N_FIELDS;
+
+			if (index->apps[i]->name)
+				fields[SEARCH_FIELD_NAME] = g_utf8_casefold(index->apps[i]->name, -1);
+			if (index->apps[i]->generic_name)
+				fields[SEARCH_FIELD_GENERIC_NAME] = g_utf8_casefold(index->apps[i]->generic_name, -1);
+			if (index->apps[i]->exec_name)
+				fields[SEARCH_FIELD_EXEC_NAME] = g_utf8_casefold(index->apps[i]->exec_name, -1);
+
+			search_index_add(index, fields[SEARCH_FIELD_NAME], i);
+			search_index_add(index, fields[SEARCH_FIELD_GENERIC_NAME], i);
+			search_index_add(index, fields[SEARCH_FIELD_EXEC_NAME], i);
+		}
+		current_search_index = index;
+		CLP_APPMGR_INFO_V("Search index built with %u applications and %u trigrams", index->n_apps, g_hash_table_size(index->postings));
+	}
+	g_atomic_int_inc(&index->ref_count);
+	G_UNLOCK(current_search_index);
+
+	search_index_unref(stale);
+	CLP_APPMGR_EXIT_FUNCTION();
+	return index;
+}
+
+
+/** \brief Score of a field containing the query
+ *
+ * \return prefix_score if the field starts with the query, word_score if a word of the field does,
+ * substring_score if it contains it elsewhere, 0 if it does not contain it
+ */
+static gint
+search_score_field(const gchar *field, const gchar *query, gint prefix_score, gint word_score, gint substring_score)
+{
+	const gchar *match;
+	gint score = 0;
+
+	if (field == NULL)
+		return 0;
+	for (match = strstr(field, query); match; match = strstr(match + 1, query))
+	{
+		if (match == field)
+			return prefix_score;
+		if (strchr(" -_./", match[-1]))
+			return word_score;
+		score = substring_score;
+	}
+	return score;
+}
+
+
+/** \brief Score of an application for the query, 0 if none of its fields contains it */
+static gint
+search_score(ClpAppMgrSearchIndex *index, guint app, const gchar *query)
+{
+	gchar **fields = index->folded + app * SEARCH_N_FIELDS;
+	gint score;
+
+	score = search_score_field(fields[SEARCH_FIELD_NAME], query, 1000, 800, 600);
+	if (score)
+		return score;
+	score = search_score_field(fields[SEARCH_FIELD_GENERIC_NAME], query, 400, 350, 300);
+	if (score)
+		return score;
+	return search_score_field(fields[SEARCH_FIELD_EXEC_NAME], query, 200, 175, 150);
+}
+
+
+/** \brief Best matches first, then shorter names, then menu order */
+static gint
+search_hit_compare(gconstpointer a, gconstpointer b, gpointer data)
+{
+	const ClpAppMgrSearchHit *hit_a = a, *hit_b = b;
+	ClpAppMgrSearchIndex *index = data;
+	gsize len_a, len_b;
+
+	if (hit_a->score != hit_b->score)
+		return hit_b->score - hit_a->score;
+	len_a = strlen(index->apps[hit_a->app]->name);
+	len_b = strlen(index->apps[hit_b->app]->name);
+	if (len_a != len_b)
+		return (len_a < len_b) ? -1 : 1;
+	return (hit_a->app < hit_b->app) ? -1 : (hit_a->app > hit_b->app);
+}
+
+
+/** \brief Create a search handle
+ *
+ * \return New search handle, free with clp_app_mgr_search_free()
+ *
+ * Create one handle per search box and feed it every state of the query with clp_app_mgr_search_update().
+ */
+ClpAppMgrSearch*
+clp_app_mgr_search_new(void)
+{
+	ClpAppMgrSearch *search = g_new0(ClpAppMgrSearch, 1);
+
+	search->matches = g_array_new(FALSE, FALSE, sizeof(guint));
+	search->ranked = g_array_new(FALSE, FALSE, sizeof(ClpAppMgrSearchHit));
+	search->results = g_ptr_array_new();
+	return search;
+}
+
+
+/** \brief Free a search handle
+ *
+ * \param search Handle returned by clp_app_mgr_search_new()
+ */
+void
+clp_app_mgr_search_free(ClpAppMgrSearch *search)
+{
+	if (search == NULL)
+		return;
+	search_index_unref(search->index);
+	g_free(search->query);
+	g_array_free(search->matches, TRUE);
+	g_array_free(search->ranked, TRUE);
+	g_ptr_array_free(search->results, TRUE);
+	g_free(search->hits);
+	g_free(search);
+}
+
+
+/** \brief Search the installed applications
+ *
+ * \param search Search handle
+ * \param query Text typed by the user, matched case insensitively against Name, GenericName and exec name
+ * \param n_matches Returns the number of matches
+ *
+ * \return Matching applications, best first. The array and the records are owned by the handle and stay valid
+ * until the next update or clp_app_mgr_search_free(). NULL if nothing matches or the query is empty.
+ *
+ * Applications containing the query come first: name prefix, then word prefix or substring of the name, then
+ * GenericName and exec name. They are followed by the applications sharing at least half of the trigrams of the
+ * query. When the query extends the previous one, only the previous matches are checked again.
+ */
+ClpAppMgrInstalledApp* const*
+clp_app_mgr_search_update(ClpAppMgrSearch *search, const gchar *query, guint *n_matches)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	ClpAppMgrSearchIndex *index = search_index_get();
+	GArray *candidates = NULL;
+	gchar *folded;
+	gsize len, i;
+	guint j, n_trigrams = 0;
+
+	*n_matches = 0;
+	g_ptr_array_set_size(search->results, 0);
+	g_array_set_size(search->ranked, 0);
+
+	if (index != search->index)
+	{
+		/* the menu index was rebuilt, the previous matches refer to the old index */
+		search_index_unref(search->index);
+		search->index = index;
+		g_free(search->query);
+		search->query = NULL;
+		g_free(search->hits);
+		search->hits = g_new0(guint, index->n_apps);
+	}
+	else
+		search_index_unref(index);
+
+	folded = g_utf8_casefold(query ? query : "", -1);
+	len = strlen(folded);
+	if (len == 0)
+	{
+		g_free(search->query);
+		search->query = NULL;
+		g_free(folded);
+		CLP_APPMGR_EXIT_FUNCTION();
+		return NULL;
+	}
+
+	/* Exact candidates: the previous matches if the query grew, else the shortest trigram posting list */
+	if (search->query && strstr(folded, search->query))
+	{
+		candidates = g_array_sized_new(FALSE, FALSE, sizeof(guint), search->matches->len);
+		g_array_append_vals(candidates, search->matches->data, search->matches->len);
+	}
+	else if (len >= 3)
+	{
+		GArray *shortest = NULL;
+
+		for (i = 0; i + 3 <= len; i++)
+		{
+			GArray *posting = g_hash_table_lookup(index->postings, GUINT_TO_POINTER(SEARCH_TRIGRAM(folded + i)));
+			if (posting == NULL || shortest == NULL || posting->len < shortest->len)
+				shortest = posting;
+			if (shortest == NULL)
+				break;
+		}
+		candidates = g_array_new(FALSE, FALSE, sizeof(guint));
+		if (shortest)
+			g_array_append_vals(candidates, shortest->data, shortest->len);
+	}
+	else
+	{
+		candidates = g_array_sized_new(FALSE, FALSE, sizeof(guint), index->n_apps);
+		for (j = 0; j < index->n_apps; j++)
+			g_array_append_val(candidates, j);
+	}
+
+	g_array_set_size(search->matches, 0);
+	for (j = 0; j < candidates->len; j++)
+	{
+		ClpAppMgrSearchHit hit;
+
+		hit.app = g_array_index(candidates, guint, j);
+		hit.score = search_score(index, hit.app, folded);
+		if (hit.score == 0)
+			continue;
+		g_array_append_val(search->matches, hit.app);
+		g_array_append_val(search->ranked, hit);
+	}
+	g_array_free(candidates, TRUE);
+
+	/* Approximate matches: count the trigrams of the query each application has */
+	if (len >= 3)
+	{
+		for (i = 0; i + 3 <= len; i++, n_trigrams++)
+		{
+			GArray *posting = g_hash_table_lookup(index->postings, GUINT_TO_POINTER(SEARCH_TRIGRAM(folded + i)));
+			if (posting)
+				for (j = 0; j < posting->len; j++)
+					search->hits[g_array_index(posting, guint, j)]++;
+		}
+		for (j = 0; j < search->matches->len; j++)
+			search->hits[g_array_index(search->matches, guint, j)] = 0;
+		for (j = 0; j < index->n_apps; j++)
+		{
+			if (search->hits[j] && search->hits[j] * 2 >= n_trigrams)
+			{
+				ClpAppMgrSearchHit hit;
+				hit.app = j;
+				hit.score = search->hits[j] * 100 / n_trigrams;
+				g_array_append_val(search->ranked, hit);
+			}
+			search->hits[j] = 0;
+		}
+	}
+
+	g_qsort_with_data(search->ranked->data, search->ranked->len, sizeof(ClpAppMgrSearchHit), search_hit_compare, index);
+	for (j = 0; j < search->ranked->len; j++)
+		g_ptr_array_add(search->results, index->apps[g_array_index(search->ranked, ClpAppMgrSearchHit, j).app]);
+
+	g_free(search->query);
+	search->query = folded;
+	*n_matches = search->results->len;
+	CLP_APPMGR_EXIT_FUNCTION();
+	return search->results->len ? (ClpAppMgrInstalledApp * const *) search->results->pdata : NULL;
+}
@@ -0,0 +1,410 @@
+/** \file clp-app-mgr-service-index.c
+ *
+ * \brief Service index of the Application Manager Library
+ *
+ * Implementation of the index described in clp-app-mgr-service-index.h. The services of all the applications are
+ * stored in one array, each application pointing to its run of records; every string of the index lives in one
+ * string chunk, so dropping an index is a handful of frees.
+ */
+
+#include <string.h>
+#include <glib.h>
+#include "clp-app-mgr-config.h"
+#include "clp-app-mgr-service-index.h"
+#include "clp-app-mgr-desktop-db.h"
+#include "clp-app-mgr-monitor.h"
+#include "clp-app-mgr-keyfile.h"
+
+typedef struct _ClpAppMgrServiceIndexApp			/**< One application of the index */
+{
+	guint		first_service;				/**< index of its first service in the services array */
+	guint		n_services;				/**< number of its services */
+	GPtrArray	*mime_types;				/**< lower case MIME types it handles, in mimeinfo.cache order */
+}ClpAppMgrServiceIndexApp;
+
+struct _ClpAppMgrServiceIndex
+{
+	volatile gint	ref_count;				/**< references held by the library and the callers */
+	guint		desktop_generation;			/**< desktop generation the index was read at */
+	guint		mime_generation;			/**< mime generation the index was read at */
+	GStringChunk	*strings;				/**< every string of the index */
+	GArray		*services;				/**< ClpAppMgrServices of all the applications */
+	GHashTable	*apps;					/**< application name to ClpAppMgrServiceIndexApp */
+	GHashTable	*mimes;					/**< lower case MIME type to GPtrArray of application names */
+	GHashTable	*providers;				/**< service name to the smallest name of the applications offering it */
+};
+
+static ClpAppMgrServiceIndex *current_index = NULL;		/**< index shared by all the callers of this process */
+G_LOCK_DEFINE_STATIC (current_index);
+
+
+/** \brief Free an application, as the value destroy function of the applications table */
+static void
+service_index_app_free(gpointer data)
+{
+	ClpAppMgrServiceIndexApp *app = data;
+
+	g_ptr_array_free(app->mime_types, TRUE);
+	g_free(app);
+}
+
+
+/** \brief Free a handler list, as the value destroy function of the MIME types table */
+static void
+service_index_handlers_free(gpointer data)
+{
+	g_ptr_array_free(data, TRUE);
+}
+
+
+/** \brief Get the entry of an application, adding it if needed
+ *
+ * \param name Name of the application, copied into the index
+ *
+ * \return The entry
+ */
+static ClpAppMgrServiceIndexApp*
+service_index_app(ClpAppMgrServiceIndex *index, const gchar *name)
+{
+	ClpAppMgrServiceIndexApp *app = g_hash_table_lookup(index->apps, name);
+
+	if (app == NULL)
+	{
+		app = g_new0(ClpAppMgrServiceIndexApp, 1);
+		app->mime_types = g_ptr_array_new();
+		g_hash_table_insert(index->apps, (gpointer) g_string_chunk_insert_const(index->strings, name), app);
+	}
+	return app;
+}
+
+
+/** \brief Add a value to a list unless it is there already */
+static void
+service_index_add_unique(GPtrArray *list, const gchar *value)
+{
+	guint i;
+
+	for (i = 0; i < list->len; i++)
+		if (list->pdata[i] == value)
+			return;
+	g_ptr_array_add(list, (gpointer) value);
+}
+
+
+/** \brief Add the handlers of one MIME type, called for each key of mimeinfo.cache */
+static gboolean
+service_index_add_mime(const ClpAppMgrKeyFileEntry *entry, gpointer user_data)
+{
+	ClpAppMgrServiceIndex *index = user_data;
+	GPtrArray *handlers;
+	gchar *mime_type;
+	const gchar *key, *p, *end, *next;
+
+	if (!clp_app_mgr_keyfile_entry_in_group(entry, "MIME Cache"))
+		return TRUE;
+
+	mime_type = g_ascii_strdown(entry->key, entry->key_len);
+	key = g_string_chunk_insert_const(index->strings, mime_type);
+	g_free(mime_type);
+	handlers = g_hash_table_lookup(index->mimes, key);
+	if (handlers == NULL)
+	{
+		handlers = g_ptr_array_new();
+		g_hash_table_insert(index->mimes, (gpointer) key, handlers);
+	}
+
+	for (p = entry->value, end = entry->value + entry->value_len; p < end; p = next + 1)
+	{
+		gsize len;
+		gchar *name;
+		const gchar *app_name;
+
+		next = memchr(p, ';', end - p);
+		if (next == NULL)
+			next = end;
+		len = next - p;
+		if (len >= strlen(".desktop") && !strncmp(next - strlen(".desktop"), ".desktop", strlen(".desktop")))
+			len -= strlen(".desktop");
+		if (len == 0)
+			continue;
+
+		name = g_strndup(p, len);
+		app_name = g_string_chunk_insert_const(index->strings, name);
+		g_free(name);
+		service_index_add_unique(handlers, app_name);
+		service_index_add_unique(service_index_app(index, app_name)->mime_types, key);
+	}
+	return TRUE;
+}
+
+
+/** \brief Read the handlers of every MIME type from mimeinfo.cache */
+static void
+service_index_read_mimes(ClpAppMgrServiceIndex *index)
+{
+	if (!clp_app_mgr_keyfile_parse(APPLICATION_INFO_PATH"mimeinfo.cache", service_index_add_mime, index))
+		CLP_APPMGR_WARN("Unable to read mimeinfo.cache, no MIME type has a handler");
+}
+
+
+/** \brief Record an application offering a service, keeping the smallest name when several do */
+static void
+service_index_add_provider(ClpAppMgrServiceIndex *index, const gchar *service, const gchar *name)
+{
+	const gchar *current = g_hash_table_lookup(index->providers, service);
+
+	if (current && current != name)
+		CLP_APPMGR_INFO_V("Service %s is offered by %s and %s", service, current, name);
+	if (current == NULL || strcmp(name, current) < 0)
+		g_hash_table_insert(index->providers, (gpointer) service, (gpointer) name);
+}
+
+
+/** \brief Add the services of one application
+ *
+ * \param name Name of the application
+ * \param app_name Value of its Name key
+ * \param app_exec_name Value of its Exec key
+ * \param services Value of its Services key, "service,menu;service,menu;...", NULL if none
+ *
+ * The list ends at its first empty entry, a service without menu string uses its name as menu string.
+ */
+static void
+service_index_add_services(ClpAppMgrServiceIndex *index, const gchar *name, const gchar *app_name, const gchar *app_exec_name, const gchar *services)
+{
+	ClpAppMgrServiceIndexApp *app = service_index_app(index, name);
+	const gchar *provider = g_string_chunk_insert_const(index->strings, name);
+	gchar **entries;
+	guint i;
+
+	app->first_service = index->services->len;
+	app->n_services = 0;
+	if (services == NULL)
+		return;
+
+	entries = g_strsplit(services, ";", -1);
+	for (i = 0; entries[i] && *entries[i]; i++)
+	{
+		gchar **serv_menu = g_strsplit(entries[i], ",", 2);
+		ClpAppMgrServices service;
+
+		service.app_name = app_name ? (gchar *) g_string_chunk_insert_const(index->strings, app_name) : NULL;
+		service.app_exec_name = app_exec_name ? (gchar *) g_string_chunk_insert_const(index->strings, app_exec_name) : NULL;
+		service.service_name = (gchar *) g_string_chunk_insert_const(index->strings, serv_menu[0]);
+		service.service_menu = (gchar *) g_string_chunk_insert_const(index->strings, serv_menu[1] ? serv_menu[1] : serv_menu[0]);
+		g_array_append_val(index->services, service);
+		service_index_add_provider(index, service.service_name, provider);
+		app->n_services++;
+		g_strfreev(serv_menu);
+	}
+	g_strfreev(entries);
+}
+
+
+/** \brief Read the services of every application, from the compiled desktop database or the desktop files */
+static void
+service_index_read_services(ClpAppMgrServiceIndex *index)
+{
+	ClpAppMgrDesktopDb *db;
+	guint i;
+
+	if ((db = clp_app_mgr_desktop_db_get()) != NULL)
+	{
+		for (i = 0; i < clp_app_mgr_desktop_db_get_n_apps(db); i++)
+		{
+			const gchar *services = clp_app_mgr_desktop_db_get_value(db, i, "Services");
+			if (services == NULL)
+				services = clp_app_mgr_desktop_db_get_value(db, i, "X-Services");
+			service_index_add_services(index, clp_app_mgr_desktop_db_get_app_name(db, i),
+				clp_app_mgr_desktop_db_get_value(db, i, "Name"), clp_app_mgr_desktop_db_get_value(db, i, "Exec"), services);
+		}
+		clp_app_mgr_desktop_db_unref(db);
+		return;
+	}
+
+	GDir *dir = g_dir_open(APPLICATION_INFO_PATH, 0, NULL);
+	const gchar *file_name;
+	const gchar *keys[] = { "Name", "Exec", "Services", "X-Services", NULL };
+
+	while (dir && (file_name = g_dir_read_name(dir)))
+	{
+		gchar *path, *name, *values[4];
+
+		if (!g_str_has_suffix(file_name, ".desktop"))
+			continue;
+		path = g_strconcat(APPLICATION_INFO_PATH, file_name, NULL);
+		if (clp_app_mgr_keyfile_get_start_values(path, keys, values))
+		{
+			name = g_strndup(file_name, strlen(file_name) - strlen(".desktop"));
+			service_index_add_services(index, name, values[0], values[1], values[2] ? values[2] : values[3]);
+			g_free(name);
+			for (i = 0; i < G_N_ELEMENTS(values); i++)
+				g_free(values[i]);
+		}
+		else
+			CLP_APPMGR_WARN_V("Unable to read %s", path);
+		g_free(path);
+	}
+	if (dir)
+		g_dir_close(dir);
+}
+
+
+/** \brief Read the index */
+static ClpAppMgrServiceIndex*
+service_index_build(guint desktop_generation, guint mime_generation)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	ClpAppMgrServiceIndex *index = g_new0(ClpAppMgrServiceIndex, 1);
+
+	index->ref_count = 1;
+	index->desktop_generation = desktop_generation;
+	index->mime_generation = mime_generation;
+	index->strings = g_string_chunk_new(4096);
+	index->services = g_array_new(FALSE, FALSE, sizeof(ClpAppMgrServices));
+	index->apps = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, service_index_app_free);
+	index->mimes = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, service_index_handlers_free);
+	index->providers = g_hash_table_new(g_str_hash, g_str_equal);
+
+	service_index_read_mimes(index);
+	service_index_read_services(index);
+
+	CLP_APPMGR_INFO_V("Service index read, %u applications, %u services, %u MIME types",
+		g_hash_table_size(index->apps), index->services->len, g_hash_table_size(index->mimes));
+	CLP_APPMGR_EXIT_FUNCTION();
+	return index;
+}
+
+
+/** \brief Get the current index
+ *
+ * \return A reference to the index, to be released with clp_app_mgr_service_index_unref()
+ *
+ * The index is read on first use and again after the desktop files or mimeinfo.cache changed. The index handed
+ * out never changes, a caller holding it sees a consistent view.
+ */
+ClpAppMgrServiceIndex*
+clp_app_mgr_service_index_get(void)
+{
+	ClpAppMgrServiceIndex *index, *stale = NULL;
+	guint desktop_generation = clp_app_mgr_monitor_get_generation(CLP_APP_MGR_MONITOR_DESKTOP);
+	guint mime_generation = clp_app_mgr_monitor_get_generation(CLP_APP_MGR_MONITOR_MIME);
+
+	G_LOCK(current_index);
+	if (current_index == NULL || current_index->desktop_generation != desktop_generation
+		|| current_index->mime_generation != mime_generation)
+	{
+		stale = current_index;
+		current_index = service_index_build(desktop_generation, mime_generation);
+	}
+	index = current_index;
+	g_atomic_int_inc(&index->ref_count);
+	G_UNLOCK(current_index);
+	clp_app_mgr_service_index_unref(stale);
+	return index;
+}
+
+
+/** \brief Release a reference on an index
+ *
+ * \param index The index, NULL is ignored
+ */
+void
+clp_app_mgr_service_index_unref(ClpAppMgrServiceIndex *index)
+{
+	if (index == NULL || !g_atomic_int_dec_and_test(&index->ref_count))
+		return;
+	g_hash_table_destroy(index->providers);
+	g_hash_table_destroy(index->mimes);
+	g_hash_table_destroy(index->apps);
+	g_array_free(index->services, TRUE);
+	g_string_chunk_free(index->strings);
+	g_free(index);
+}
+
+
+/** \brief Get the handlers of a MIME type
+ *
+ * \param index The index
+ * \param mime_type MIME type, compared without case
+ * \param applications Returns the names of the handlers, the default handler first. Owned by the index.
+ *
+ * \return Number of handlers
+ */
+guint
+clp_app_mgr_service_index_get_handlers(ClpAppMgrServiceIndex *index, const gchar *mime_type, const gchar * const **applications)
+{
+	gchar *key = g_ascii_strdown(mime_type, -1);
+	GPtrArray *handlers = g_hash_table_lookup(index->mimes, key);
+
+	g_free(key);
+	if (handlers == NULL)
+	{
+		*applications = NULL;
+		return 0;
+	}
+	*applications = (const gchar * const *) handlers->pdata;
+	return handlers->len;
+}
+
+
+/** \brief Get the services of an application
+ *
+ * \param index The index
+ * \param application Name of the application (desktop file name without .desktop)
+ * \param services Returns the services, owned by the index
+ *
+ * \return Number of services
+ */
+guint
+clp_app_mgr_service_index_get_services(ClpAppMgrServiceIndex *index, const gchar *application, const ClpAppMgrServices **services)
+{
+	ClpAppMgrServiceIndexApp *app = g_hash_table_lookup(index->apps, application);
+
+	if (app == NULL || app->n_services == 0)
+	{
+		*services = NULL;
+		return 0;
+	}
+	*services = &g_array_index(index->services, ClpAppMgrServices, app->first_service);
+	return app->n_services;
+}
+
+
+/** \brief Get the MIME types an application handles
+ *
+ * \param index The index
+ * \param application Name of the application (desktop file name without .desktop)
+ * \param mime_types Returns the lower case MIME types, owned by the index
+ *
+ * \return Number of MIME types
+ */
+guint
+clp_app_mgr_service_index_get_mime_types(ClpAppMgrServiceIndex *index, const gchar *application, const gchar * const **mime_types)
+{
+	ClpAppMgrServiceIndexApp *app = g_hash_table_lookup(index->apps, application);
+
+	if (app == NULL || app->mime_types->len == 0)
+	{
+		*mime_types = NULL;
+		return 0;
+	}
+	*mime_types = (const gchar * const *) app->mime_types->pdata;
+	return app->mime_types->len;
+}
+
+
+/** \brief Get the application offering a service
+ *
+ * \param index The index
+ * \param service Name of the service, compared with case
+ *
+ * \return Name of the application (desktop file name without .desktop), owned by the index. NULL if no application
+ * offers the service. When several do, the one with the smallest name in strcmp() order, whatever the order the
+ * desktop files were read in.
+ */
+const gchar*
+clp_app_mgr_service_index_get_provider(ClpAppMgrServiceIndex *index, const gchar *service)
+{
+	return g_hash_table_lookup(index->providers, service);
+}
@@ -0,0 +1,27 @@
+/** \file clp-app-mgr-service-index.h
+ * \brief Service index of the Application Manager Library
+ *
+ * The services the applications offer (Services key of their desktop files) and the MIME types they handle
+ * (mimeinfo.cache) are read once into an index answering both directions from memory: the handlers of a MIME
+ * type, in mimeinfo.cache order, the services and MIME types of an application, and the application offering a
+ * service. The index is shared by reference and rebuilt when the desktop files or mimeinfo.cache change.
+ * This header is internal to the library, it is not installed.
+ */
+
+#ifndef __CLP_APP_MGR_SERVICE_INDEX_H__
+#define __CLP_APP_MGR_SERVICE_INDEX_H__
+
+#include <glib.h>
+#include "clp-app-mgr-lib.h"
+
+typedef struct _ClpAppMgrServiceIndex ClpAppMgrServiceIndex;	/**< Opaque handle of an index */
+
+ClpAppMgrServiceIndex* clp_app_mgr_service_index_get (void);
+void clp_app_mgr_service_index_unref (ClpAppMgrServiceIndex *index);
+
+guint clp_app_mgr_service_index_get_handlers (ClpAppMgrServiceIndex *index, const gchar *mime_type, const gchar * const **applications);
+guint clp_app_mgr_service_index_get_services (ClpAppMgrServiceIndex *index, const gchar *application, const ClpAppMgrServices **services);
+guint clp_app_mgr_service_index_get_mime_types (ClpAppMgrServiceIndex *index, const gchar *application, const gchar * const **mime_types);
+const gchar* clp_app_mgr_service_index_get_provider (ClpAppMgrServiceIndex *index, const gchar *service);
+
+#endif /*__CLP_APP_MGR_SERVICE_INDEX_H__ */
@@ -0,0 +1,459 @@
+/** \file clp-app-mgr-shm.c
+ *
+ * \brief Shared memory table of the running application instances
+ *
+ * Implementation of the table described in clp-app-mgr-shm.h. The writer bumps the sequence counter to an odd
+ * value, rewrites the table and bumps it back to an even value. A reader copies the table between two reads of
+ * the counter and retries if the counter was odd or moved.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <glib.h>
+#include <gconf/gconf-client.h>
+#include <app-manager.h>
+#include "clp-app-mgr-config.h"
+#include "clp-app-mgr-shm.h"
+#include "clp-app-mgr-intern.h"
+#include "clp-app-mgr-registry.h"
+#include "clp-app-mgr-writeback.h"
+
+#define SHM_MAGIC		0x434c5033			/**< "CLP3", changes with the layout of the table */
+#define SHM_MODE		0664				/**< only the appmgr user and group may publish */
+#define SHM_READ_ATTEMPTS	64				/**< reads retried while the writer is busy */
+#define SHM_BARRIER()		__sync_synchronize()
+
+typedef struct _ClpAppMgrShmTable				/**< Layout of the shared memory object */
+{
+	volatile guint32	magic;				/**< SHM_MAGIC once the table was published */
+	volatile gint		seq;				/**< sequence counter, odd while the writer updates the table */
+	volatile gint32		writer_pid;			/**< pid of the process that published the table */
+	volatile guint32	n_entries;			/**< number of valid entries */
+	volatile guint32	complete;			/**< FALSE if more instances ran than the table holds */
+	volatile gint		changes;			/**< bumped after a successful launch, and by the writer on every lifecycle signal */
+	volatile gint		published_changes;		/**< changes already reflected in the table */
+	ClpAppMgrShmEntry	entries[CLP_APP_MGR_SHM_MAX_INSTANCES];	/**< the running instances */
+}ClpAppMgrShmTable;
+
+static struct
+{
+	gboolean	opened;					/**< TRUE once the object was opened, even if that failed */
+	gint		fd;					/**< descriptor of the shared memory object, -1 if unavailable */
+	gboolean	writable;				/**< the object is mapped read write */
+	gboolean	writer;					/**< this process holds the writer lock */
+	guint		publish_idle;				/**< idle source of the pending publication, 0 if none */
+	gint		focused_pid;				/**< instance with the user interaction, as last signalled */
+	ClpAppMgrShmTable	*table;				/**< the mapped table, NULL if unavailable */
+}shm = { FALSE, -1, FALSE, FALSE, 0, 0, NULL };
+G_LOCK_DEFINE_STATIC (shm);
+
+
+/** \brief Map the shared memory object on first use
+ *
+ * \return TRUE if the table is mapped
+ */
+static gboolean
+shm_ensure_opened(void)
+{
+	struct stat st;
+
+	G_LOCK(shm);
+	if (shm.opened)
+	{
+		G_UNLOCK(shm);
+		return shm.table != NULL;
+	}
+	shm.opened = TRUE;
+
+	shm.fd = shm_open(CLP_APP_MGR_SHM_NAME, O_RDWR | O_CREAT, SHM_MODE);
+	if (shm.fd >= 0)
+	{
+		shm.writable = TRUE;
+		/* the mode asked for is masked by the umask, and an object left by an older library may be world writable */
+		fchmod(shm.fd, SHM_MODE);
+	}
+	else
+		shm.fd = shm_open(CLP_APP_MGR_SHM_NAME, O_RDONLY, 0);
+	if (shm.fd < 0)
+	{
+		CLP_APPMGR_WARN_V("Unable to open %s : %s", CLP_APP_MGR_SHM_NAME, g_strerror(errno));
+		G_UNLOCK(shm);
+		return FALSE;
+	}
+	fcntl(shm.fd, F_SETFD, FD_CLOEXEC);
+
+	if (shm.writable && fstat(shm.fd, &st) == 0 && st.st_size < sizeof(ClpAppMgrShmTable))
+		ftruncate(shm.fd, sizeof(ClpAppMgrShmTable));
+	if (fstat(shm.fd, &st) < 0 || st.st_size < sizeof(ClpAppMgrShmTable))
+	{
+		CLP_APPMGR_WARN_V("%s is not initialised", CLP_APP_MGR_SHM_NAME);
+		G_UNLOCK(shm);
+		return FALSE;
+	}
+	if (st.st_mode & S_IWOTH)
+	{
+		CLP_APPMGR_WARN_V("%s is world writable, it is not trusted", CLP_APP_MGR_SHM_NAME);
+		G_UNLOCK(shm);
+		return FALSE;
+	}
+
+	shm.table = mmap(NULL, sizeof(ClpAppMgrShmTable), shm.writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, shm.fd, 0);
+	if (shm.table == MAP_FAILED)
+	{
+		CLP_APPMGR_WARN_V("Unable to map %s : %s", CLP_APP_MGR_SHM_NAME, g_strerror(errno));
+		shm.table = NULL;
+	}
+	G_UNLOCK(shm);
+	return shm.table != NULL;
+}
+
+
+/** \brief Check that a process holds the writer lock
+ *
+ * \return TRUE if the table still has a writer, which republishes it on every change
+ */
+static gboolean
+shm_writer_alive(void)
+{
+	if (shm.writer)
+		return TRUE;
+	/* a shared lock is refused only while the writer holds its exclusive one, the lock goes with the writer */
+	if (flock(shm.fd, LOCK_SH | LOCK_NB) < 0)
+		return errno == EWOULDBLOCK;
+	flock(shm.fd, LOCK_UN);
+	return FALSE;
+}
+
+
+/** \brief Read the running instances from the application manager
+ *
+ * \param entries Returns the instances, CLP_APP_MGR_SHM_MAX_INSTANCES entries
+ * \param complete Returns FALSE if more instances are running than the table holds
+ *
+ * \return Number of instances, -1 on error
+ */
+static gint
+shm_collect(ClpAppMgrShmEntry *entries, gboolean *complete)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	GConfClient *client = clp_app_mgr_registry_client();
+	gint *apps = NULL;
+	gint num_of_active_apps = 0, i, j, n = 0;
+	gint return_code;
+
+	*complete = TRUE;
+	return_code = AppMgrAppGetRunningApps(&apps, &num_of_active_apps);
+	if (return_code)
+	{
+		CLP_APPMGR_WARN_V("Unable to get Running Apps !! Error Code %d", return_code);
+		CLP_APPMGR_EXIT_FUNCTION();
+		return -1;
+	}
+
+	for (i = 0; i < num_of_active_apps; i++)
+	{
+		gint *instid = NULL, no_of_active_inst = 0;
+		const ClpAppMgrAppNames *names = NULL;
+		gchar app_id[16], *key, *exec_name;
+		gint priority = 0;
+		gboolean visibility = FALSE;
+
+		return_code = AppMgrAppGetRunningInstances(apps[i], &instid, &no_of_active_inst);
+		if (return_code)
+		{
+			CLP_APPMGR_WARN_V("Unable to get Running Instance of App %d ! Error Code - %d", apps[i], return_code);
+			continue;
+		}
+
+		g_snprintf(app_id, sizeof(app_id), "%d", apps[i]);
+		key = g_strconcat(LIMO_APPS_DIR, "/", app_id, "/AppExecName", NULL);
+		exec_name = gconf_client_get_string(client, key, NULL);
+		g_free(key);
+		if (exec_name)
+		{
+			names = clp_app_mgr_app_names_get(exec_name);
+			g_free(exec_name);
+
+			key = g_strconcat(names->info_dir, "/Priority", NULL);
+			priority = gconf_client_get_int(client, key, NULL);
+			g_free(key);
+			key = g_strconcat(names->info_dir, "/Visibility", NULL);
+			visibility = gconf_client_get_bool(client, key, NULL);
+			g_free(key);
+		}
+
+		for (j = 0; j < no_of_active_inst; j++)
+		{
+			gint appid;
+			pid_t pid;
+			gboolean seen_visibility;
+
+			if (n == CLP_APP_MGR_SHM_MAX_INSTANCES)
+			{
+				CLP_APPMGR_WARN_V("More than %d instances are running, the table is published as unusable", CLP_APP_MGR_SHM_MAX_INSTANCES);
+				*complete = FALSE;
+				break;
+			}
+			if (AppMgrAppGetInstInfo(instid[j], &appid, &pid))
+				continue;
+			entries[n].pid = pid;
+			entries[n].app_id = appid;
+			entries[n].inst_id = instid[j];
+			entries[n].priority = priority;
+			if (clp_app_mgr_writeback_get_visibility(pid, &seen_visibility))
+				entries[n].visibility = seen_visibility;
+			else
+				entries[n].visibility = visibility;
+			entries[n].focused = (pid == shm.focused_pid);
+			n++;
+		}
+	}
+
+	CLP_APPMGR_EXIT_FUNCTION();
+	return n;
+}
+
+
+/** \brief Publish the running instances
+ *
+ * Idle callback of the writer. The application manager is queried before the table is locked, readers only
+ * retry for the time of the copy.
+ */
+static gboolean
+shm_publish(gpointer data)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	ClpAppMgrShmEntry entries[CLP_APP_MGR_SHM_MAX_INSTANCES];
+	gint n, changes;
+	gboolean complete;
+
+	shm.publish_idle = 0;
+	/* changes noted from now on may be missing from what is collected */
+	changes = g_atomic_int_get(&shm.table->changes);
+	memset(entries, 0, sizeof(entries));
+	n = shm_collect(entries, &complete);
+	if (n < 0)
+	{
+		CLP_APPMGR_EXIT_FUNCTION();
+		return FALSE;
+	}
+
+	g_atomic_int_inc(&shm.table->seq);
+	SHM_BARRIER();
+	memcpy(shm.table->entries, entries, n * sizeof(ClpAppMgrShmEntry));
+	shm.table->n_entries = n;
+	shm.table->complete = complete;
+	shm.table->published_changes = changes;
+	shm.table->writer_pid = getpid();
+	shm.table->magic = SHM_MAGIC;
+	SHM_BARRIER();
+	g_atomic_int_inc(&shm.table->seq);
+
+	CLP_APPMGR_INFO_V("Published %d running instances", n);
+	CLP_APPMGR_EXIT_FUNCTION();
+	return FALSE;
+}
+
+
+/** \brief gconf notification of a change in the application registry */
+static void
+shm_registry_changed(GConfClient *client, guint cnxn_id, GConfEntry *entry, gpointer data)
+{
+	clp_app_mgr_shm_update();
+}
+
+
+/** \brief Note a change of the running instances
+ *
+ * Called on every lifecycle signal. Takes over the table if no other process holds the writer lock, so the
+ * table keeps a writer as long as one initialised application is running. The writer marks the table as out of
+ * date until it is republished, and schedules the publication.
+ */
+void
+clp_app_mgr_shm_update(void)
+{
+	if (!shm_ensure_opened() || !shm.writable)
+		return;
+
+	if (!shm.writer)
+	{
+		if (flock(shm.fd, LOCK_EX | LOCK_NB) < 0)
+			return;
+		shm.writer = TRUE;
+		CLP_APPMGR_INFO_V("Process %d now publishes %s", getpid(), CLP_APP_MGR_SHM_NAME);
+
+		GConfClient *client = clp_app_mgr_registry_client();
+		gconf_client_notify_add(client, GCONF_APPS_DIR, shm_registry_changed, NULL, NULL, NULL);
+		clp_app_mgr_registry_watch();
+	}
+	g_atomic_int_inc(&shm.table->changes);
+	if (shm.publish_idle == 0)
+		shm.publish_idle = g_idle_add(shm_publish, NULL);
+}
+
+
+/** \brief Note a successful launch made by this process
+ *
+ * The table does not have the new instance until the writer republishes it, the readers of every process
+ * ignore it meanwhile. The writer itself schedules the publication.
+ */
+void
+clp_app_mgr_shm_launched(void)
+{
+	if (!shm_ensure_opened() || !shm.writable)
+		return;
+	g_atomic_int_inc(&shm.table->changes);
+	clp_app_mgr_shm_update();
+}
+
+
+/** \brief Note a change of the user interaction
+ *
+ * \param pid Instance the user interaction signal is about
+ * \param focused TRUE if it gained the user interaction, FALSE if it lost it
+ *
+ * The writer flips the focus flags in place, the application manager is not queried.
+ */
+void
+clp_app_mgr_shm_set_focus(gint pid, gboolean focused)
+{
+	guint i;
+
+	if (focused)
+		shm.focused_pid = pid;
+	else if (shm.focused_pid == pid)
+		shm.focused_pid = 0;
+
+	if (!shm.writer || shm.table->magic != SHM_MAGIC)
+		return;
+
+	g_atomic_int_inc(&shm.table->seq);
+	SHM_BARRIER();
+	for (i = 0; i < shm.table->n_entries; i++)
+		shm.table->entries[i].focused = (shm.table->entries[i].pid == shm.focused_pid);
+	SHM_BARRIER();
+	g_atomic_int_inc(&shm.table->seq);
+}
+
+
+/** \brief Note a VisibilityChanged signal
+ *
+ * \param pid Instance the signal is about
+ * \param visibility Its new visibility
+ *
+ * The writer flips the visibility flag in place, the registry is not read.
+ */
+void
+clp_app_mgr_shm_set_visibility(gint pid, gboolean visibility)
+{
+	guint i;
+
+	if (!shm.writer || shm.table->magic != SHM_MAGIC)
+		return;
+
+	g_atomic_int_inc(&shm.table->seq);
+	SHM_BARRIER();
+	for (i = 0; i < shm.table->n_entries; i++)
+		if (shm.table->entries[i].pid == pid)
+			shm.table->entries[i].visibility = visibility;
+	SHM_BARRIER();
+	g_atomic_int_inc(&shm.table->seq);
+}
+
+
+/** \brief Copy the running instances out of the table
+ *
+ * \param entries Returns the instances, CLP_APP_MGR_SHM_MAX_INSTANCES entries
+ *
+ * \return Number of instances, -1 if the table is unusable: never published, its writer is gone, it is waiting to be
+ * republished after a launch or a lifecycle signal, it could not hold every instance, or the writer kept it busy
+ * for every attempt.
+ */
+gint
+clp_app_mgr_shm_read(ClpAppMgrShmEntry *entries)
+{
+	ClpAppMgrShmTable *table;
+	guint attempt, n;
+	gint seq;
+	gboolean changed, complete;
+
+	if (!shm_ensure_opened())
+		return -1;
+	table = shm.table;
+
+	for (attempt = 0; attempt < SHM_READ_ATTEMPTS; attempt++)
+	{
+		seq = g_atomic_int_get(&table->seq);
+		SHM_BARRIER();
+		if (seq & 1)
+		{
+			sched_yield();
+			continue;
+		}
+		if (table->magic != SHM_MAGIC)
+			return -1;
+
+		n = table->n_entries;
+		complete = table->complete;
+		changed = g_atomic_int_get(&table->changes) != table->published_changes;
+		if (n <= CLP_APP_MGR_SHM_MAX_INSTANCES)
+			memcpy(entries, table->entries, n * sizeof(ClpAppMgrShmEntry));
+		SHM_BARRIER();
+		if (g_atomic_int_get(&table->seq) != seq || n > CLP_APP_MGR_SHM_MAX_INSTANCES)
+			continue;
+
+		/* a table whose writer is gone is not updated any more, one waiting for its writer misses a change */
+		if (!complete || changed || !shm_writer_alive())
+			return -1;
+		return n;
+	}
+	CLP_APPMGR_WARN("The active application table stayed busy, falling back to the application manager");
+	return -1;
+}
+
+
+/** \brief Count the running instances of an application
+ *
+ * \param app_id Application id
+ *
+ * \return Number of instances, -1 if the table is unusable
+ */
+gint
+clp_app_mgr_shm_count_instances(gint app_id)
+{
+	ClpAppMgrShmEntry entries[CLP_APP_MGR_SHM_MAX_INSTANCES];
+	gint n = clp_app_mgr_shm_read(entries), i, count = 0;
+
+	for (i = 0; i < n; i++)
+		if (entries[i].app_id == app_id)
+			count++;
+	return n < 0 ? -1 : count;
+}
+
+
+/** \brief Count the running applications
+ *
+ * \return Number of distinct applications with at least one instance, -1 if the table is unusable
+ */
+gint
+clp_app_mgr_shm_count_apps(void)
+{
+	ClpAppMgrShmEntry entries[CLP_APP_MGR_SHM_MAX_INSTANCES];
+	gint n = clp_app_mgr_shm_read(entries), i, j, count = 0;
+
+	for (i = 0; i < n; i++)
+	{
+		for (j = 0; j < i; j++)
+			if (entries[j].app_id == entries[i].app_id)
+				break;
+		if (j == i)
+			count++;
+	}
+	return n < 0 ? -1 : count;
+}
@@ -0,0 +1,40 @@
+/** \file clp-app-mgr-shm.h
+ * \brief Shared memory table of the running application instances
+ *
+ * One process, elected with an exclusive lock on the shared memory object, publishes the running instances
+ * into a fixed size table whenever a lifecycle signal or a registry change reaches it. Every other process reads
+ * the table through a sequence lock: no IPC and no wakeup of the writer. The table stays valid for as long as
+ * its writer holds the lock, since the writer republishes it on every change. When no writer holds the lock,
+ * when a launch or a lifecycle signal is not reflected yet, or when more instances run than the table holds, the
+ * readers report it as unusable and the callers fall back to the instance counters or the application manager.
+ * Only the appmgr user and group may write the table.
+ * This header is internal to the library, it is not installed.
+ */
+
+#ifndef __CLP_APP_MGR_SHM_H__
+#define __CLP_APP_MGR_SHM_H__
+
+#include <glib.h>
+
+#define CLP_APP_MGR_SHM_NAME			"/clp-app-mgr-active"	/**< name of the shared memory object */
+#define CLP_APP_MGR_SHM_MAX_INSTANCES		128			/**< capacity of the table */
+
+typedef struct _ClpAppMgrShmEntry				/**< One running instance */
+{
+	gint32		pid;					/**< pid of the instance */
+	gint32		app_id;					/**< application id */
+	gint32		inst_id;				/**< instance id */
+	gint32		priority;				/**< priority of the application */
+	guint32		visibility : 1;				/**< visibility of the application */
+	guint32		focused : 1;				/**< the instance has the user interaction */
+}ClpAppMgrShmEntry;
+
+void clp_app_mgr_shm_update (void);
+void clp_app_mgr_shm_launched (void);
+void clp_app_mgr_shm_set_focus (gint pid, gboolean focused);
+void clp_app_mgr_shm_set_visibility (gint pid, gboolean visibility);
+gint clp_app_mgr_shm_read (ClpAppMgrShmEntry *entries);
+gint clp_app_mgr_shm_count_instances (gint app_id);
+gint clp_app_mgr_shm_count_apps (void);
+
+#endif /*__CLP_APP_MGR_SHM_H__ */
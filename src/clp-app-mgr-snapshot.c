@@ -0,0 +1,207 @@
+/** \file clp-app-mgr-snapshot.c
+ *
+ * \brief Shared snapshot of the running applications
+ *
+ * The library keeps the latest list of running applications as an immutable snapshot. Every caller of the
+ * process gets a reference on the same snapshot instead of its own copy, and a new one is built only after
+ * a lifecycle signal (AppExit, ClearPID, applistchange) or a change of the application registry, which is
+ * where a launched application registers its PID and where its visibility is kept. Two snapshots can be diffed
+ * into the added, removed and updated instances, which is what the list change notifications deliver.
+ */
+
+#include <glib.h>
+#include "clp-app-mgr-lib.h"
+#include "clp-app-mgr-config.h"
+#include "clp-app-mgr-monitor.h"
+#include "clp-app-mgr-array.h"
+
+struct _ClpAppMgrActiveSnapshot
+{
+	volatile gint	ref_count;				/**< references held by the library and the callers */
+	guint		serial;					/**< serial of the snapshot, increases with every rebuild */
+	guint		active_generation;			/**< lifecycle generation the snapshot was built at */
+	guint		registry_generation;			/**< registry generation the snapshot was built at */
+	ClpAppMgrArray	*apps;					/**< ClpAppMgrActiveAppV2 records */
+};
+
+static ClpAppMgrActiveSnapshot *current_snapshot = NULL;	/**< snapshot shared by all the callers of this process */
+static guint last_serial = 0;					/**< serial of the last snapshot built */
+G_LOCK_DEFINE_STATIC (current_snapshot);
+
+
+/** \brief Get the snapshot of the running applications
+ *
+ * \return A reference to the snapshot, to be released with clp_app_mgr_active_snapshot_unref()
+ *
+ * The snapshot is built on first use and rebuilt only after the running applications changed. In a process
+ * that did not call clp_app_mgr_init(), or outside its main loop, the lifecycle signals are not seen and every
+ * call builds a new snapshot.
+ */
+ClpAppMgrActiveSnapshot*
+clp_app_mgr_active_snapshot_get(void)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	ClpAppMgrActiveSnapshot *snapshot, *stale = NULL;
+	guint active_generation = clp_app_mgr_monitor_get_generation(CLP_APP_MGR_MONITOR_ACTIVE);
+	guint registry_generation = clp_app_mgr_monitor_get_generation(CLP_APP_MGR_MONITOR_REGISTRY);
+
+	G_LOCK(current_snapshot);
+	if (current_snapshot == NULL || current_snapshot->active_generation != active_generation
+		|| current_snapshot->registry_generation != registry_generation)
+	{
+		stale = current_snapshot;
+		current_snapshot = g_new0(ClpAppMgrActiveSnapshot, 1);
+		current_snapshot->ref_count = 1;
+		current_snapshot->serial = ++last_serial;
+		current_snapshot->active_generation = active_generation;
+		current_snapshot->registry_generation = registry_generation;
+		current_snapshot->apps = clp_app_mgr_get_active_apps_v2();
+		CLP_APPMGR_INFO_V("Snapshot %u built with %u applications", current_snapshot->serial, current_snapshot->apps->n_records);
+	}
+	snapshot = current_snapshot;
+	g_atomic_int_inc(&snapshot->ref_count);
+	G_UNLOCK(current_snapshot);
+
+	clp_app_mgr_active_snapshot_unref(stale);
+	CLP_APPMGR_EXIT_FUNCTION();
+	return snapshot;
+}
+
+
+/** \brief Release a reference on a snapshot
+ *
+ * \param snapshot Snapshot returned by clp_app_mgr_active_snapshot_get()
+ *
+ * The records returned by clp_app_mgr_active_snapshot_get_apps() must not be used afterwards.
+ */
+void
+clp_app_mgr_active_snapshot_unref(ClpAppMgrActiveSnapshot *snapshot)
+{
+	if (snapshot == NULL)
+		return;
+	if (!g_atomic_int_dec_and_test(&snapshot->ref_count))
+		return;
+
+	clp_app_mgr_array_free(snapshot->apps);
+	g_free(snapshot);
+}
+
+
+/** \brief Get the running applications of a snapshot
+ *
+ * \param snapshot The snapshot
+ * \param n_apps Returns the number of applications
+ *
+ * \return Records of the applications, owned by the snapshot and never modified
+ */
+const ClpAppMgrActiveAppV2*
+clp_app_mgr_active_snapshot_get_apps(ClpAppMgrActiveSnapshot *snapshot, guint *n_apps)
+{
+	g_return_val_if_fail(snapshot != NULL, NULL);
+
+	if (n_apps)
+		*n_apps = snapshot->apps->n_records;
+	return snapshot->apps->records;
+}
+
+
+/** \brief Get the serial of a snapshot
+ *
+ * \param snapshot The snapshot
+ *
+ * \return Serial of the snapshot. Two snapshots with the same serial are the same snapshot, a newer snapshot has a
+ * greater serial.
+ */
+guint
+clp_app_mgr_active_snapshot_get_serial(ClpAppMgrActiveSnapshot *snapshot)
+{
+	g_return_val_if_fail(snapshot != NULL, 0);
+
+	return snapshot->serial;
+}
+
+
+/** \brief Compare two active application records
+ *
+ * \return TRUE if the records differ. The strings are interned, they are compared by pointer.
+ */
+static gboolean
+snapshot_record_changed(const ClpAppMgrActiveAppV2 *a, const ClpAppMgrActiveAppV2 *b)
+{
+	return a->name != b->name || a->title != b->title || a->icon != b->icon
+		|| a->visibility != b->visibility || a->immortal != b->immortal;
+}
+
+
+/** \brief Get the changes between two snapshots
+ *
+ * \param old_snapshot Older snapshot, NULL to report every application of new_snapshot as added
+ * \param new_snapshot Newer snapshot
+ *
+ * \return GList of ClpAppMgrAppListChange, NULL if nothing changed. The list and its data are to be freed by the caller.
+ *
+ * Instances are matched by pid. The added and updated instances come first in the order of new_snapshot, then the
+ * removed ones. Every change carries the serial of new_snapshot.
+ */
+GList*
+clp_app_mgr_active_snapshot_diff(ClpAppMgrActiveSnapshot *old_snapshot, ClpAppMgrActiveSnapshot *new_snapshot)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	GHashTable *old_records;
+	GList *changes = NULL;
+	const ClpAppMgrActiveAppV2 *records;
+	guint n_records, i;
+
+	g_return_val_if_fail(new_snapshot != NULL, NULL);
+
+	old_records = g_hash_table_new(g_direct_hash, g_direct_equal);
+	if (old_snapshot)
+	{
+		records = clp_app_mgr_active_snapshot_get_apps(old_snapshot, &n_records);
+		for (i = 0; i < n_records; i++)
+			g_hash_table_insert(old_records, GINT_TO_POINTER(records[i].pid), (gpointer) &records[i]);
+	}
+
+	records = clp_app_mgr_active_snapshot_get_apps(new_snapshot, &n_records);
+	for (i = n_records; i > 0; i--)
+	{
+		const ClpAppMgrActiveAppV2 *record = &records[i - 1];
+		const ClpAppMgrActiveAppV2 *old_record = g_hash_table_lookup(old_records, GINT_TO_POINTER(record->pid));
+		ClpAppMgrAppListChange *change;
+
+		g_hash_table_remove(old_records, GINT_TO_POINTER(record->pid));
+		if (old_record && !snapshot_record_changed(old_record, record))
+			continue;
+
+		change = g_new(ClpAppMgrAppListChange, 1);
+		change->type = old_record ? CLP_APP_MGR_APP_UPDATED : CLP_APP_MGR_APP_ADDED;
+		change->seq = new_snapshot->serial;
+		change->app = *record;
+		changes = g_list_prepend(changes, change);
+	}
+
+	/* whatever is left in the table exited */
+	if (old_snapshot)
+	{
+		GList *removed = NULL;
+
+		records = clp_app_mgr_active_snapshot_get_apps(old_snapshot, &n_records);
+		for (i = n_records; i > 0; i--)
+		{
+			ClpAppMgrAppListChange *change;
+
+			if (g_hash_table_lookup(old_records, GINT_TO_POINTER(records[i - 1].pid)) != &records[i - 1])
+				continue;
+			change = g_new(ClpAppMgrAppListChange, 1);
+			change->type = CLP_APP_MGR_APP_REMOVED;
+			change->seq = new_snapshot->serial;
+			change->app = records[i - 1];
+			removed = g_list_prepend(removed, change);
+		}
+		changes = g_list_concat(changes, removed);
+	}
+	g_hash_table_destroy(old_records);
+
+	CLP_APPMGR_EXIT_FUNCTION();
+	return changes;
+}
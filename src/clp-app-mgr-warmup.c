@@ -0,0 +1,127 @@
+/** \file clp-app-mgr-warmup.c
+ *
+ * \brief Background warm-up of the caches of the Application Manager Library
+ *
+ * Implementation of the warm-up described in clp-app-mgr-warmup.h. A detached thread owns an exclusive pool, so
+ * the workers, whose I/O priority is lowered, are never handed work from another pool and are gone once the caches
+ * are built.
+ */
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <glib.h>
+#include "clp-app-mgr-config.h"
+#include "clp-app-mgr-warmup.h"
+#include "clp-app-mgr-monitor.h"
+#include "clp-app-mgr-desktop-db.h"
+#include "clp-app-mgr-service-index.h"
+#include "clp-app-mgr-classify.h"
+
+#define WARMUP_IOPRIO_WHO_PROCESS	1			/**< ioprio_set() target, a thread id or 0 for the caller */
+#define WARMUP_IOPRIO_CLASS_IDLE	3			/**< I/O served only when the disk is otherwise idle */
+#define WARMUP_IOPRIO_CLASS_SHIFT	13			/**< position of the class in an I/O priority */
+
+typedef enum _ClpAppMgrWarmupTask				/**< One cache to build */
+{
+	WARMUP_TASK_SERVICE_INDEX = 1,				/**< service index, the largest, first */
+	WARMUP_TASK_CLASSIFIER,					/**< string classifier */
+	WARMUP_TASK_DESKTOP_DB,					/**< compiled desktop database */
+	WARMUP_N_TASKS = WARMUP_TASK_DESKTOP_DB
+}ClpAppMgrWarmupTask;
+
+static gint warmup_started = 0;
+
+
+/** \brief Lower the I/O priority of the calling thread to idle
+ *
+ * Linux only, elsewhere the thread keeps the priority of the process.
+ */
+static void
+warmup_set_idle_io(void)
+{
+#ifdef SYS_ioprio_set
+	if (syscall(SYS_ioprio_set, WARMUP_IOPRIO_WHO_PROCESS, 0, WARMUP_IOPRIO_CLASS_IDLE << WARMUP_IOPRIO_CLASS_SHIFT) != 0)
+		CLP_APPMGR_INFO("Unable to lower the I/O priority of the warm-up thread");
+#endif
+}
+
+
+/** \brief Build one cache, run by the workers
+ *
+ * \param data The ClpAppMgrWarmupTask
+ * \param user_data Unused
+ */
+static void
+warmup_run_task(gpointer data, gpointer user_data)
+{
+	GTimer *timer = g_timer_new();
+	ClpAppMgrWarmupTask task = GPOINTER_TO_INT(data);
+
+	warmup_set_idle_io();
+	switch (task)
+	{
+	case WARMUP_TASK_SERVICE_INDEX:
+		clp_app_mgr_service_index_unref(clp_app_mgr_service_index_get());
+		break;
+	case WARMUP_TASK_CLASSIFIER:
+		/* classifying any string builds the DFA */
+		clp_app_mgr_classify_string("");
+		break;
+	case WARMUP_TASK_DESKTOP_DB:
+		clp_app_mgr_desktop_db_unref(clp_app_mgr_desktop_db_get());
+		break;
+	}
+	CLP_APPMGR_INFO_V("Warm-up task %d done in %.3f s", task, g_timer_elapsed(timer, NULL));
+	g_timer_destroy(timer);
+}
+
+
+/** \brief Run the warm-up, body of the detached thread */
+static gpointer
+warmup_run(gpointer data)
+{
+	GThreadPool *pool;
+	GError *error = NULL;
+	gint task;
+
+	pool = g_thread_pool_new(warmup_run_task, NULL, CLP_APP_MGR_WARMUP_THREADS, TRUE, &error);
+	if (pool == NULL)
+	{
+		CLP_APPMGR_WARN_V("Unable to start the warm-up threads: %s", error ? error->message : "unknown error");
+		if (error)
+			g_error_free(error);
+		return NULL;
+	}
+	for (task = WARMUP_TASK_SERVICE_INDEX; task <= WARMUP_N_TASKS; task++)
+		g_thread_pool_push(pool, GINT_TO_POINTER(task), NULL);
+	g_thread_pool_free(pool, FALSE, TRUE);
+	return NULL;
+}
+
+
+/** \brief Start building the caches in the background
+ *
+ * Returns at once. Only the first call of the process starts anything. To be called from the thread owning the
+ * default main context, so the change monitor is attached to it before the workers use it.
+ */
+void
+clp_app_mgr_warmup_start(void)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	GError *error = NULL;
+
+	if (!g_atomic_int_compare_and_exchange(&warmup_started, 0, 1))
+	{
+		CLP_APPMGR_EXIT_FUNCTION();
+		return;
+	}
+
+	clp_app_mgr_monitor_get_generation(CLP_APP_MGR_MONITOR_DESKTOP);
+	if (g_thread_create(warmup_run, NULL, FALSE, &error) == NULL)
+	{
+		CLP_APPMGR_WARN_V("Unable to start the warm-up: %s", error ? error->message : "unknown error");
+		if (error)
+			g_error_free(error);
+	}
+	CLP_APPMGR_EXIT_FUNCTION();
+}
@@ -0,0 +1,24 @@
+/** \file clp-app-mgr-warmup.h
+ * \brief Background warm-up of the caches of the Application Manager Library
+ *
+ * The service index and the string classifier are built on first use, which puts the parsing of every desktop
+ * file and of mimeinfo.cache on the first service lookup of the session. When the CLP_APP_MGR_WARMUP_KEY
+ * registry key is set, clp_app_mgr_init() builds them right away on a small pool of threads running at idle I/O
+ * priority, and returns without waiting. Each cache is published as a whole by its getter once built, a lookup
+ * made meanwhile either waits for it or builds it as before.
+ *
+ * The caches fed from the gconf registry are left out, gconf is not to be used from several threads.
+ * This header is internal to the library, it is not installed.
+ */
+
+#ifndef __CLP_APP_MGR_WARMUP_H__
+#define __CLP_APP_MGR_WARMUP_H__
+
+#include <glib.h>
+
+#define CLP_APP_MGR_WARMUP_KEY			GCONF_APPS_DIR "/WarmUp"	/**< registry key enabling the warm-up */
+#define CLP_APP_MGR_WARMUP_THREADS		2			/**< largest number of caches built at the same time */
+
+void clp_app_mgr_warmup_start (void);
+
+#endif /*__CLP_APP_MGR_WARMUP_H__ */
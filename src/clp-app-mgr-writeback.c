@@ -0,0 +1,222 @@
+/** \file clp-app-mgr-writeback.c
+ *
+ * \brief Write-behind buffer of the registry writes of the Application Manager Library
+ *
+ * Implementation of the buffer described in clp-app-mgr-writeback.h. The pending writes are kept as GConfValue
+ * keyed by the gconf key. The last value flushed for each key is kept to drop a pending write that a later write
+ * of the same key takes back before the flush.
+ */
+
+#include <stdlib.h>
+#include <glib.h>
+#include <gconf/gconf-client.h>
+#include "clp-app-mgr-config.h"
+#include "clp-app-mgr-writeback.h"
+#include "clp-app-mgr-registry.h"
+
+static struct
+{
+	GHashTable	*pending;				/**< key to GConfValue not written yet */
+	GHashTable	*written;				/**< key to GConfValue last written */
+	guint		idle;					/**< idle source of the flush, 0 if none */
+	guint		deadline;				/**< timeout source of the flush, 0 if none */
+	gboolean	atexit_done;				/**< the flush at exit is registered */
+}writeback = { NULL, NULL, 0, 0, FALSE };
+G_LOCK_DEFINE_STATIC (writeback);
+
+static GHashTable *visibility_seen = NULL;			/**< pid to visibility, as announced on the bus */
+G_LOCK_DEFINE_STATIC (visibility_seen);
+
+
+/** \brief Compare two gconf values of the types the buffer holds */
+static gboolean
+writeback_value_equal(const GConfValue *a, const GConfValue *b)
+{
+	if (a->type != b->type)
+		return FALSE;
+	if (a->type == GCONF_VALUE_INT)
+		return gconf_value_get_int(a) == gconf_value_get_int(b);
+	return gconf_value_get_bool(a) == gconf_value_get_bool(b);
+}
+
+
+/** \brief Idle and timeout callback of the buffer */
+static gboolean
+writeback_flush_cb(gpointer data)
+{
+	clp_app_mgr_writeback_flush();
+	return FALSE;
+}
+
+
+/** \brief Flush at exit so that no buffered write is lost */
+static void
+writeback_atexit(void)
+{
+	clp_app_mgr_writeback_flush();
+}
+
+
+/** \brief Buffer a write
+ *
+ * \param key gconf key
+ * \param value New value, owned by the buffer
+ */
+static void
+writeback_set(const gchar *key, GConfValue *value)
+{
+	GConfValue *written;
+
+	G_LOCK(writeback);
+	if (writeback.pending == NULL)
+	{
+		writeback.pending = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify) gconf_value_free);
+		writeback.written = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify) gconf_value_free);
+	}
+	if (!writeback.atexit_done)
+	{
+		atexit(writeback_atexit);
+		writeback.atexit_done = TRUE;
+	}
+
+	/* Without a pending write the key may have been changed by another process since the flush, so the value
+	 * is written even if it is the one this process flushed last */
+	written = g_hash_table_lookup(writeback.written, key);
+	if (g_hash_table_lookup(writeback.pending, key) && written && writeback_value_equal(written, value))
+	{
+		/* back to the value flushed last, the pending write would only undo itself */
+		g_hash_table_remove(writeback.pending, key);
+		gconf_value_free(value);
+	}
+	else
+		g_hash_table_replace(writeback.pending, g_strdup(key), value);
+
+	if (g_hash_table_size(writeback.pending) > 0 && writeback.idle == 0)
+	{
+		writeback.idle = g_idle_add_full(G_PRIORITY_LOW, writeback_flush_cb, NULL, NULL);
+		writeback.deadline = g_timeout_add(CLP_APP_MGR_WRITEBACK_DEADLINE, writeback_flush_cb, NULL);
+	}
+	G_UNLOCK(writeback);
+}
+
+
+/** \brief Buffer the write of a boolean key
+ *
+ * \param key gconf key
+ * \param value New value
+ */
+void
+clp_app_mgr_writeback_set_bool(const gchar *key, gboolean value)
+{
+	GConfValue *gvalue = gconf_value_new(GCONF_VALUE_BOOL);
+
+	gconf_value_set_bool(gvalue, value);
+	writeback_set(key, gvalue);
+}
+
+
+/** \brief Write the buffered values to gconfd now */
+void
+clp_app_mgr_writeback_flush(void)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	GConfClient *client;
+	GHashTable *pending;
+	GHashTableIter iter;
+	gpointer key, value;
+
+	G_LOCK(writeback);
+	if (writeback.idle)
+		g_source_remove(writeback.idle);
+	if (writeback.deadline)
+		g_source_remove(writeback.deadline);
+	writeback.idle = writeback.deadline = 0;
+	pending = writeback.pending;
+	if (pending == NULL || g_hash_table_size(pending) == 0)
+	{
+		G_UNLOCK(writeback);
+		CLP_APPMGR_EXIT_FUNCTION();
+		return;
+	}
+	writeback.pending = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify) gconf_value_free);
+	G_UNLOCK(writeback);
+
+	client = clp_app_mgr_registry_client();
+	g_hash_table_iter_init(&iter, pending);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+	{
+		CLP_APPMGR_INFO_V("Writing %s", (gchar *) key);
+		gconf_client_set(client, key, value, NULL);
+	}
+
+	/* move the values over to the written ones */
+	G_LOCK(writeback);
+	g_hash_table_iter_init(&iter, pending);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+	{
+		g_hash_table_iter_steal(&iter);
+		g_hash_table_replace(writeback.written, key, value);
+	}
+	G_UNLOCK(writeback);
+	g_hash_table_destroy(pending);
+	CLP_APPMGR_EXIT_FUNCTION();
+}
+
+
+/** \brief Record a visibility announced on the bus
+ *
+ * \param pid Instance the announcement is about
+ * \param visibility Its visibility
+ */
+void
+clp_app_mgr_writeback_visibility_seen(gint pid, gboolean visibility)
+{
+	G_LOCK(visibility_seen);
+	if (visibility_seen == NULL)
+		visibility_seen = g_hash_table_new(g_direct_hash, g_direct_equal);
+	g_hash_table_insert(visibility_seen, GINT_TO_POINTER(pid), GINT_TO_POINTER(visibility ? TRUE : FALSE));
+	G_UNLOCK(visibility_seen);
+}
+
+
+/** \brief Drop the visibility recorded for an instance
+ *
+ * \param pid Instance that exited, 0 for all of them
+ */
+void
+clp_app_mgr_writeback_visibility_forget(gint pid)
+{
+	G_LOCK(visibility_seen);
+	if (visibility_seen)
+	{
+		if (pid)
+			g_hash_table_remove(visibility_seen, GINT_TO_POINTER(pid));
+		else
+			g_hash_table_remove_all(visibility_seen);
+	}
+	G_UNLOCK(visibility_seen);
+}
+
+
+/** \brief Get the visibility announced on the bus for an instance
+ *
+ * \param pid Instance
+ * \param visibility Returns its visibility
+ *
+ * \return TRUE if a visibility was announced, else the registry is to be read
+ */
+gboolean
+clp_app_mgr_writeback_get_visibility(gint pid, gboolean *visibility)
+{
+	gpointer value;
+	gboolean found = FALSE;
+
+	G_LOCK(visibility_seen);
+	if (visibility_seen && g_hash_table_lookup_extended(visibility_seen, GINT_TO_POINTER(pid), NULL, &value))
+	{
+		*visibility = GPOINTER_TO_INT(value);
+		found = TRUE;
+	}
+	G_UNLOCK(visibility_seen);
+	return found;
+}
@@ -0,0 +1,26 @@
+/** \file clp-app-mgr-writeback.h
+ * \brief Write-behind buffer of the registry writes of the Application Manager Library
+ *
+ * The keys an application keeps writing about itself (Visibility) are buffered and written to gconfd from an
+ * idle callback of the default main loop, or when the oldest pending write reaches CLP_APP_MGR_WRITEBACK_DEADLINE
+ * if the loop stays busy. Repeated writes of a key in between cost one gconf write, and a write taking back a
+ * pending one before the flush costs none. The PID, written once, is not buffered. Visibility changes are also
+ * announced right away on the bus: the library records the visibility they carry, which takes precedence over
+ * the registry until the instance exits.
+ * This header is internal to the library, it is not installed.
+ */
+
+#ifndef __CLP_APP_MGR_WRITEBACK_H__
+#define __CLP_APP_MGR_WRITEBACK_H__
+
+#include <glib.h>
+
+#define CLP_APP_MGR_WRITEBACK_DEADLINE		500			/**< longest delay of a buffered write, in milliseconds */
+
+void clp_app_mgr_writeback_set_bool (const gchar *key, gboolean value);
+void clp_app_mgr_writeback_flush (void);
+void clp_app_mgr_writeback_visibility_seen (gint pid, gboolean visibility);
+void clp_app_mgr_writeback_visibility_forget (gint pid);
+gboolean clp_app_mgr_writeback_get_visibility (gint pid, gboolean *visibility);
+
+#endif /*__CLP_APP_MGR_WRITEBACK_H__ */
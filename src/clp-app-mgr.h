@@ -39,6 +39,22 @@ enum _ClpAppMgrErrorCodes					/**< Standard Error Codes for Application Manager*
 	CLP_APP_MGR_INIT_FAILURE	= 0xd6			/**< Init failure */
 };
 
+enum _ClpAppMgrFields						/**< Field mask of the projected listing APIs */
+{
+	CLP_APP_MGR_FIELD_PID		= 1 << 0,		/**< ClpAppMgrActiveAppV2 pid */
+	CLP_APP_MGR_FIELD_NAME		= 1 << 1,		/**< name of ClpAppMgrActiveAppV2 and ClpAppMgrInstalledApp */
+	CLP_APP_MGR_FIELD_TITLE		= 1 << 2,		/**< ClpAppMgrActiveAppV2 title */
+	CLP_APP_MGR_FIELD_ICON		= 1 << 3,		/**< icon of ClpAppMgrActiveAppV2 and ClpAppMgrInstalledApp */
+	CLP_APP_MGR_FIELD_VISIBILITY	= 1 << 4,		/**< ClpAppMgrActiveAppV2 visibility */
+	CLP_APP_MGR_FIELD_IMMORTAL	= 1 << 5,		/**< ClpAppMgrActiveAppV2 immortal */
+	CLP_APP_MGR_FIELD_GENERIC_NAME	= 1 << 6,		/**< ClpAppMgrInstalledApp generic_name */
+	CLP_APP_MGR_FIELD_EXEC_NAME	= 1 << 7,		/**< ClpAppMgrInstalledApp exec_name */
+	CLP_APP_MGR_FIELD_MENU_PATH	= 1 << 8,		/**< ClpAppMgrInstalledApp menu_path */
+	CLP_APP_MGR_FIELD_NODISPLAY	= 1 << 9,		/**< ClpAppMgrInstalledApp nodisplay */
+	CLP_APP_MGR_FIELD_MENUPOS	= 1 << 10,		/**< ClpAppMgrInstalledApp menupos */
+	CLP_APP_MGR_FIELD_ALL		= 0x7ff			/**< every field */
+};
+
 struct _ClpAppMgrActiveApp					/**< Struct for active application info */
 {
 	gint pid;						/**< pid of the application */
@@ -49,6 +65,36 @@ struct _ClpAppMgrActiveApp					/**< Struct for active application info */
 	gboolean immortal;					/**< immortality of the application */
 };
 
+struct _ClpAppMgrActiveAppV2					/**< Compact struct for active application info, see clp_app_mgr_get_active_apps_v2() */
+{
+	gint pid;						/**< pid of the application */
+	const gchar *name;					/**< instance name of the application, interned */
+	const gchar *title;					/**< title of the application, interned */
+	const gchar *icon;					/**< icon of the application, interned, NULL if none */
+	guint visibility : 1;					/**< visibility of the application */
+	guint immortal : 1;					/**< immortality of the application */
+};
+
+enum _ClpAppMgrAppListChangeType				/**< Kind of change of an active application */
+{
+	CLP_APP_MGR_APP_ADDED,					/**< the instance started */
+	CLP_APP_MGR_APP_REMOVED,				/**< the instance exited */
+	CLP_APP_MGR_APP_UPDATED					/**< title, icon, visibility or immortality of the instance changed */
+};
+
+struct _ClpAppMgrAppListChange					/**< One change of the list of active applications */
+{
+	enum _ClpAppMgrAppListChangeType type;			/**< kind of change */
+	guint seq;						/**< serial of the snapshot the change leads to */
+	struct _ClpAppMgrActiveAppV2 app;			/**< new record, the last known record for CLP_APP_MGR_APP_REMOVED */
+};
+
+struct _ClpAppMgrProperty					/**< One property of an application, see clp_app_mgr_get_properties() */
+{
+	const gchar *key;					/**< property name */
+	const gchar *value;					/**< property value, NULL if not set */
+};
+
 struct _ClpAppMgrInstalledApp					/**< Struct for installed application info */
 {
 	gchar *name;						/**< name of the application */
@@ -84,15 +130,33 @@ typedef struct _ClpAppMgrWinResizeInfo
 
 
 
+typedef struct _ClpAppMgrArray					/**< Result of the v2 listing APIs */
+{
+	guint n_records;					/**< number of records */
+	gsize record_size;					/**< size of one record */
+	gpointer records;					/**< the records, their strings follow them in the same block */
+}ClpAppMgrArray;
+
+#define CLP_APP_MGR_ARRAY_INDEX(array, type, i)		(((type *)(array)->records)[(i)])	/**< i-th record of a ClpAppMgrArray */
+
 typedef enum _ClpAppMgrErrorCodes ClpAppMgrErrorCodes;		/**< typedef for enum for error codes */
+typedef enum _ClpAppMgrFields ClpAppMgrFields;			/**< typedef for enum for the field mask */
 typedef struct _ClpAppMgrActiveApp ClpAppMgrActiveApp;		/**< typedef for Active apps structure */
+typedef struct _ClpAppMgrActiveAppV2 ClpAppMgrActiveAppV2;	/**< typedef for compact Active apps structure */
+typedef enum _ClpAppMgrAppListChangeType ClpAppMgrAppListChangeType;	/**< typedef for enum for kind of change */
+typedef struct _ClpAppMgrAppListChange ClpAppMgrAppListChange;	/**< typedef for change of active apps structure */
 typedef struct _ClpAppMgrInstalledApp ClpAppMgrInstalledApp;	/**< typedef for Installed apps struct */
+typedef struct _ClpAppMgrProperty ClpAppMgrProperty;		/**< typedef for application property struct */
+typedef struct _ClpAppMgrMenuIndex ClpAppMgrMenuIndex;		/**< typedef for the opaque menu index of installed apps */
+typedef struct _ClpAppMgrSearch ClpAppMgrSearch;		/**< typedef for the opaque search handle over installed apps */
+typedef struct _ClpAppMgrActiveSnapshot ClpAppMgrActiveSnapshot;	/**< typedef for the opaque snapshot of active apps */
 
 /* API for switiching off the cell ! */
 gint clp_app_mgr_power_off(void);
 
 /* APIs for Window manager Support*/
 GSList* clp_app_mgr_wm_get_window_list();
+ClpAppMgrArray* clp_app_mgr_wm_get_window_list_v2(void);
 gint clp_app_mgr_wm_get_screen_exclusive();
 gint clp_app_mgr_wm_release_screen();
 gint clp_app_mgr_wm_restore_application(gint pid);
@@ -112,19 +176,41 @@ gint clp_app_mgr_apply_theme(const gchar *theme);
 
 /* Querying of information of active applications*/
 GList* clp_app_mgr_get_active_apps();
+ClpAppMgrArray* clp_app_mgr_get_active_apps_v2(void);
+ClpAppMgrArray* clp_app_mgr_get_active_apps_fields(guint fields);
+ClpAppMgrActiveSnapshot* clp_app_mgr_active_snapshot_get(void);
+void clp_app_mgr_active_snapshot_unref(ClpAppMgrActiveSnapshot *snapshot);
+const ClpAppMgrActiveAppV2* clp_app_mgr_active_snapshot_get_apps(ClpAppMgrActiveSnapshot *snapshot, guint *n_apps);
+guint clp_app_mgr_active_snapshot_get_serial(ClpAppMgrActiveSnapshot *snapshot);
+GList* clp_app_mgr_active_snapshot_diff(ClpAppMgrActiveSnapshot *old_snapshot, ClpAppMgrActiveSnapshot *new_snapshot);
 gint clp_app_mgr_get_num_of_active_apps();   				
 GList* clp_app_mgr_get_active_instances_of_app(gchar *appname); 	
 gint clp_app_mgr_get_num_of_active_instances_of_app(gchar *appname);	
 gint clp_app_mgr_is_app_active(gchar *appname);				
 gchar* clp_app_mgr_get_application_id(gint pid);			
 ClpAppMgrActiveApp *clp_app_mgr_get_application_instance_info(gchar *instance_name);	
+ClpAppMgrArray* clp_app_mgr_get_application_instances_info_v2(const gchar * const *instance_names);
 
 /* Querying of information of installed applications*/
 GList* clp_app_mgr_get_installed_apps(gchar *appclass);
+ClpAppMgrArray* clp_app_mgr_get_installed_apps_v2(const gchar *appclass);
+ClpAppMgrArray* clp_app_mgr_get_installed_apps_fields(const gchar *appclass, guint fields);
+gint clp_app_mgr_menupos_compare(gpointer a, gpointer b);
+ClpAppMgrMenuIndex* clp_app_mgr_menu_index_get(void);
+void clp_app_mgr_menu_index_unref(ClpAppMgrMenuIndex *index);
+ClpAppMgrInstalledApp* const* clp_app_mgr_menu_index_lookup(ClpAppMgrMenuIndex *index, const gchar *menu_path, gboolean recursive, guint *n_apps);
+ClpAppMgrSearch* clp_app_mgr_search_new(void);
+ClpAppMgrInstalledApp* const* clp_app_mgr_search_update(ClpAppMgrSearch *search, const gchar *query, guint *n_matches);
+void clp_app_mgr_search_free(ClpAppMgrSearch *search);
+
+/* Results of the v2 listing APIs */
+void clp_app_mgr_array_free(ClpAppMgrArray *array);
 
 /* application configuration APIs */
 gchar* clp_app_mgr_get_property (const gchar *application, const gchar *property);
 void clp_app_mgr_set_property (const gchar *application, const gchar *property, const gchar *value);
+ClpAppMgrArray* clp_app_mgr_get_properties (const gchar *application, const gchar * const *properties);
+void clp_app_mgr_set_properties (const gchar *application, const gchar * const *properties, const gchar * const *values);
 
 #endif
 
@@ -16,18 +16,27 @@
 #include <unistd.h>
 #include "clp-app-mgr-lib.h"
 #include "clp-app-mgr-config.h"
+#include "clp-app-mgr-desktop-db.h"
+#include "clp-app-mgr-monitor.h"
+#include "clp-app-mgr-array.h"
+#include "clp-app-mgr-intern.h"
+#include "clp-app-mgr-shm.h"
+#include "clp-app-mgr-counters.h"
+#include "clp-app-mgr-registry.h"
+#include "clp-app-mgr-writeback.h"
+#include "clp-app-mgr-overlay.h"
+#include "clp-app-mgr-mime-cache.h"
+#include "clp-app-mgr-service-index.h"
+#include "clp-app-mgr-keyfile.h"
+#include "clp-app-mgr-prefetch.h"
+#include "clp-app-mgr-warmup.h"
 #include <xdgmime.h>							/* service discovery :APIs to get mime types based on file name and strings */
 #include <dlfcn.h>
 #include <gtk/gtk.h>
 #include <app-manager.h>
 #include <gconf/gconf-client.h>
 
-#define LIMO_APPS_DIR				"/LiMo/System/AppInfo"
-#define MAX_NO_OF_LINES				100
-#define MAX_NO_OF_APPS_PER_MIME_TYPE		20
-
-static int ClpAppMgrAppLaunchWithArgs (int app_id, void *app_model_data, int *inst_id, va_list va_args);
-static int ClpAppMgrAppLaunchWithArgv (int app_id, void *app_model_data, int *inst_id, int argc, char **params);
+static int ClpAppMgrAppLaunchWithArgv (int app_id, void *app_model_data, int *inst_id, int argc, char **params, gboolean leading_delimiter);
 
 #ifndef ENABLE_FREEZEMGR
 int connect_to_restoredaemon() {return 0;}
@@ -44,13 +53,19 @@ typedef struct _ClpAppMgrGlobalInfo	                		/**< structure for storing
 	gchar		*instance_name;					/**< Instance Name of the application */
 	DBusConnection 	*bus_conn;              	                /**< global DBusConnection pointer*/
 	gboolean	init_done;					/**< boolean to check if clp_app_mgr_init() is done or not*/
+	gint		visibility;					/**< visibility last set by the application, -1 if never set */
 	app_stop 	stop_callback;					/**< function pointer for stop handler*/
 	app_exec	exec_callback;					/**< function pointer for restore handler*/
+	app_exec_fd	exec_fd_callback;				/**< function pointer for restore handler taking a file descriptor*/
 	app_rotate	rotate_callback;				/**< function pointer for rotate handler*/
 	app_death	death_callback;					/**< function pointer for restore handler*/
 	app_focus_gained	app_focus_gained_callback;		/**< function pointer for app_focus_gained handler*/
 	app_focus_lost	app_focus_lost_callback;			/**< function pointer for app_focus_lost handler*/
 	app_message	message_callback;				/**< function pointer for app_messaged*/
+	app_list_change	app_list_change_callback;			/**< function pointer for app list change handler*/
+	ClpAppMgrActiveSnapshot	*app_list_snapshot;			/**< snapshot the last list change notification was computed against */
+	guint		app_list_idle;					/**< idle source of the pending list change notification, 0 if none */
+	guint		app_list_notify;				/**< gconf notification of the registry for the list change handler, 0 if none */
 	post_init	post_init_callback;				/**< function pointer for post_init handler*/
 }ClpAppMgrGlobalInfo;
 
@@ -65,6 +80,7 @@ static gchar dbus_interface[MAX_SIZE] = CLP_APP_MGR_DBUS_INTERFACE;     /**< dbu
 static gchar dbus_object[MAX_SIZE] = CLP_APP_MGR_DBUS_OBJECT;           /**< dbus object path on which the application will be registered */
 
 static DBusHandlerResult message_func (DBusConnection*, DBusMessage*, gpointer);
+static void app_list_change_schedule (void);
 static GSList* read_theme_list(gchar *directory);
 
 
@@ -200,6 +216,9 @@ clp_app_mgr_init (const gchar *name, const guint priority, const ClpAppMgrInstan
 	
 	DBusError error;
 //	gint return_code;
+	/* once, before any GLib object is created: the caches are shared with the warm-up and read-ahead threads */
+	if (!g_thread_supported())
+		g_thread_init(NULL);
 	g_type_init();
 	amp_log_init();
 	load_libsegfault ();
@@ -229,10 +248,11 @@ clp_app_mgr_init (const gchar *name, const guint priority, const ClpAppMgrInstan
 	g_strlcat(dbus_object,"/", MAX_SIZE);
 	g_strlcat(dbus_object, appclient_context.app_name, MAX_SIZE);
 
-	GConfClient *client = gconf_client_get_default();
+	GConfClient *client = clp_app_mgr_registry_client();
 
 	gchar *key_path = g_strconcat(GCONF_APPS_DIR,"/", appclient_context.app_name, "/info/PID", NULL);
 	CLP_APPMGR_INFO_V("Writing PID to Key Path - %s\n", key_path);
+	/* written at once, other processes look the instance up by its PID as soon as it runs */
 	gconf_client_set_int (client, key_path, appclient_context.pid, NULL);
 	g_free(key_path);
 	
@@ -281,11 +301,13 @@ clp_app_mgr_init (const gchar *name, const guint priority, const ClpAppMgrInstan
 
 	appclient_context.stop_callback   = NULL;
 	appclient_context.exec_callback   = NULL;
+	appclient_context.exec_fd_callback = NULL;
 	appclient_context.rotate_callback = NULL;
 	appclient_context.death_callback  = NULL;
 	appclient_context.app_focus_gained_callback = NULL;
 	appclient_context.app_focus_lost_callback = NULL;
 	appclient_context.message_callback = NULL;
+	appclient_context.visibility = -1;
 	appclient_context.init_done = TRUE;
 
 	/* Add the signal match and signal filter for the application so that it receives
@@ -306,6 +328,10 @@ clp_app_mgr_init (const gchar *name, const guint priority, const ClpAppMgrInstan
 	dbus_bus_add_match (appclient_context.bus_conn, match_str2, NULL);
 
 	dbus_connection_add_filter (appclient_context.bus_conn, message_func, NULL, NULL);
+	clp_app_mgr_monitor_signals_connected();
+	clp_app_mgr_shm_update();
+	if (gconf_client_get_bool(client, CLP_APP_MGR_WARMUP_KEY, NULL))
+		clp_app_mgr_warmup_start();
 	CLP_APPMGR_INFO_V("Init Success (App:%s PID:%u)",appclient_context.app_name, appclient_context.pid);
 	CLP_APPMGR_EXIT_FUNCTION();
 	return CLP_APP_MGR_SUCCESS;
@@ -380,6 +406,24 @@ clp_app_mgr_register_exec_handler(const app_exec exec_func)
 }
 
 
+/** \brief Registers the application's exec restore callback function receiving a file descriptor.
+ * 
+ * \param exec_fd_func callback for exec restore signal handler
+ * 
+ * Same as clp_app_mgr_register_exec_handler(), the handler also gets the file descriptor passed to
+ * clp_app_mgr_service_invoke_argv(), or -1 if there is none. The handler owns the descriptor and must close it.
+ * When both handlers are registered, only this one is called.
+ */
+void
+clp_app_mgr_register_exec_fd_handler(const app_exec_fd exec_fd_func)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	appclient_context.exec_fd_callback = exec_fd_func;
+	CLP_APPMGR_EXIT_FUNCTION();
+	return;
+}
+
+
 /** \brief Get the ID of the application
  *
  * \param appname Name of the applications whose ID need to be retreive
@@ -393,160 +437,82 @@ static gint clp_app_mgr_get_app_id(const gchar *appname)
 	CLP_APPMGR_ENTER_FUNCTION();
 	CLP_APPMGR_PARAM_ERROR((appname && (strcmp(appname, ""))),"Parameter 'appname' is NULL");
 	CLP_APPMGR_PARAM_ERROR((strlen(appname) <= NAME_SIZE),"Parameter 'appname' exceeds the maximum allowed name size");
+	static GHashTable *app_ids = NULL;
+	static guint app_ids_generation = 0;
+	G_LOCK_DEFINE_STATIC (app_ids);
 	gint app_id;
+	gpointer cached;
 	GError *err = NULL;
-	GConfClient *client = gconf_client_get_default();
-	gchar *key_path = g_strconcat(GCONF_APPS_DIR, "/", appname, "/info/AppID", NULL);
+	GConfClient *client;
+	const gchar *key_path = clp_app_mgr_app_names_get(appname)->app_id_key;
+	guint generation = clp_app_mgr_monitor_get_generation(CLP_APP_MGR_MONITOR_REGISTRY);
+
+	/* the key path is interned, it identifies the application */
+	G_LOCK(app_ids);
+	if (app_ids == NULL)
+		app_ids = g_hash_table_new(g_direct_hash, g_direct_equal);
+	else if (app_ids_generation != generation)
+		g_hash_table_remove_all(app_ids);
+	app_ids_generation = generation;
+	if (g_hash_table_lookup_extended(app_ids, key_path, NULL, &cached))
+	{
+		G_UNLOCK(app_ids);
+		CLP_APPMGR_EXIT_FUNCTION();
+		return GPOINTER_TO_INT(cached);
+	}
+	G_UNLOCK(app_ids);
+
+	client = clp_app_mgr_registry_client();
 	app_id = gconf_client_get_int (client, key_path, &err);
 	CLP_APPMGR_INFO_V("Key Path - %s Value : %d\n", key_path, app_id);
-	g_free(key_path);
-	CLP_APPMGR_EXIT_FUNCTION();
-	return app_id;
-}
-
-
-/** \brief Launches the application whose Name is passed as parameter
- *
- * \param application the name of the application to be execed from the caller application 
- *  
- * \return CLP_APP_MGR_SUCCESS - Application exec was successful.
- * \return CLP_APP_MGR_FAILURE - Application exec failed.
- * \return CLP_APP_MGR_OUT_OF_MEMORY - Out Of memory
- * \return CLP_APP_MGR_DBUS_CALL_FAIL - DBus Calls failed.
- * \return CLP_APP_MGR_DBUS_REPLY_FAIL - Pending reply Null.
- *  	   
- * This API can be used for launching the applications on request from other components or applications.
- * The destination application name will be followed by {name value } pairs and truncated by NULL
- * If application doesnt exist failure will be returned
- * This function will be wrapped by CelApp.
- */
-gint clp_app_mgr_exec(const gchar *application, ...)
-{
-	CLP_APPMGR_ENTER_FUNCTION();
-	CLP_APPMGR_PARAM_ERROR((application && (strcmp(application, ""))),"Parameter 'application' is NULL");
-	CLP_APPMGR_PARAM_ERROR((strlen(application) <= NAME_SIZE),"Parameter 'application' exceeds the maximum allowed name size");
-	va_list args;
-	gchar *value;
-	gint return_code, inst_id, app_id;
-	gint no_of_params = 1;
-	gchar *params[NAME_SIZE];
-	app_id = clp_app_mgr_get_app_id(application);
-
-	// calls the exec with params and the parameters to be passed are taken from the service and argc,argv format.
-	va_start (args, application);
-	return_code = ClpAppMgrAppLaunchWithArgs (app_id, NULL , &inst_id, args);
-	
-	value = va_arg(args, char*);
-	if(return_code == APPMGR_ERROR_APP_ALREADY_RUNNING)
+	if (err)
+		g_error_free(err);
+	else
 	{
-		DBusMessageIter iter, array_iter;
-		gchar 		array_sig[2];
-		gint 		i;
-		DBusError 	error;
-		array_sig[0] = DBUS_TYPE_STRING;
-		array_sig[1] = '\0';
-		
-		gchar *app_interface = g_strconcat (CLP_APP_MGR_DBUS_INTERFACE,".", application, NULL);
-		gchar *app_objectpath =	g_strconcat (CLP_APP_MGR_DBUS_OBJECT, "/", application, NULL);
-		
-		while (value) {
-			params[no_of_params] = g_strdup(value);
-			no_of_params++;
-			value = va_arg (args, char*);
-		}
-
-		CLP_APPMGR_INFO_V("Restore ( Application : %s(%d), ObjectPath : %s, Interface: %s Num of Params : %d)", application, app_id, app_objectpath, app_interface, no_of_params);
-		dbus_error_init (&error);
-		
-		DBusConnection *bus_conn = dbus_bus_get (DBUS_BUS_SYSTEM, &error);
-
-		DBusMessage *msg = dbus_message_new_signal (app_objectpath, app_interface, CLP_APP_MGR_DBUS_SIGNAL_EXEC);
-		if(msg == NULL)
-        	{
-			CLP_APPMGR_WARN("Not Enough Memory to create new dbus Message");
-                	CLP_APPMGR_EXIT_FUNCTION();
-			return CLP_APP_MGR_DBUS_CALL_FAIL;
-		}
-	
-		dbus_message_iter_init_append(msg, &iter);
-		dbus_message_iter_append_basic(&iter, DBUS_TYPE_UINT32, &no_of_params);
-		dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, array_sig, &array_iter);
-		dbus_message_iter_append_basic (&array_iter, DBUS_TYPE_STRING, &application);
-		
-		for(i=1; i<no_of_params; i++) {
-			CLP_APPMGR_INFO_V("Restore ( Param %u : %s )",i, params[i]);
-			dbus_message_iter_append_basic(&array_iter, DBUS_TYPE_STRING, &params[i]);
-		}
-		dbus_message_iter_close_container(&iter, &array_iter);
-
-		if (!dbus_connection_send(bus_conn, msg, 0)) 
-		{
-			CLP_APPMGR_WARN("Out Of Memory!");
-			return CLP_APP_MGR_OUT_OF_MEMORY;
-		}
-	
-		g_free(app_interface);
-		g_free(app_objectpath);	
-		dbus_connection_flush(bus_conn);
-		dbus_message_unref(msg);
+		G_LOCK(app_ids);
+		if (app_ids_generation == generation)
+			g_hash_table_insert(app_ids, (gpointer) key_path, GINT_TO_POINTER(app_id));
+		G_UNLOCK(app_ids);
 	}
-	else if(return_code!=0||inst_id<=0)
-        {
-                CLP_APPMGR_WARN_V("Launching application[%d] failed !! Error_Code :%d", inst_id, return_code);
-		va_end(args);
-		CLP_APPMGR_EXIT_FUNCTION();
-		return CLP_APP_MGR_FAILURE;
-        }
-	va_end(args);
 	CLP_APPMGR_EXIT_FUNCTION();
-	return CLP_APP_MGR_SUCCESS;
+	return app_id;
 }
 
 
-/** \brief Limo AMS implementation for LunchWithArgs
+/** \brief Limo AMS implementation for LunchWithArgv
  *
  * \param app_id AppID of the application to be launched.
  * \param app_model_data AppModel with which the application to be launched.
  * \param inst_id Return value of the inst id assigned to launched application.
- * \param va_args VA_LIST for parameters to be passed with application.
+ * \param argc Number of parameters to be passed with application.
+ * \param params List of parameters to be passed with application.
+ * \param leading_delimiter TRUE to put a delimiter before the first parameter too, as clp_app_mgr_exec_argv() always did.
  *
  * \return ERROR_CODE (LIMO error_codes). 0 on successfully launching the application.
  */
-static int ClpAppMgrAppLaunchWithArgs (int app_id, void *app_model_data, int *inst_id, va_list va_args)
+static int ClpAppMgrAppLaunchWithArgv (int app_id, void *app_model_data, int *inst_id, int argc, char **params, gboolean leading_delimiter)
 {
 	CLP_APPMGR_ENTER_FUNCTION();
 	DBusGProxy *proxy;
 	GError *error = NULL;
 	int error_code = -1;
-	char *args = NULL;
-	char *value;
+	GString *args;
+	int i;
 	char delim[2];
 	delim[0] = 16;
-	delim[1] ='\0';
+	delim[1] = '\0';
 
-	GConfClient *client = gconf_client_get_default();
+	GConfClient *client = clp_app_mgr_registry_client();
 	gboolean shutdown = gconf_client_get_bool(client,"/appmgr/Shutdown",NULL);
 	if (shutdown)
 		return -1;
-	g_object_unref(G_OBJECT(client));
-	
+
 	if ( inst_id == NULL)
 	{
 		CLP_APPMGR_WARN("Inst_ID pointer is NULL !!");
 		CLP_APPMGR_EXIT_FUNCTION();
 		return -8;
 	}
-
-	value = va_arg(va_args, char*);
-	if(value) {
-		args = g_strdup(value);
-		
-		value = va_arg(va_args, char*);
-		while(value) {
-			args = g_strconcat(args, delim, value, NULL);
-			value = va_arg(va_args, char*);
-		}
-	}
 	
 	if ( !app_get_dbus_proxy(&proxy))
 	{
@@ -554,10 +520,17 @@ static int ClpAppMgrAppLaunchWithArgs (int app_id, void *app_model_data, int *in
 		CLP_APPMGR_EXIT_FUNCTION();
 		return APPMGR_ERROR_INTERNAL_TRANSPORT_ERROR;
 	}
+
+	args = g_string_new(NULL);
+	for (i = 0; i < argc; i++) {
+		if (i > 0 || leading_delimiter)
+			g_string_append(args, delim);
+		g_string_append(args, params[i]);
+	}
 	
 	if (!dbus_g_proxy_call (proxy, "app_launch_call",&error,
 				G_TYPE_INT, app_id,
-				G_TYPE_STRING,args,
+				G_TYPE_STRING,args->str,
 				G_TYPE_UINT, app_model_data,
 				G_TYPE_INVALID,
 				G_TYPE_INT, inst_id,
@@ -566,17 +539,19 @@ static int ClpAppMgrAppLaunchWithArgs (int app_id, void *app_model_data, int *in
 	{
 		CLP_APPMGR_WARN("Unable to make proxy call !");
 		error_code = APPMGR_ERROR_INTERNAL_TRANSPORT_ERROR;
+		g_string_free(args, TRUE);
 		g_object_unref (proxy);
 		CLP_APPMGR_EXIT_FUNCTION();
 		return error_code;
 	}
         
+	g_string_free(args, TRUE);
 	g_object_unref (proxy);
 	
-	if (0 == error_code)	
+	if (0 == error_code)
 	{
 		CLP_APPMGR_INFO_V("Application (AppID - %d) launched successfully.",app_id);
-		CLP_APPMGR_ENTER_FUNCTION();
+		CLP_APPMGR_EXIT_FUNCTION();
 		return 0;
 	}
 	else
@@ -588,185 +563,152 @@ static int ClpAppMgrAppLaunchWithArgs (int app_id, void *app_model_data, int *in
 }
 
 
-/** \brief Launches the application whose Name is passed as parameter
+/** \brief Internal function forwarding the parameters to an application already running
  *
- * \param application the name of the application to be execed from the caller application 
- * \param old_ap variable argument list of parameters to be supplied to the application
- *  
- * \return CLP_APP_MGR_SUCCESS - Application exec was successful.
- * \return CLP_APP_MGR_FAILURE - Application exec failed.
- * \return CLP_APP_MGR_OUT_OF_MEMORY - Out Of memory
- * \return CLP_APP_MGR_DBUS_CALL_FAIL - DBus Calls failed.
- * \return CLP_APP_MGR_DBUS_REPLY_FAIL - Pending reply Null.
- *  	   
- * This API can be used for launching the applications on request from other components.
- * If application doesnt exist failure will be returned
+ * \param application Name of the application
+ * \param app_id ID of the application
+ * \param no_of_params Number of parameters
+ * \param params_list The parameters
+ * \param fd File descriptor appended to the exec signal, -1 for none. The caller keeps its own descriptor.
+ *
+ * \return CLP_APP_MGR_SUCCESS, CLP_APP_MGR_DBUS_CALL_FAIL or CLP_APP_MGR_OUT_OF_MEMORY
+ *
+ * The application receives the exec signal, i.e. its exec handler is called with the name of the application
+ * followed by the parameters.
+ * \warning This function is internal to the Library
  */
-gint 
-clp_app_mgr_exec_application (const gchar *application, const va_list old_ap)
+static gint
+clp_app_mgr_forward_exec(const gchar *application, gint app_id, gint no_of_params, gchar **params_list, gint fd)
 {
 	CLP_APPMGR_ENTER_FUNCTION();
-	CLP_APPMGR_PARAM_ERROR((application && (strcmp(application, ""))),"Parameter 'application' is NULL");
-	CLP_APPMGR_PARAM_ERROR((strlen(application) <= NAME_SIZE),"Parameter 'application' exceeds the maximum allowed name size");
-	gchar *value;
-	gint return_code, inst_id, app_id;
-	gint no_of_params = 1;
-	gchar *params[NAME_SIZE];
+	DBusMessageIter iter, array_iter;
+	gchar 		array_sig[2];
+	gint 		i;
+	guint		no_of_strings = no_of_params + 1;
+	DBusError 	error;
+	array_sig[0] = DBUS_TYPE_STRING;
+	array_sig[1] = '\0';
 
-	app_id = clp_app_mgr_get_app_id(application);
+	const ClpAppMgrAppNames *names = clp_app_mgr_app_names_get(application);
+	const gchar *app_interface = names->interface;
+	const gchar *app_objectpath = names->object_path;
 
-	// calls the exec with params and the parameters to be passed are taken from the service and argc,argv format.
-	return_code = ClpAppMgrAppLaunchWithArgs (app_id, NULL , &inst_id, old_ap);
-	value = va_arg(old_ap, char*);
-	if(return_code == APPMGR_ERROR_APP_ALREADY_RUNNING)
+	CLP_APPMGR_INFO_V("Restore ( Application : %s(%d), ObjectPath : %s, Interface: %s Num of Params : %u)", application, app_id, app_objectpath, app_interface, no_of_strings);
+	dbus_error_init (&error);
+	DBusConnection *bus_conn = dbus_bus_get (DBUS_BUS_SYSTEM, &error);
+	DBusMessage *msg = dbus_message_new_signal (app_objectpath, app_interface, CLP_APP_MGR_DBUS_SIGNAL_EXEC);
+	if(msg == NULL)
 	{
-		DBusMessageIter iter, array_iter;
-		gchar 		array_sig[2];
-		gint 		i;
-		DBusError 	error;
-		array_sig[0] = DBUS_TYPE_STRING;
-		array_sig[1] = '\0';
-
-		gchar *app_interface = g_strconcat (CLP_APP_MGR_DBUS_INTERFACE,".", application, NULL);
-		gchar *app_objectpath =	g_strconcat (CLP_APP_MGR_DBUS_OBJECT, "/", application, NULL);
+		CLP_APPMGR_WARN("Not Enough Memory to create new dbus Message");
+		CLP_APPMGR_EXIT_FUNCTION();
+		return CLP_APP_MGR_DBUS_CALL_FAIL;
+	}
 
-		while (value) {
-			params[no_of_params] = g_strdup(value);
-			no_of_params++;
-			value = va_arg (old_ap, char*);
-		}
+	dbus_message_iter_init_append(msg, &iter);
+	dbus_message_iter_append_basic(&iter, DBUS_TYPE_UINT32, &no_of_strings);
+	dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, array_sig, &array_iter);
+	dbus_message_iter_append_basic (&array_iter, DBUS_TYPE_STRING, &application);
+	for(i=0; i<no_of_params; i++) {
+		CLP_APPMGR_INFO_V("Restore ( Param %u : %s )",i + 1, params_list[i]);
+		dbus_message_iter_append_basic(&array_iter, DBUS_TYPE_STRING, &params_list[i]);
+	}
+	dbus_message_iter_close_container(&iter, &array_iter);
 
-		CLP_APPMGR_INFO_V("Restore ( Application : %s(%d), ObjectPath : %s, Interface: %s Num of Params : %d)", application, app_id, app_objectpath, app_interface, no_of_params);
-		dbus_error_init (&error);
-		
-		DBusConnection *bus_conn = dbus_bus_get (DBUS_BUS_SYSTEM, &error);
-
-		DBusMessage *msg = dbus_message_new_signal (app_objectpath, app_interface, CLP_APP_MGR_DBUS_SIGNAL_EXEC);
-		if(msg == NULL)
-        	{
-			CLP_APPMGR_WARN("Not Enough Memory to create new dbus Message");
-                	CLP_APPMGR_EXIT_FUNCTION();
-			return CLP_APP_MGR_DBUS_CALL_FAIL;
-		}
-	
-		dbus_message_iter_init_append(msg, &iter);
-		dbus_message_iter_append_basic(&iter, DBUS_TYPE_UINT32, &no_of_params);
-		dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, array_sig, &array_iter);
-		dbus_message_iter_append_basic (&array_iter, DBUS_TYPE_STRING, &application);
-		
-		for(i=1; i<no_of_params; i++) {
-			CLP_APPMGR_INFO_V("Restore ( Param %u : %s )",i, params[i]);
-			dbus_message_iter_append_basic(&array_iter, DBUS_TYPE_STRING, &params[i]);
-		}
-		dbus_message_iter_close_container(&iter, &array_iter);
+	if (fd >= 0)
+	{
+#ifdef DBUS_TYPE_UNIX_FD
+		if (dbus_connection_can_send_type(bus_conn, DBUS_TYPE_UNIX_FD))
+			dbus_message_iter_append_basic(&iter, DBUS_TYPE_UNIX_FD, &fd);
+		else
+#endif
+			CLP_APPMGR_WARN_V("The bus cannot pass file descriptors, %s gets the parameters only", application);
+	}
 
-		if (!dbus_connection_send(bus_conn, msg, 0))
-		{
-			CLP_APPMGR_WARN("Out Of Memory!");
-			return CLP_APP_MGR_OUT_OF_MEMORY;			
-		}
-		
-		g_free(app_interface);
-		g_free(app_objectpath);
-		dbus_connection_flush(bus_conn);
+	if (!dbus_connection_send(bus_conn, msg, 0))
+	{
+		CLP_APPMGR_WARN("Out Of Memory!");
 		dbus_message_unref(msg);
-	}
-	else if(return_code!=0||inst_id<=0)
-        {
-		CLP_APPMGR_WARN_V("Launching application[%d] failed !! Error_Code :%d", inst_id, return_code);
 		CLP_APPMGR_EXIT_FUNCTION();
-		return CLP_APP_MGR_FAILURE;
-        }
+		return CLP_APP_MGR_OUT_OF_MEMORY;
+	}
+
+	dbus_connection_flush(bus_conn);
+	dbus_message_unref(msg);
 	CLP_APPMGR_EXIT_FUNCTION();
 	return CLP_APP_MGR_SUCCESS;
 }
 
 
-/** \brief Limo AMS implementation for LunchWithArgv
+/** \brief Internal function launching an application, or forwarding the parameters to it if it is running
  *
- * \param app_id AppID of the application to be launched.
- * \param app_model_data AppModel with which the application to be launched.
- * \param inst_id Return value of the inst id assigned to launched application.
- * \param params List of parameters to be passed with application.
+ * \param application Name of the application
+ * \param no_of_params Number of parameters
+ * \param params_list The parameters
+ * \param leading_delimiter Passed to ClpAppMgrAppLaunchWithArgv()
+ * \param fd File descriptor for the application, -1 for none. Only an application already running can get it.
  *
- * \return ERROR_CODE (LIMO error_codes). 0 on successfully launching the application.
+ * \return The codes of clp_app_mgr_exec_argv()
+ *
+ * \warning This function is internal to the Library
  */
-static int ClpAppMgrAppLaunchWithArgv (int app_id, void *app_model_data, int *inst_id, int argc, char **params)
+static gint
+clp_app_mgr_launch_or_forward(const gchar *application, gint no_of_params, gchar **params_list, gboolean leading_delimiter, gint fd)
 {
 	CLP_APPMGR_ENTER_FUNCTION();
-	DBusGProxy *proxy;
-	GError *error = NULL;
-	int error_code = -1;
-	char *args = "";
-	int i = 0;
-	char delim[2];
-	delim[0] = 16;
-	delim[1] = '\0';
+	gint return_code, inst_id, app_id;
 
-	GConfClient *client = gconf_client_get_default();
-	gboolean shutdown = gconf_client_get_bool(client,"/appmgr/Shutdown",NULL);
-	if (shutdown)
-		return -1;
-	g_object_unref(G_OBJECT(client));
+	app_id = clp_app_mgr_get_app_id(application);
 
-	if ( inst_id == NULL)
-	{
-		CLP_APPMGR_WARN("Inst_ID pointer is NULL !!");
-		CLP_APPMGR_EXIT_FUNCTION();
-		return -8;
-	}
-	
-	while(argc>0) {
-		args = g_strconcat(args,delim, params[i], NULL);
-		i++;
-		argc--;
-	}
-	
-	if ( !app_get_dbus_proxy(&proxy))
-	{
-		CLP_APPMGR_WARN("Unable to get LIMO AMS dbus proxy !");
-		CLP_APPMGR_EXIT_FUNCTION();
-		return APPMGR_ERROR_INTERNAL_TRANSPORT_ERROR;
-	}
-	
-if (!dbus_g_proxy_call (proxy, "app_launch_call",&error,
-				G_TYPE_INT, app_id,
-				G_TYPE_STRING,args,
-				G_TYPE_UINT, app_model_data,
-				G_TYPE_INVALID,
-				G_TYPE_INT, inst_id,
-                		G_TYPE_INT, &error_code,
-				G_TYPE_INVALID))
-	{
-		CLP_APPMGR_WARN("Unable to make proxy call !");
-		error_code = APPMGR_ERROR_INTERNAL_TRANSPORT_ERROR;
-		g_object_unref (proxy);
-		CLP_APPMGR_EXIT_FUNCTION();
-		return error_code;
-	}
-        
-	g_object_unref (proxy);
-	
-	if (0 == error_code)
+	// calls the exec with params and the parameters to be passed are taken from the service and argc,argv format.
+	return_code = ClpAppMgrAppLaunchWithArgv (app_id, NULL , &inst_id, no_of_params, params_list, leading_delimiter);
+
+	if(return_code == APPMGR_ERROR_APP_ALREADY_RUNNING)
 	{
-		CLP_APPMGR_INFO_V("Application (AppID - %d) launched successfully.",app_id);
+		return_code = clp_app_mgr_forward_exec(application, app_id, no_of_params, params_list, fd);
 		CLP_APPMGR_EXIT_FUNCTION();
-		return 0;
+		return return_code;
 	}
-	else
+	else if(return_code!=0||inst_id<=0)
 	{
-		CLP_APPMGR_INFO_V("Unable to launch application (AppID - %d) Error code - %d!", app_id, error_code);
+		CLP_APPMGR_WARN_V("Launching application[%d] failed !! Error_Code :%d", inst_id, return_code);
 		CLP_APPMGR_EXIT_FUNCTION();
-		return error_code;
+		return CLP_APP_MGR_FAILURE;
 	}
+	if (fd >= 0)
+		CLP_APPMGR_WARN_V("%s was launched, the launch cannot carry the file descriptor", application);
+	clp_app_mgr_counters_launched(app_id);
+	clp_app_mgr_shm_launched();
+	CLP_APPMGR_EXIT_FUNCTION();
+	return CLP_APP_MGR_SUCCESS;
 }
 
 
-/** \brief Launches the application with arguments passed in argc argv format
+/** \brief Internal function reading a NULL terminated variable argument list of strings
+ *
+ * \param ap The list, consumed
+ * \param no_of_params Returns the number of strings
+ *
+ * \return NULL terminated array of the strings, the strings are not copied. To be freed with g_free().
+ *
+ * \warning This function is internal to the Library
+ */
+static gchar**
+clp_app_mgr_collect_args(va_list ap, gint *no_of_params)
+{
+	GPtrArray *params = g_ptr_array_new();
+	gchar *value;
+
+	while ((value = va_arg(ap, gchar*)) != NULL)
+		g_ptr_array_add(params, value);
+	*no_of_params = params->len;
+	g_ptr_array_add(params, NULL);
+	return (gchar**) g_ptr_array_free(params, FALSE);
+}
+
+
+/** \brief Launches the application whose Name is passed as parameter
  *
  * \param application the name of the application to be execed from the caller application 
- * \param no_of_params no of arguments the application takes
- * \param params_list arguments list which application takes
  *  
  * \return CLP_APP_MGR_SUCCESS - Application exec was successful.
  * \return CLP_APP_MGR_FAILURE - Application exec failed.
@@ -774,77 +716,90 @@ if (!dbus_g_proxy_call (proxy, "app_launch_call",&error,
  * \return CLP_APP_MGR_DBUS_CALL_FAIL - DBus Calls failed.
  * \return CLP_APP_MGR_DBUS_REPLY_FAIL - Pending reply Null.
  *  	   
- * This API can be used for launching the applications on request from other components.
+ * This API can be used for launching the applications on request from other components or applications.
+ * The destination application name will be followed by {name value } pairs and truncated by NULL
  * If application doesnt exist failure will be returned
+ * This function will be wrapped by CelApp.
  */
-gint 
-clp_app_mgr_exec_argv (const gchar *application, gint no_of_params, gchar** params_list)
+gint clp_app_mgr_exec(const gchar *application, ...)
 {
 	CLP_APPMGR_ENTER_FUNCTION();
 	CLP_APPMGR_PARAM_ERROR((application && (strcmp(application, ""))),"Parameter 'application' is NULL");
 	CLP_APPMGR_PARAM_ERROR((strlen(application) <= NAME_SIZE),"Parameter 'application' exceeds the maximum allowed name size");
-	gint return_code, inst_id, app_id;
+	va_list args;
+	gchar **params;
+	gint no_of_params, return_code;
 
-	app_id = clp_app_mgr_get_app_id(application);
+	va_start (args, application);
+	params = clp_app_mgr_collect_args(args, &no_of_params);
+	va_end(args);
 
-	// calls the exec with params and the parameters to be passed are taken from the service and argc,argv format.
-	return_code = ClpAppMgrAppLaunchWithArgv (app_id, NULL , &inst_id, no_of_params, params_list);
-	
-	if(return_code == APPMGR_ERROR_APP_ALREADY_RUNNING)
-	{
-		DBusMessageIter iter, array_iter;
-		gchar 		array_sig[2];
-		gint 		i;
-		DBusError 	error;
-		array_sig[0] = DBUS_TYPE_STRING;
-		array_sig[1] = '\0';
-		
-		gchar *app_interface = g_strconcat (CLP_APP_MGR_DBUS_INTERFACE,".", application, NULL);
-		gchar *app_objectpath =	g_strconcat (CLP_APP_MGR_DBUS_OBJECT, "/", application, NULL);
-
-		CLP_APPMGR_INFO_V("Restore ( Application : %s(%d), ObjectPath : %s, Interface: %s Num of Params : %d)", application, app_id, app_objectpath, app_interface, no_of_params);
-		dbus_error_init (&error);
-		DBusConnection *bus_conn = dbus_bus_get (DBUS_BUS_SYSTEM, &error);
-		DBusMessage *msg = dbus_message_new_signal (app_objectpath, app_interface, CLP_APP_MGR_DBUS_SIGNAL_EXEC);
-		if(msg == NULL)
-        	{
-			CLP_APPMGR_WARN("Not Enough Memory to create new dbus Message");
-                	CLP_APPMGR_EXIT_FUNCTION();
-			return CLP_APP_MGR_DBUS_CALL_FAIL;
-		}
-		no_of_params++;
-		dbus_message_iter_init_append(msg, &iter);
-		dbus_message_iter_append_basic(&iter, DBUS_TYPE_UINT32, &no_of_params);
-		dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, array_sig, &array_iter);
-		dbus_message_iter_append_basic (&array_iter, DBUS_TYPE_STRING, &application);
-		no_of_params--;
-		
-		for(i=0; i<no_of_params; i++) {
-			CLP_APPMGR_INFO_V("Restore ( Param %u : %s )",i, params_list[i]);
-			dbus_message_iter_append_basic(&array_iter, DBUS_TYPE_STRING, &params_list[i]);
-		}
-		dbus_message_iter_close_container(&iter, &array_iter);
+	return_code = clp_app_mgr_launch_or_forward(application, no_of_params, params, FALSE, -1);
+	g_free(params);
+	CLP_APPMGR_EXIT_FUNCTION();
+	return return_code;
+}
 
-		if (!dbus_connection_send(bus_conn, msg, 0))
-		{
-			CLP_APPMGR_WARN("Out Of Memory!");
-			return CLP_APP_MGR_OUT_OF_MEMORY;
-		}
-	
-		g_free(app_interface);
-		g_free(app_objectpath);	
-		dbus_connection_flush(bus_conn);
-		dbus_message_unref(msg);
-	}
 
-	else if(return_code!=0||inst_id<=0)
-        {
-		CLP_APPMGR_WARN_V("Launching application[%d] failed !! Error_Code :%d", inst_id, return_code);
-		CLP_APPMGR_EXIT_FUNCTION();
-		return CLP_APP_MGR_FAILURE;
-        }
+/** \brief Launches the application whose Name is passed as parameter
+ *
+ * \param application the name of the application to be execed from the caller application 
+ * \param ap variable argument list of parameters to be supplied to the application, read to its end
+ *  
+ * \return CLP_APP_MGR_SUCCESS - Application exec was successful.
+ * \return CLP_APP_MGR_FAILURE - Application exec failed.
+ * \return CLP_APP_MGR_OUT_OF_MEMORY - Out Of memory
+ * \return CLP_APP_MGR_DBUS_CALL_FAIL - DBus Calls failed.
+ * \return CLP_APP_MGR_DBUS_REPLY_FAIL - Pending reply Null.
+ *  	   
+ * This API can be used for launching the applications on request from other components.
+ * If application doesnt exist failure will be returned
+ */
+gint 
+clp_app_mgr_exec_application (const gchar *application, va_list ap)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	CLP_APPMGR_PARAM_ERROR((application && (strcmp(application, ""))),"Parameter 'application' is NULL");
+	CLP_APPMGR_PARAM_ERROR((strlen(application) <= NAME_SIZE),"Parameter 'application' exceeds the maximum allowed name size");
+	gchar **params;
+	gint no_of_params, return_code;
+
+	/* the list is read once, the launch and the exec signal both use the array */
+	params = clp_app_mgr_collect_args(ap, &no_of_params);
+
+	return_code = clp_app_mgr_launch_or_forward(application, no_of_params, params, FALSE, -1);
+	g_free(params);
 	CLP_APPMGR_EXIT_FUNCTION();
-	return CLP_APP_MGR_SUCCESS;
+	return return_code;
+}
+
+
+/** \brief Launches the application with arguments passed in argc argv format
+ *
+ * \param application the name of the application to be execed from the caller application 
+ * \param no_of_params no of arguments the application takes
+ * \param params_list arguments list which application takes
+ *  
+ * \return CLP_APP_MGR_SUCCESS - Application exec was successful.
+ * \return CLP_APP_MGR_FAILURE - Application exec failed.
+ * \return CLP_APP_MGR_OUT_OF_MEMORY - Out Of memory
+ * \return CLP_APP_MGR_DBUS_CALL_FAIL - DBus Calls failed.
+ * \return CLP_APP_MGR_DBUS_REPLY_FAIL - Pending reply Null.
+ *  	   
+ * This API can be used for launching the applications on request from other components.
+ * If application doesnt exist failure will be returned
+ */
+gint 
+clp_app_mgr_exec_argv (const gchar *application, gint no_of_params, gchar** params_list)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	CLP_APPMGR_PARAM_ERROR((application && (strcmp(application, ""))),"Parameter 'application' is NULL");
+	CLP_APPMGR_PARAM_ERROR((strlen(application) <= NAME_SIZE),"Parameter 'application' exceeds the maximum allowed name size");
+	gint return_code;
+
+	return_code = clp_app_mgr_launch_or_forward(application, no_of_params, params_list, TRUE, -1);
+	CLP_APPMGR_EXIT_FUNCTION();
+	return return_code;
 }
 
 
@@ -891,9 +846,9 @@ clp_app_mgr_stop(const gchar *app)
 	CLP_APPMGR_PARAM_ERROR((strlen(app) <= NAME_SIZE),"Parameter 'app' exceeds the maximum allowed name size");
 	DBusError 	error;
 		
-	gchar **split = g_strsplit(app,":",2);
-	gchar *app_interface = g_strconcat (CLP_APP_MGR_DBUS_INTERFACE,".", split[0], split[1], NULL);
-	gchar *app_objectpath =	g_strconcat (CLP_APP_MGR_DBUS_OBJECT, "/", split[0], split[1], NULL);
+	const ClpAppMgrAppNames *names = clp_app_mgr_app_names_get(app);
+	const gchar *app_interface = names->interface;
+	const gchar *app_objectpath = names->object_path;
 	
 	CLP_APPMGR_INFO_V("Sending STOP Signal ( Application : %s, ObjectPath : %s, Interface: %s)", app, app_objectpath, app_interface);
 	dbus_error_init (&error);
@@ -913,8 +868,6 @@ clp_app_mgr_stop(const gchar *app)
 		return CLP_APP_MGR_OUT_OF_MEMORY;
 	}
 
-	g_free(app_interface);
-	g_free(app_objectpath);
 	dbus_connection_flush(bus_conn);
 	dbus_message_unref(msg);
 	return CLP_APP_MGR_SUCCESS;
@@ -1000,22 +953,14 @@ clp_app_mgr_close_by_red_key(const gchar *app)
 	
 	gint inst_id, return_code;
 	GError *err = NULL;
-	GConfClient *client = gconf_client_get_default();
-	gchar *key_path = g_strconcat(GCONF_APPS_DIR, "/", app, "/LastInstId", NULL);
-	inst_id = gconf_client_get_int (client, key_path, &err);
-	CLP_APPMGR_INFO_V("Key Path - %s Inst ID : %d\n", key_path, inst_id);
-	g_free(key_path);
+	GConfClient *client = clp_app_mgr_registry_client();
+	const ClpAppMgrAppNames *names = clp_app_mgr_app_names_get(app);
+	inst_id = gconf_client_get_int (client, names->last_inst_id_key, &err);
+	CLP_APPMGR_INFO_V("Key Path - %s Inst ID : %d\n", names->last_inst_id_key, inst_id);
 
 	DBusMessage *msg;
-	gchar dbusinterface[MAX_SIZE] = CLP_APP_MGR_DBUS_INTERFACE;     /**< dbus Interface on which the application waits for signals */ 
-	gchar dbusobject[MAX_SIZE] = CLP_APP_MGR_DBUS_OBJECT;           /**< dbus object path on which the application will be registered */
-		
-	g_strlcat(dbusinterface, ".", MAX_SIZE);
-	g_strlcat(dbusinterface, app, MAX_SIZE);
-	g_strlcat(dbusobject, "/", MAX_SIZE);
-	g_strlcat(dbusobject, app, MAX_SIZE);
 	
-	msg = dbus_message_new_signal (dbusobject, dbusinterface, CLP_APP_MGR_DBUS_SIGNAL_STOP);
+	msg = dbus_message_new_signal (names->object_path, names->interface, CLP_APP_MGR_DBUS_SIGNAL_STOP);
      	 
 	if (NULL == msg)
        	{ 
@@ -1061,22 +1006,14 @@ clp_app_mgr_close_by_name(const gchar *app)
 
 	gint inst_id, return_code;
 	GError *err = NULL;
-	GConfClient *client = gconf_client_get_default();
-	gchar *key_path = g_strconcat(GCONF_APPS_DIR, "/", app, "/LastInstId", NULL);
-	inst_id = gconf_client_get_int (client, key_path, &err);
-	CLP_APPMGR_INFO_V("Key Path - %s Inst ID : %d\n", key_path, inst_id);
-	g_free(key_path);
+	GConfClient *client = clp_app_mgr_registry_client();
+	const ClpAppMgrAppNames *names = clp_app_mgr_app_names_get(app);
+	inst_id = gconf_client_get_int (client, names->last_inst_id_key, &err);
+	CLP_APPMGR_INFO_V("Key Path - %s Inst ID : %d\n", names->last_inst_id_key, inst_id);
 
 	DBusMessage *msg;
-	gchar dbusinterface[MAX_SIZE] = CLP_APP_MGR_DBUS_INTERFACE;     /**< dbus Interface on which the application waits for signals */ 
-	gchar dbusobject[MAX_SIZE] = CLP_APP_MGR_DBUS_OBJECT;           /**< dbus object path on which the application will be registered */
-		
-	g_strlcat(dbusinterface, ".", MAX_SIZE);
-	g_strlcat(dbusinterface, app, MAX_SIZE);
-	g_strlcat(dbusobject, "/", MAX_SIZE);
-	g_strlcat(dbusobject, app, MAX_SIZE);
 	
-	msg = dbus_message_new_signal (dbusobject, dbusinterface, CLP_APP_MGR_DBUS_SIGNAL_STOP);
+	msg = dbus_message_new_signal (names->object_path, names->interface, CLP_APP_MGR_DBUS_SIGNAL_STOP);
      	 
 	if (NULL == msg)
        	{ 
@@ -1147,6 +1084,50 @@ message_func (DBusConnection *bus_conn, DBusMessage *msg, gpointer user_data)
 	CLP_APPMGR_ENTER_FUNCTION();
 	CLP_APPMGR_INFO_V("Signal Received %s %s, Sender : %s", dbus_message_get_interface(msg), dbus_message_get_member(msg), dbus_message_get_sender(msg));
 
+	/* Lifecycle signals update the instance counters... */
+	if (dbus_message_is_signal (msg, CLP_APP_MGR_DBUS_INTERFACE, CLP_APP_MGR_DBUS_SIGNAL_APPEXIT))
+	{
+		gint process_id;
+		DBusMessageIter iter;
+		dbus_message_iter_init(msg, &iter);
+		dbus_message_iter_get_basic(&iter, &process_id);
+		clp_app_mgr_counters_exited(process_id);
+		clp_app_mgr_writeback_visibility_forget(process_id);
+	}
+	else if (dbus_message_is_signal (msg, CLP_APP_MGR_DBUS_INTERFACE, CLP_APP_MGR_DBUS_SIGNAL_CLEARPID))
+	{
+		clp_app_mgr_counters_invalidate();
+		clp_app_mgr_writeback_visibility_forget(0);
+	}
+	else if (dbus_message_is_signal (msg, CLP_APP_MGR_DBUS_INTERFACE, CLP_APP_MGR_DBUS_SIGNAL_APPLIST_CHANGE))
+		clp_app_mgr_counters_invalidate();
+	else if (dbus_message_is_signal (msg, CLP_APP_MGR_DBUS_INTERFACE, CLP_APP_MGR_DBUS_SIGNAL_VISIBILITY))
+	{
+		gint process_id;
+		dbus_bool_t visibility;
+		if (dbus_message_get_args (msg, NULL, DBUS_TYPE_INT32, &process_id, DBUS_TYPE_BOOLEAN, &visibility, DBUS_TYPE_INVALID))
+		{
+			clp_app_mgr_writeback_visibility_seen(process_id, visibility);
+			clp_app_mgr_shm_set_visibility(process_id, visibility);
+		}
+	}
+
+	/* ...and invalidate the snapshot of the running applications */
+	if (dbus_message_is_signal (msg, CLP_APP_MGR_DBUS_INTERFACE, CLP_APP_MGR_DBUS_SIGNAL_APPEXIT)
+		|| dbus_message_is_signal (msg, CLP_APP_MGR_DBUS_INTERFACE, CLP_APP_MGR_DBUS_SIGNAL_CLEARPID)
+		|| dbus_message_is_signal (msg, CLP_APP_MGR_DBUS_INTERFACE, CLP_APP_MGR_DBUS_SIGNAL_APPLIST_CHANGE))
+	{
+		clp_app_mgr_monitor_bump(CLP_APP_MGR_MONITOR_ACTIVE);
+		clp_app_mgr_shm_update();
+		app_list_change_schedule();
+	}
+	else if (dbus_message_is_signal (msg, CLP_APP_MGR_DBUS_INTERFACE, CLP_APP_MGR_DBUS_SIGNAL_VISIBILITY))
+	{
+		/* the table was patched in place, it is not republished */
+		clp_app_mgr_monitor_bump(CLP_APP_MGR_MONITOR_ACTIVE);
+		app_list_change_schedule();
+	}
+
 	/* Signal handler function*/
 	if (dbus_message_is_signal (msg, dbus_interface, CLP_APP_MGR_DBUS_SIGNAL_STOP))
 	{
@@ -1171,6 +1152,7 @@ message_func (DBusConnection *bus_conn, DBusMessage *msg, gpointer user_data)
 	        DBusMessageIter iter;
 	        dbus_message_iter_init(msg, &iter);
 	        dbus_message_iter_get_basic(&iter, &pid);
+		clp_app_mgr_shm_set_focus(pid, TRUE);
 		if (pid == getpid()) {
 
 			if(appclient_context.app_focus_gained_callback!=NULL)
@@ -1186,6 +1168,7 @@ message_func (DBusConnection *bus_conn, DBusMessage *msg, gpointer user_data)
 	        DBusMessageIter iter;
 	        dbus_message_iter_init(msg, &iter);
 	        dbus_message_iter_get_basic(&iter, &pid);
+		clp_app_mgr_shm_set_focus(pid, FALSE);
 		if (pid == getpid()) {
 
 			if(appclient_context.app_focus_lost_callback!=NULL)
@@ -1200,11 +1183,12 @@ message_func (DBusConnection *bus_conn, DBusMessage *msg, gpointer user_data)
 	}
 	else if (dbus_message_is_signal (msg, dbus_interface, CLP_APP_MGR_DBUS_SIGNAL_EXEC))
 	{
-		if(appclient_context.exec_callback!=NULL) {
+		if(appclient_context.exec_callback!=NULL || appclient_context.exec_fd_callback!=NULL) {
 			DBusMessageIter iter, array_iter;
 			guint no_of_param,i;
 			gchar *temp=NULL;
 			gchar **params_list=NULL;
+			gint fd = -1;
 
 			dbus_message_iter_init(msg, &iter);
 			dbus_message_iter_get_basic(&iter, &no_of_param);
@@ -1234,7 +1218,17 @@ message_func (DBusConnection *bus_conn, DBusMessage *msg, gpointer user_data)
 					dbus_message_iter_next(&array_iter);
 				}
 			}
-			(appclient_context.exec_callback)(no_of_param, params_list);
+#ifdef DBUS_TYPE_UNIX_FD
+			if(dbus_message_iter_next(&iter) && dbus_message_iter_get_arg_type(&iter) == DBUS_TYPE_UNIX_FD)
+				dbus_message_iter_get_basic(&iter, &fd);
+#endif
+			if(appclient_context.exec_fd_callback!=NULL)
+				(appclient_context.exec_fd_callback)(no_of_param, params_list, fd);
+			else {
+				(appclient_context.exec_callback)(no_of_param, params_list);
+				if(fd >= 0)
+					close(fd);
+			}
 		
 			for(i=0;i<no_of_param;i++)
 				g_free(params_list[i]);
@@ -1459,23 +1453,30 @@ clp_app_mgr_apply_theme(const gchar* theme_name)
 }
 
 
-/**\brief Get the list of currently running application
+/**\brief Get the requested fields of the currently running applications
  * 
- * \return GList of ClpAppMgrActiveApp 
+ * \param fields Mask of CLP_APP_MGR_FIELD_PID, CLP_APP_MGR_FIELD_NAME, CLP_APP_MGR_FIELD_TITLE, CLP_APP_MGR_FIELD_ICON,
+ * CLP_APP_MGR_FIELD_VISIBILITY and CLP_APP_MGR_FIELD_IMMORTAL
  *
- * The function will get the list of currently running active applications in the form of GList. 
- * The data part is ClpAppMgrActiveApp structure which contains the required information about the Application.
- *  
+ * \return ClpAppMgrArray of ClpAppMgrActiveAppV2, to be freed with clp_app_mgr_array_free()
+ *
+ * Only the requested fields are read from gconf, the others are left 0 or NULL. Asking for the pid alone does
+ * not touch gconf at all. Instances whose registry entry has no Name are skipped only when the title is requested,
+ * since telling them apart costs the very read the mask saves.
  */
-GList*
-clp_app_mgr_get_active_apps()
+ClpAppMgrArray*
+clp_app_mgr_get_active_apps_fields(guint fields)
 {
 	CLP_APPMGR_ENTER_FUNCTION();
 	gint *apps = NULL;
 	gint num_of_active_apps = 0, i;
 	gint return_code;
+	ClpAppMgrArrayBuilder builder;
+	GConfClient *client = NULL;
 
-	GList *active_apps = NULL;
+	if (fields & ~CLP_APP_MGR_FIELD_PID)
+		client = clp_app_mgr_registry_client();
+	clp_app_mgr_array_builder_init(&builder, sizeof(ClpAppMgrActiveAppV2));
 
 	return_code = AppMgrAppGetRunningApps (&apps, &num_of_active_apps);
 	if(!return_code)
@@ -1490,58 +1491,84 @@ clp_app_mgr_get_active_apps()
 			{
 				for(j = 0; j < no_of_active_inst; j++) {
 				return_code = AppMgrAppGetInstInfo (instid[j], &appid, &pid);
+				ClpAppMgrActiveAppV2 *new_app;
+				gchar *key_path_appmgr, *temp, *t;
+
+				if (client == NULL)
+				{
+					new_app = clp_app_mgr_array_builder_append(&builder);
+					new_app->pid = pid;
+					continue;
+				}
 				
 				gchar app_id[NAME_SIZE];
 				sprintf(app_id,"%d",appid);
-				GConfClient *client = gconf_client_get_default();
-				gconf_client_add_dir(client, GCONF_APPS_DIR, GCONF_CLIENT_PRELOAD_NONE, NULL);
-				gchar *key_path = g_strconcat(LIMO_APPS_DIR, "/", app_id , NULL);
-				CLP_APPMGR_INFO_V("Key Path - %s\n", key_path);
-				gchar *temp;
-				GError *err=NULL;
-	
-				temp = g_strconcat(key_path, "/AppExecName", NULL);
-				gchar *t = gconf_client_get_string (client, temp, &err);
-				gchar *key_path_appmgr = g_strconcat(GCONF_APPS_DIR, "/", t, "/info", NULL);
+				temp = g_strconcat(LIMO_APPS_DIR, "/", app_id, "/AppExecName", NULL);
+				CLP_APPMGR_INFO_V("Key Path - %s\n", temp);
+				t = gconf_client_get_string (client, temp, NULL);
+				key_path_appmgr = g_strconcat(GCONF_APPS_DIR, "/", t, "/info", NULL);
+				g_free(temp);
+				g_free(t);
 				
-				temp = g_strconcat (key_path_appmgr, "/Name", NULL);
-				t = gconf_client_get_string (client, temp, &err);
-				if( t==NULL )		continue;
-				ClpAppMgrActiveApp *new_app = (ClpAppMgrActiveApp*)g_malloc0(sizeof (ClpAppMgrActiveApp));
-				g_stpcpy (new_app->title, t);
+				t = NULL;
+				if (fields & CLP_APP_MGR_FIELD_TITLE)
+				{
+					temp = g_strconcat (key_path_appmgr, "/Name", NULL);
+					t = gconf_client_get_string (client, temp, NULL);
+					g_free(temp);
+					if( t==NULL )
+					{
+						g_free(key_path_appmgr);
+						continue;
+					}
+				}
+				new_app = clp_app_mgr_array_builder_append(&builder);
+				if (t)
+					new_app->title = g_intern_string (t);
 				g_free(t);
-				g_free(temp);
 			
-				err=NULL;
-				temp = g_strconcat (key_path_appmgr, "/Command", NULL);
-				gchar **temp_name = g_strsplit((gchar *)(gconf_client_get_string (client, temp, &err))," ",2);
-				t = gconf_client_get_string (client, temp, &err);
-				g_stpcpy (new_app->name, t);
-				g_free(t);
-				g_free(temp);
-				g_strfreev(temp_name);
+				if (fields & CLP_APP_MGR_FIELD_NAME)
+				{
+					temp = g_strconcat (key_path_appmgr, "/Command", NULL);
+					t = gconf_client_get_string (client, temp, NULL);
+					new_app->name = g_intern_string (t ? t : "");
+					g_free(t);
+					g_free(temp);
+				}
 			
-				err=NULL;
-				temp = g_strconcat (key_path_appmgr, "/Icon", NULL);
-				new_app->icon = gconf_client_get_string (client, temp, &err);
-				g_free(temp);
+				if (fields & CLP_APP_MGR_FIELD_PID)
+					new_app->pid = pid;
 				
-				new_app->pid = pid;
-				
-				err=NULL;
-				temp = g_strconcat (key_path_appmgr, "/Visibility", NULL);
-				new_app->visibility = gconf_client_get_bool (client, temp, &err);
-				g_free(temp);
+				if (fields & CLP_APP_MGR_FIELD_VISIBILITY)
+				{
+					gboolean visibility;
+					if (clp_app_mgr_writeback_get_visibility(pid, &visibility))
+						new_app->visibility = visibility;
+					else
+					{
+						temp = g_strconcat (key_path_appmgr, "/Visibility", NULL);
+						new_app->visibility = gconf_client_get_bool (client, temp, NULL);
+						g_free(temp);
+					}
+				}
 				
-				err=NULL;
-				temp = g_strconcat (key_path_appmgr, "/Immortal", NULL);
-				new_app->immortal = gconf_client_get_bool (client, temp, &err);
-				g_free(temp);
+				if (fields & CLP_APP_MGR_FIELD_IMMORTAL)
+				{
+					temp = g_strconcat (key_path_appmgr, "/Immortal", NULL);
+					new_app->immortal = gconf_client_get_bool (client, temp, NULL);
+					g_free(temp);
+				}
+
+				if (fields & CLP_APP_MGR_FIELD_ICON)
+				{
+					temp = g_strconcat (key_path_appmgr, "/Icon", NULL);
+					t = gconf_client_get_string (client, temp, NULL);
+					new_app->icon = t ? g_intern_string (t) : NULL;
+					g_free(t);
+					g_free(temp);
+				}
 
-				g_free(key_path);
 				g_free(key_path_appmgr);
-				
-				active_apps = g_list_append(active_apps, new_app);
 				}
 			} 
 			else 
@@ -1554,6 +1581,73 @@ clp_app_mgr_get_active_apps()
 		CLP_APPMGR_WARN_V("Unable to get Running Apps !! Error Code %d", return_code);
 	}
 		
+	CLP_APPMGR_EXIT_FUNCTION();
+	return clp_app_mgr_array_builder_finish(&builder);
+}
+
+
+/**\brief Get the list of currently running application
+ * 
+ * \return ClpAppMgrArray of ClpAppMgrActiveAppV2, to be freed with clp_app_mgr_array_free()
+ *
+ * Same information as clp_app_mgr_get_active_apps(), returned as one contiguous block of compact records.
+ * The strings of the records are interned with g_intern_string(): they are shared by all the records and
+ * all the calls, can be compared by pointer and must not be freed.
+ */
+ClpAppMgrArray*
+clp_app_mgr_get_active_apps_v2(void)
+{
+	return clp_app_mgr_get_active_apps_fields(CLP_APP_MGR_FIELD_ALL);
+}
+
+
+/** \brief Copy a compact active application record into a ClpAppMgrActiveApp
+ *
+ * \param record The compact record
+ *
+ * \return New ClpAppMgrActiveApp, to be freed by the caller
+ */
+static ClpAppMgrActiveApp*
+active_app_from_v2(const ClpAppMgrActiveAppV2 *record)
+{
+	ClpAppMgrActiveApp *new_app = (ClpAppMgrActiveApp*)g_malloc0(sizeof (ClpAppMgrActiveApp));
+
+	new_app->pid = record->pid;
+	if (record->name)
+		g_strlcpy (new_app->name, record->name, NAME_SIZE);
+	if (record->title)
+		g_strlcpy (new_app->title, record->title, NAME_SIZE);
+	new_app->icon = g_strdup(record->icon);
+	new_app->visibility = record->visibility;
+	new_app->immortal = record->immortal;
+	return new_app;
+}
+
+
+/**\brief Get the list of currently running application
+ * 
+ * \return GList of ClpAppMgrActiveApp 
+ *
+ * The function will get the list of currently running active applications in the form of GList. 
+ * The data part is ClpAppMgrActiveApp structure which contains the required information about the Application.
+ * The list is a copy of the shared snapshot, clp_app_mgr_active_snapshot_get() gives the same records without copying.
+ */
+GList*
+clp_app_mgr_get_active_apps()
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	ClpAppMgrActiveSnapshot *snapshot = clp_app_mgr_active_snapshot_get();
+	const ClpAppMgrActiveAppV2 *records;
+	GList *active_apps = NULL;
+	guint i, n_records;
+
+	records = clp_app_mgr_active_snapshot_get_apps(snapshot, &n_records);
+	for (i = n_records; i > 0; i--)
+	{
+		active_apps = g_list_prepend(active_apps, active_app_from_v2(&records[i - 1]));
+	}
+	clp_app_mgr_active_snapshot_unref(snapshot);
+
 	CLP_APPMGR_EXIT_FUNCTION();
 	return active_apps;
 }
@@ -1573,6 +1667,15 @@ clp_app_mgr_get_num_of_active_apps()
 	gint num_of_active_apps, return_code;
 	gint *apps = NULL;
 	
+	num_of_active_apps = clp_app_mgr_shm_count_apps();
+	if (num_of_active_apps < 0)
+		num_of_active_apps = clp_app_mgr_counters_get_apps();
+	if (num_of_active_apps >= 0) {
+		CLP_APPMGR_INFO_V("Currently Active Applications: %d",num_of_active_apps);
+		CLP_APPMGR_EXIT_FUNCTION();
+		return num_of_active_apps;
+	}
+
 	return_code = AppMgrAppGetRunningApps(&apps, &num_of_active_apps);
 	if(return_code) {
 		CLP_APPMGR_WARN_V("Unable to get Running Apps !! Error Code %d", return_code);
@@ -1601,6 +1704,19 @@ gint clp_app_mgr_get_num_of_active_instances_of_app(gchar *appname)
 	gint *inst_ids = NULL;
 	gint num_of_instances = 0;
 	gint appid = clp_app_mgr_get_app_id(appname);
+	num_of_instances = clp_app_mgr_shm_count_instances(appid);
+	if (num_of_instances >= 0) {
+		CLP_APPMGR_INFO_V("Currently Active Instance : %d",num_of_instances);
+		CLP_APPMGR_EXIT_FUNCTION();
+		return num_of_instances;
+	}
+	num_of_instances = clp_app_mgr_counters_get_instances(appid);
+	if (num_of_instances >= 0) {
+		CLP_APPMGR_INFO_V("Currently Active Instance : %d",num_of_instances);
+		CLP_APPMGR_EXIT_FUNCTION();
+		return num_of_instances;
+	}
+	num_of_instances = 0;
 	return_code = AppMgrAppGetRunningInstances(appid, &inst_ids, &num_of_instances);
 	if(return_code) {
 		CLP_APPMGR_WARN_V("Unable to get Running Instances of App %d !! Error Code %d", appid, return_code);
@@ -1629,6 +1745,13 @@ gint clp_app_mgr_is_app_active(gchar *appname)
 	gint return_code;
 	gboolean is_app_active = FALSE;
 	gint appid = clp_app_mgr_get_app_id(appname);
+	gint num_of_instances = clp_app_mgr_shm_count_instances(appid);
+	if (num_of_instances < 0)
+		num_of_instances = clp_app_mgr_counters_get_instances(appid);
+	if (num_of_instances >= 0) {
+		CLP_APPMGR_EXIT_FUNCTION();
+		return num_of_instances > 0;
+	}
 	return_code = AppMgrAppIsRunning (appid);
 	if(return_code) {
 		CLP_APPMGR_WARN_V("Unable to get Running Status of App %d !! Error Code %d", appid, return_code);
@@ -1696,7 +1819,8 @@ GList* clp_app_mgr_get_active_instances_of_app(gchar *appname)
 	
 	gint appid, *inst_ids = NULL, num_of_instances = 0, i;
 	GList *instances_list = NULL;
-	ClpAppMgrActiveApp *data;
+	ClpAppMgrArray *array;
+	gchar **instances;
 
 	appid = clp_app_mgr_get_app_id(appname);
 
@@ -1704,21 +1828,158 @@ GList* clp_app_mgr_get_active_instances_of_app(gchar *appname)
 
 	if(return_code) {
 		CLP_APPMGR_WARN_V("Failed to get running instances of App %s! Error Code - %d",appname, return_code);
+		num_of_instances = 0;
 	}
 
+	instances = g_new0(gchar *, num_of_instances + 1);
 	for (i = 0; i < num_of_instances; i++) {
-		gchar instance[NAME_SIZE];
-		sprintf (instance, "%s:%d", appname, inst_ids[i]);
-		CLP_APPMGR_INFO_V("Instance Name: %s",(gchar *)instance);
-		data = clp_app_mgr_get_application_instance_info(instance);
-		instances_list = g_list_append(instances_list, data);
+		instances[i] = g_strdup_printf ("%s:%d", appname, inst_ids[i]);
+		CLP_APPMGR_INFO_V("Instance Name: %s", instances[i]);
+	}
+	array = clp_app_mgr_get_application_instances_info_v2((const gchar * const *) instances);
+	g_strfreev(instances);
+
+	for (i = array->n_records; i > 0; i--) {
+		const ClpAppMgrActiveAppV2 *record = &CLP_APP_MGR_ARRAY_INDEX(array, ClpAppMgrActiveAppV2, i - 1);
+		instances_list = g_list_prepend(instances_list, record->name ? active_app_from_v2(record) : NULL);
 	}
+	clp_app_mgr_array_free(array);
 	
 	CLP_APPMGR_EXIT_FUNCTION();
 	return instances_list;
 }
 
 
+/** \brief Resolve an instance name to the pid of the instance
+ *
+ * \param instance_name "app:instance", or "app" for the first instance of the application
+ * \param pid Returns the pid of the instance
+ *
+ * \return TRUE if the instance is running
+ */
+static gboolean
+instance_info_resolve(const gchar *instance_name, gint *pid)
+{
+	const gchar *colon = strchr(instance_name, ':');
+	gint *inst_ids = NULL, instid, appid, num_of_instances = 0;
+
+	if (colon == NULL || colon[1] == '\0')
+	{
+		gchar *app = g_strndup(instance_name, colon ? colon - instance_name : strlen(instance_name));
+		appid = clp_app_mgr_get_app_id(app);
+		g_free(app);
+		if (AppMgrAppGetRunningInstances (appid, &inst_ids, &num_of_instances) || num_of_instances == 0)
+			return FALSE;
+		instid = inst_ids[0];
+	}
+	else
+		instid = atoi(colon + 1);
+
+	return AppMgrAppGetInstInfo (instid, &appid, pid) == 0;
+}
+
+
+/** \brief Read the registry information of an application
+ *
+ * \param client GConf client
+ * \param info_dir Registry directory of the application information, for eg /appmgr/calculator/info
+ * \param record Returns the information, except the pid
+ *
+ * All the keys are fetched with a single gconf_client_all_entries() call.
+ */
+static void
+instance_info_read(GConfClient *client, const gchar *info_dir, ClpAppMgrActiveAppV2 *record)
+{
+	GSList *entries = gconf_client_all_entries(client, info_dir, NULL);
+	GSList *iter;
+
+	record->name = g_intern_string("");
+	for (iter = entries; iter; iter = iter->next)
+	{
+		GConfEntry *entry = iter->data;
+		GConfValue *value = gconf_entry_get_value(entry);
+		const gchar *key = strrchr(gconf_entry_get_key(entry), '/');
+
+		key = key ? key + 1 : gconf_entry_get_key(entry);
+		if (value == NULL)
+			;
+		else if (value->type == GCONF_VALUE_STRING)
+		{
+			if (!strcmp(key, "Name"))
+				record->title = g_intern_string(gconf_value_get_string(value));
+			else if (!strcmp(key, "Command"))
+				record->name = g_intern_string(gconf_value_get_string(value));
+			else if (!strcmp(key, "Icon"))
+				record->icon = g_intern_string(gconf_value_get_string(value));
+		}
+		else if (value->type == GCONF_VALUE_BOOL)
+		{
+			if (!strcmp(key, "Visibility"))
+				record->visibility = gconf_value_get_bool(value);
+			else if (!strcmp(key, "Immortal"))
+				record->immortal = gconf_value_get_bool(value);
+		}
+		gconf_entry_free(entry);
+	}
+	g_slist_free(entries);
+}
+
+
+/**\brief Given application instance names, return their information.
+ *
+ * \param instance_names NULL terminated array of instance names, "app:instance" or "app" for the first instance of the application
+ *
+ * \return ClpAppMgrArray of ClpAppMgrActiveAppV2, one record per name in the same order, to be freed with clp_app_mgr_array_free().
+ * The record of a name that is not a running instance has a NULL name.
+ *
+ * The registry information of every application is read once, however many of its instances are asked for.
+ * The strings of the records are interned with g_intern_string().
+ */
+ClpAppMgrArray*
+clp_app_mgr_get_application_instances_info_v2(const gchar * const *instance_names)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	GHashTable *infos = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+	GConfClient *client = clp_app_mgr_registry_client();
+	ClpAppMgrArrayBuilder builder;
+	guint i;
+
+	clp_app_mgr_array_builder_init(&builder, sizeof(ClpAppMgrActiveAppV2));
+	for (i = 0; instance_names && instance_names[i]; i++)
+	{
+		ClpAppMgrActiveAppV2 *record = clp_app_mgr_array_builder_append(&builder);
+		const ClpAppMgrAppNames *names;
+		ClpAppMgrActiveAppV2 *info;
+		gint pid;
+
+		if (!instance_info_resolve(instance_names[i], &pid))
+		{
+			CLP_APPMGR_WARN_V("%s is not a running instance", instance_names[i]);
+			continue;
+		}
+
+		/* info_dir is interned, it identifies the application */
+		names = clp_app_mgr_app_names_get(instance_names[i]);
+		info = g_hash_table_lookup(infos, names->info_dir);
+		if (info == NULL)
+		{
+			info = g_new0(ClpAppMgrActiveAppV2, 1);
+			instance_info_read(client, names->info_dir, info);
+			g_hash_table_insert(infos, (gpointer) names->info_dir, info);
+		}
+		*record = *info;
+		record->pid = pid;
+		gboolean visibility;
+		if (clp_app_mgr_writeback_get_visibility(pid, &visibility))
+			record->visibility = visibility;
+	}
+	g_hash_table_destroy(infos);
+
+	CLP_APPMGR_EXIT_FUNCTION();
+	return clp_app_mgr_array_builder_finish(&builder);
+}
+
+
 /**\brief Given the application instance name, return its information.
  *
  * \param instance_name the instance name of the application whose information is to be queried.
@@ -1727,6 +1988,7 @@ GList* clp_app_mgr_get_active_instances_of_app(gchar *appname)
  *  any error or if that instance is not active when information is queried.  
  *
  * The function will return instance information of the name passed if that instance is active. It will return NULL otherwise. 
+ * clp_app_mgr_get_application_instances_info_v2() resolves many names at once.
  */
 ClpAppMgrActiveApp *clp_app_mgr_get_application_instance_info(gchar *instance_name)
 {
@@ -1734,69 +1996,19 @@ ClpAppMgrActiveApp *clp_app_mgr_get_application_instance_info(gchar *instance_na
 	CLP_APPMGR_PARAM_ERROR((instance_name && (strcmp(instance_name, ""))),"Parameter 'instance_name' is NULL");
 	CLP_APPMGR_PARAM_ERROR((strlen(instance_name) <= NAME_SIZE),"Parameter 'instance_name' exceeds the maximum allowed name size");
 
-	gint *inst_ids=NULL, instid, appid, return_code, pid, num_of_instances;
-	gchar **split = g_strsplit(instance_name,":",2);
-	if( split[1]==NULL || g_strcasecmp(split[1],"")==0 )
-	{
-		appid = clp_app_mgr_get_app_id(split[0]);
-		return_code = AppMgrAppGetRunningInstances (appid, &inst_ids, &num_of_instances);
-		instid = inst_ids[0];
-	}
-	else
-	{
-		instid = atoi(*(split+1));
-	}
-	return_code = AppMgrAppGetInstInfo (instid, &appid, &pid);
-
-	if(!return_code)
-	{
-		ClpAppMgrActiveApp *new_app = (ClpAppMgrActiveApp*)g_malloc0(sizeof (ClpAppMgrActiveApp));
-		gchar app_id[NAME_SIZE];
-		sprintf(app_id,"%d",appid);
-		GConfClient *client = gconf_client_get_default();
-		gconf_client_add_dir(client, GCONF_APPS_DIR, GCONF_CLIENT_PRELOAD_NONE, NULL);
-		gchar *key_path = g_strconcat(GCONF_APPS_DIR, "/", split[0], "/info", NULL);
-		CLP_APPMGR_INFO_V("Key Path - %s\n", key_path);
-		gchar *temp;
-		GError *err=NULL;
-		temp = g_strconcat (key_path, "/Name", NULL);
-		gchar *t = gconf_client_get_string (client, temp, &err);
-		g_stpcpy (new_app->title, t);
-		g_free(t);
-		g_free(temp);
-	
-		err=NULL;
-		temp = g_strconcat (key_path, "/Command", NULL);
-		gchar **temp_name = g_strsplit((gchar *)(gconf_client_get_string (client, temp, &err))," ",2);
-		t = gconf_client_get_string (client, temp, &err);
-		g_stpcpy (new_app->name, t);
-		g_free(t);
-		g_free(temp);
-		g_strfreev(temp_name);
-			
-		err=NULL;
-		temp = g_strconcat (key_path, "/Icon", NULL);
-		new_app->icon = gconf_client_get_string (client, temp, &err);
-		g_free(temp);
-				
-		new_app->pid = pid;
-		
-		err=NULL;
-		temp = g_strconcat (key_path, "/Visibility", NULL);
-		new_app->visibility = gconf_client_get_bool (client, temp, &err);
-		g_free(temp);
-		
-		g_free(key_path);
+	const gchar *instance_names[] = { instance_name, NULL };
+	ClpAppMgrArray *array = clp_app_mgr_get_application_instances_info_v2(instance_names);
+	const ClpAppMgrActiveAppV2 *record = &CLP_APP_MGR_ARRAY_INDEX(array, ClpAppMgrActiveAppV2, 0);
+	ClpAppMgrActiveApp *new_app = NULL;
 
-		CLP_APPMGR_EXIT_FUNCTION();
-		return new_app;
-	}
-	else 
-	{
+	if (record->name)
+		new_app = active_app_from_v2(record);
+	else
 		CLP_APPMGR_WARN(" Invalid parameter 'instance_name' detected ");
-		CLP_APPMGR_EXIT_FUNCTION();
-		return NULL;
-	}
+	clp_app_mgr_array_free(array);
+
+	CLP_APPMGR_EXIT_FUNCTION();
+	return new_app;
 }
 
 
@@ -1806,6 +2018,7 @@ ClpAppMgrActiveApp *clp_app_mgr_get_application_instance_info(gchar *instance_na
  * \param filename The File Name whose Mime Type is to be queried
  *
  * The function returns the mime type of the file name. If filename is NULL, it returns NULL. For filename as empty string it returns 'application/octet-stream'. It uses API provided by xdgmime.
+ * The result is cached until the file or the shared MIME database change, see clp-app-mgr-mime-cache.h.
  */
 gchar*
 clp_app_mgr_mime_from_file(const gchar *filename)
@@ -1817,7 +2030,7 @@ clp_app_mgr_mime_from_file(const gchar *filename)
 		CLP_APPMGR_EXIT_FUNCTION();
 		return NULL;
 	}
-	gchar *out_mime_type = (gchar*) xdg_mime_get_mime_type_for_file (filename,NULL);
+	gchar *out_mime_type = (gchar*) clp_app_mgr_mime_cache_file (filename);
 	CLP_APPMGR_EXIT_FUNCTION();
 	return out_mime_type;
 	
@@ -1828,7 +2041,9 @@ clp_app_mgr_mime_from_file(const gchar *filename)
  *
  * \param data The data whose Mime Type is to be queried
  *
- * The function returns the mime type of the data string. If 'data' is NULL, it returns NULL. For 'data' as empty string it returns 'application/octet-stream'. It uses API provided by xdgmime.
+ * The function returns the mime type of the data string. If 'data' is NULL, it returns NULL. For 'data' as empty string it returns 'application/octet-stream'.
+ * The string patterns declared by the handlers are tried first (see clp-app-mgr-classify.h), then the API provided by xdgmime.
+ * Short strings are answered from a cache, see clp-app-mgr-mime-cache.h.
  */
 gchar*
 clp_app_mgr_mime_from_string(const gchar *data)
@@ -1840,110 +2055,183 @@ clp_app_mgr_mime_from_string(const gchar *data)
 		CLP_APPMGR_EXIT_FUNCTION();
 		return NULL;
 	}
-	gchar *out_mime_type = (gchar*) xdg_mime_get_mime_type_from_file_name (data);
+	gchar *out_mime_type = (gchar*) clp_app_mgr_mime_cache_string (data);
 	CLP_APPMGR_EXIT_FUNCTION();
 	return out_mime_type;
 }
 
 
-/**\brief Discover the available services for a given Mime Type
+/**\brief Internal function adding services to a services result
  *
- * \param mimetype The Mime Type for whom available services are to be queried
+ * \param builder Result being built
+ * \param services Services of one application, from the service index
+ * \param n_services Number of services
  *
- * The function returns the list of all the services associated with the Mime Type.
+ * \warning This function is internal to the Library
  */
-GSList*
-clp_app_mgr_get_services(const gchar *mimetype)
+static void
+clp_app_mgr_services_append(ClpAppMgrArrayBuilder *builder, const ClpAppMgrServices *services, guint n_services)
 {
-	CLP_APPMGR_ENTER_FUNCTION();
+	guint k;
 
-	if(mimetype==NULL || strcmp(mimetype,"")==0)
+	for (k = 0; k < n_services; k++)
 	{
-		CLP_APPMGR_WARN("Mimetype is either NULL or empty string. Hence list returned will be NULL.");
-		CLP_APPMGR_EXIT_FUNCTION();
-		return NULL;
+		clp_app_mgr_array_builder_append(builder);
+		clp_app_mgr_array_builder_set_string(builder, G_STRUCT_OFFSET(ClpAppMgrServices, app_name), services[k].app_name);
+		clp_app_mgr_array_builder_set_string(builder, G_STRUCT_OFFSET(ClpAppMgrServices, app_exec_name), services[k].app_exec_name);
+		clp_app_mgr_array_builder_set_string(builder, G_STRUCT_OFFSET(ClpAppMgrServices, service_name), services[k].service_name);
+		clp_app_mgr_array_builder_set_string(builder, G_STRUCT_OFFSET(ClpAppMgrServices, service_menu), services[k].service_menu);
 	}
+}
 
-	gchar *contents, **arr_str, **arr_mime, **arr_desktop, **arr_srvc, *key;
-	gchar *app_name=NULL, *app_exec_name=NULL;
-	gsize length;
-	GError *error;
-	GSList *list=NULL;
- 	gint i=1, j, k;
-	ClpAppMgrServices *service_info;
-	
-	g_file_get_contents(APPLICATION_INFO_PATH"mimeinfo.cache",&contents,&length,&error);
-	
-	arr_str = g_strsplit(contents,"\n",MAX_NO_OF_LINES);
-	
-	for( i=1; *(arr_str+i)!=NULL; i++ )
+
+/**\brief Discover the available services for a given Mime Type
+ *
+ * \param mimetype The Mime Type for whom available services are to be queried
+ *
+ * \return ClpAppMgrArray of ClpAppMgrServices, to be freed with clp_app_mgr_array_free(). NULL if mimetype is NULL or empty.
+ *
+ * Same information as clp_app_mgr_get_services(), returned as one contiguous block. The services of the default
+ * handler come first. Answered from the service index, see clp-app-mgr-service-index.h.
+ */
+ClpAppMgrArray*
+clp_app_mgr_get_services_v2(const gchar *mimetype)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+
+	if(mimetype==NULL || strcmp(mimetype,"")==0)
 	{
-		arr_mime = g_strsplit(*(arr_str+i),"=",2);
-		
-		if( *arr_mime==NULL )	break;   //Because it was printing for the (null) value also n giving seg fault
-		
-		if( g_strcasecmp(mimetype,*arr_mime)==0 )
-		{
-			arr_desktop = g_strsplit(*(arr_mime+1),";",MAX_NO_OF_APPS_PER_MIME_TYPE);
-			for( j=0; (*(arr_desktop+j)!=NULL); j++ )
-			{
-				key = g_strconcat(APPLICATION_INFO_PATH,*(arr_desktop+j),NULL);
-				if( g_strcasecmp(key,APPLICATION_INFO_PATH)==0 )	break;
-				g_file_get_contents(key,&contents,&length,&error);
-				g_free(key);
-
-				arr_str = g_strsplit(contents,"\n",MAX_NO_OF_LINES);
-
-			        for( i=1; *(arr_str+i)!=NULL; i++ )
-			        {
-			                arr_mime = g_strsplit(*(arr_str+i),"=",2);
-					if( *arr_mime==NULL )   break;   //Because it was printing for the (null) value also n giving seg fault
-					
-					if( g_strcasecmp("Name",*arr_mime)==0 )
-					{
-						app_name = *(arr_mime+1);
-						continue;
-					}
+		CLP_APPMGR_WARN("Mimetype is either NULL or empty string. Hence list returned will be NULL.");
+		CLP_APPMGR_EXIT_FUNCTION();
+		return NULL;
+	}
 
-					if( g_strcasecmp("Exec",*arr_mime)==0 )
-					{
-						app_exec_name = *(arr_mime+1);
-						continue;
-					}	
-				}
+	ClpAppMgrArrayBuilder builder;
+	ClpAppMgrServiceIndex *index = clp_app_mgr_service_index_get();
+	const gchar * const *apps;
+	const ClpAppMgrServices *services;
+	guint n_apps, j;
 
-			        for( i=1; *(arr_str+i)!=NULL; i++ )
-			        {
-			                arr_mime = g_strsplit(*(arr_str+i),"=",2);
-					if( *arr_mime==NULL )   break;   //Because it was printing for the (null) value also n giving seg fault
-
-				        if( g_strcasecmp("Services",*arr_mime)==0 || g_strcasecmp("X-Services",*arr_mime)==0 )
-			                {
-						arr_srvc = g_strsplit(*(arr_mime+1),";",MAX_NO_OF_APPS_PER_MIME_TYPE);
-						for( k=0; *(arr_srvc+k)!=NULL; k++ )
-						{
-							if( g_strcasecmp(*(arr_srvc+k),"")==0 )		break;
-							
-							service_info = (ClpAppMgrServices*)g_malloc0(sizeof (ClpAppMgrServices));
-
-							service_info->app_name = g_strdup(app_name);
-							service_info->app_exec_name = g_strdup(app_exec_name);
-							
-							gchar **serv_menu;
-						        serv_menu = g_strsplit(*(arr_srvc+k),",",2);
-							service_info->service_name = g_strdup(*serv_menu); 
-							if( *(serv_menu+1)==NULL ) 	service_info->service_menu = g_strdup(*serv_menu);
-							else 		service_info->service_menu = g_strdup(*(serv_menu+1));
-							
-							list = g_slist_append(list,service_info);
-						}
-						break;
-					}
-				}
-			}
-			break;
-		}
-	}	
+	clp_app_mgr_array_builder_init(&builder, sizeof(ClpAppMgrServices));
+	n_apps = clp_app_mgr_service_index_get_handlers(index, mimetype, &apps);
+	for (j = 0; j < n_apps; j++)
+	{
+		guint n_services = clp_app_mgr_service_index_get_services(index, apps[j], &services);
+		clp_app_mgr_services_append(&builder, services, n_services);
+	}
+	clp_app_mgr_service_index_unref(index);
+
+	CLP_APPMGR_EXIT_FUNCTION();
+	return clp_app_mgr_array_builder_finish(&builder);
+}
+
+
+/**\brief Discover the services an application offers
+ *
+ * \param application Name of the application
+ *
+ * \return ClpAppMgrArray of ClpAppMgrServices, to be freed with clp_app_mgr_array_free(). NULL if application is NULL or empty.
+ *
+ * The services are the ones of the Services key of the desktop file of the application, in order.
+ */
+ClpAppMgrArray*
+clp_app_mgr_get_app_services(const gchar *application)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+
+	if(application==NULL || strcmp(application,"")==0)
+	{
+		CLP_APPMGR_WARN("Parameter 'application' is either NULL or empty string. Hence list returned will be NULL.");
+		CLP_APPMGR_EXIT_FUNCTION();
+		return NULL;
+	}
+
+	ClpAppMgrArrayBuilder builder;
+	ClpAppMgrServiceIndex *index = clp_app_mgr_service_index_get();
+	const ClpAppMgrServices *services;
+	guint n_services;
+
+	clp_app_mgr_array_builder_init(&builder, sizeof(ClpAppMgrServices));
+	n_services = clp_app_mgr_service_index_get_services(index, application, &services);
+	clp_app_mgr_services_append(&builder, services, n_services);
+	clp_app_mgr_service_index_unref(index);
+
+	CLP_APPMGR_EXIT_FUNCTION();
+	return clp_app_mgr_array_builder_finish(&builder);
+}
+
+
+/**\brief Discover the Mime Types an application handles
+ *
+ * \param application Name of the application
+ *
+ * \return ClpAppMgrArray of gchar* holding the lower case Mime Types, to be freed with clp_app_mgr_array_free().
+ * NULL if application is NULL or empty.
+ *
+ * The Mime Types are the ones mimeinfo.cache lists the application for.
+ */
+ClpAppMgrArray*
+clp_app_mgr_get_app_mime_types(const gchar *application)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+
+	if(application==NULL || strcmp(application,"")==0)
+	{
+		CLP_APPMGR_WARN("Parameter 'application' is either NULL or empty string. Hence list returned will be NULL.");
+		CLP_APPMGR_EXIT_FUNCTION();
+		return NULL;
+	}
+
+	ClpAppMgrArrayBuilder builder;
+	ClpAppMgrServiceIndex *index = clp_app_mgr_service_index_get();
+	const gchar * const *mime_types;
+	guint n_mime_types, k;
+
+	clp_app_mgr_array_builder_init(&builder, sizeof(gchar*));
+	n_mime_types = clp_app_mgr_service_index_get_mime_types(index, application, &mime_types);
+	for (k = 0; k < n_mime_types; k++)
+	{
+		clp_app_mgr_array_builder_append(&builder);
+		clp_app_mgr_array_builder_set_string(&builder, 0, mime_types[k]);
+	}
+	clp_app_mgr_service_index_unref(index);
+
+	CLP_APPMGR_EXIT_FUNCTION();
+	return clp_app_mgr_array_builder_finish(&builder);
+}
+
+
+/**\brief Discover the available services for a given Mime Type
+ *
+ * \param mimetype The Mime Type for whom available services are to be queried
+ *
+ * The function returns the list of all the services associated with the Mime Type.
+ */
+GSList*
+clp_app_mgr_get_services(const gchar *mimetype)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	ClpAppMgrArray *array = clp_app_mgr_get_services_v2(mimetype);
+	GSList *list=NULL;
+	guint i;
+
+	if (array == NULL)
+	{
+		CLP_APPMGR_EXIT_FUNCTION();
+		return NULL;
+	}
+	for (i = array->n_records; i > 0; i--)
+	{
+		const ClpAppMgrServices *record = &CLP_APP_MGR_ARRAY_INDEX(array, ClpAppMgrServices, i - 1);
+		ClpAppMgrServices *service_info = (ClpAppMgrServices*)g_malloc0(sizeof (ClpAppMgrServices));
+
+		service_info->app_name = g_strdup(record->app_name);
+		service_info->app_exec_name = g_strdup(record->app_exec_name);
+		service_info->service_name = g_strdup(record->service_name);
+		service_info->service_menu = g_strdup(record->service_menu);
+		list = g_slist_prepend(list,service_info);
+	}
+	clp_app_mgr_array_free(array);
 
 	CLP_APPMGR_EXIT_FUNCTION();
 	return list;
@@ -1979,6 +2267,359 @@ gint clp_app_mgr_service_invoke(const gchar *application, ...)
 }
 
 
+/** \brief Service Invocation function taking the parameters in argc argv format
+ *
+ * \param service Name of the service, as listed in the Services key of the desktop files
+ * \param no_of_params no of parameters for the service
+ * \param params_list parameters for the service
+ * \param fd File descriptor handed to the application, -1 for none. The caller keeps its own descriptor.
+ * 
+ * \return CLP_APP_MGR_SUCCESS - Application service invocation got successful
+ * \return CLP_APP_MGR_FAILURE - No application offers the service or the invocation failed.
+ * \return CLP_APP_MGR_OUT_OF_MEMORY - Out Of memory
+ * \return CLP_APP_MGR_DBUS_CALL_FAIL - DBus Calls failed.
+ *
+ * The application offering the service is looked up in the service index, then launched, or sent the exec signal
+ * if it is running, with the service name followed by the parameters, as clp_app_mgr_service_invoke() does.
+ * The file descriptor travels with the exec signal and reaches the handler registered with
+ * clp_app_mgr_register_exec_fd_handler(). The launch request of the application manager carries strings only: an
+ * application that has to be launched gets the parameters but not the descriptor, so the parameters should be
+ * enough to find the content, the descriptor saving the handler from opening it again.
+ */
+gint clp_app_mgr_service_invoke_argv(const gchar *service, gint no_of_params, gchar **params_list, gint fd)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	CLP_APPMGR_PARAM_ERROR((service && (strcmp(service, ""))),"Parameter 'service' is NULL or empty string.");
+	CLP_APPMGR_PARAM_ERROR((no_of_params == 0 || params_list),"Parameter 'params_list' is NULL");
+	ClpAppMgrServiceIndex *index = clp_app_mgr_service_index_get();
+	const gchar *provider = clp_app_mgr_service_index_get_provider(index, service);
+	gchar *application;
+	gchar **params;
+	gint rv;
+
+	if (provider == NULL)
+	{
+		CLP_APPMGR_WARN_V("No application offers the service %s", service);
+		clp_app_mgr_service_index_unref(index);
+		CLP_APPMGR_EXIT_FUNCTION();
+		return CLP_APP_MGR_FAILURE;
+	}
+	application = g_strdup(provider);
+	clp_app_mgr_service_index_unref(index);
+
+	params = g_new(gchar *, no_of_params + 1);
+	params[0] = (gchar *) service;
+	if (no_of_params > 0)
+		memcpy(params + 1, params_list, no_of_params * sizeof(gchar *));
+
+	CLP_APPMGR_INFO_V("Invoking service %s of %s with %d params", service, application, no_of_params);
+	rv = clp_app_mgr_launch_or_forward(application, no_of_params + 1, params, FALSE, fd);
+	g_free(params);
+	g_free(application);
+	CLP_APPMGR_EXIT_FUNCTION();
+	return rv;
+}
+
+
+typedef struct _ClpAppMgrDispatchTarget				/**< Resolved default handler of a MIME type, never modified */
+{
+	volatile gint	ref_count;				/**< references held by the cache and the dispatchers */
+	gchar		*appname;				/**< name of the default handler application */
+	gboolean	dbus_call;				/**< TRUE if the handler is a middleware module reached over dbus (ExecType=dbus) */
+	gchar		*service;				/**< default service of the handler, NULL if it declares none */
+	DBusGProxy	*proxy;					/**< proxy of the middleware module, for a dbus handler with a service */
+}ClpAppMgrDispatchTarget;
+
+static struct
+{
+	GHashTable	*targets;				/**< lower case MIME type to ClpAppMgrDispatchTarget, NULL if it has no handler */
+	guint		desktop_generation;			/**< desktop generation the targets were resolved at */
+	guint		mime_generation;			/**< mime generation the targets were resolved at */
+	guint		dbus_generation;			/**< generation of the middleware module keys the targets were resolved at */
+}dispatch_targets = { NULL, 0, 0, 0 };
+G_LOCK_DEFINE_STATIC (dispatch_targets);
+
+
+/** \brief Internal function releasing a reference on a dispatch target
+ *
+ * \warning This function is internal to the Library
+ */
+static void
+clp_app_mgr_dispatch_target_unref(ClpAppMgrDispatchTarget *target)
+{
+	if (target == NULL || !g_atomic_int_dec_and_test(&target->ref_count))
+		return;
+	if (target->proxy)
+		g_object_unref(target->proxy);
+	g_free(target->appname);
+	g_free(target->service);
+	g_free(target);
+}
+
+
+/** \brief Internal function building a dispatch target
+ *
+ * \param appname Name of the default handler application
+ * \param exec_type Value of its ExecType key, NULL if none
+ * \param services Value of its Services key, "service,menu;service,menu;...", NULL if none
+ *
+ * For a middleware module the proxy is created here, from the DBusService, DBusObjPath and DBusInterface keys
+ * of the application registry.
+ *
+ * \warning This function is internal to the Library
+ */
+static ClpAppMgrDispatchTarget*
+clp_app_mgr_dispatch_target_new(const gchar *appname, const gchar *exec_type, const gchar *services)
+{
+	ClpAppMgrDispatchTarget *target = g_new0(ClpAppMgrDispatchTarget, 1);
+
+	target->ref_count = 1;
+	target->appname = g_strdup(appname);
+	target->dbus_call = exec_type && !g_ascii_strcasecmp(exec_type, "dbus");
+	if (services && *services && *services != ';')
+	{
+		/* first entry of "service,menu;service,menu;..." */
+		target->service = g_strndup(services, strcspn(services, ",;"));
+		CLP_APPMGR_INFO_V(" Default Service = %s\n", target->service);
+	}
+	CLP_APPMGR_INFO_V(" Default Application = %s\n", appname);
+
+	if (target->dbus_call && target->service)
+	{
+		const ClpAppMgrAppNames *names = clp_app_mgr_app_names_get(appname);
+		GConfClient *client = clp_app_mgr_registry_client();
+		gchar *key_path = g_strconcat(names->info_dir, "/DBusService", NULL);
+		gchar *dbus_service = gconf_client_get_string (client, key_path, NULL);
+		g_free(key_path);
+		key_path = g_strconcat(names->info_dir, "/DBusObjPath", NULL);
+		gchar *dbus_objpath = gconf_client_get_string (client, key_path, NULL);
+		g_free(key_path);
+		key_path = g_strconcat(names->info_dir, "/DBusInterface", NULL);
+		gchar *dbus_interface = gconf_client_get_string (client, key_path, NULL);
+		g_free(key_path);
+
+		DBusGConnection *connection;
+		GError *gerror=NULL;
+		connection = dbus_g_bus_get(DBUS_BUS_SYSTEM, &gerror);
+		if (connection && dbus_service && dbus_objpath && dbus_interface)
+			target->proxy = dbus_g_proxy_new_for_name(connection, dbus_service, dbus_objpath, dbus_interface);
+		else
+			CLP_APPMGR_WARN_V("Unable to reach the middleware module %s", appname);
+		if (gerror)
+			g_error_free(gerror);
+		g_free(dbus_service);
+		g_free(dbus_objpath);
+		g_free(dbus_interface);
+	}
+	return target;
+}
+
+
+/** \brief Internal function resolving the default handler of a MIME type from the compiled desktop database
+ *
+ * \return The target, NULL if the MIME type has no handler
+ *
+ * \warning This function is internal to the Library
+ */
+static ClpAppMgrDispatchTarget*
+clp_app_mgr_dispatch_target_from_db(ClpAppMgrDesktopDb *db, const gchar *mime_type)
+{
+	const guint32 *apps;
+	const gchar *exec_type, *services;
+
+	if (clp_app_mgr_desktop_db_get_handlers(db, mime_type, &apps) == 0)
+		return NULL;
+
+	exec_type = clp_app_mgr_desktop_db_get_value(db, apps[0], "ExecType");
+	if (exec_type == NULL)
+		exec_type = clp_app_mgr_desktop_db_get_value(db, apps[0], "X-ExecType");
+	services = clp_app_mgr_desktop_db_get_value(db, apps[0], "Services");
+	if (services == NULL)
+		services = clp_app_mgr_desktop_db_get_value(db, apps[0], "X-Services");
+
+	return clp_app_mgr_dispatch_target_new(clp_app_mgr_desktop_db_get_app_name(db, apps[0]), exec_type, services);
+}
+
+
+typedef struct _ClpAppMgrMimeCacheLookup			/**< Search of one MIME type in mimeinfo.cache */
+{
+	const gchar	*mime_type;				/**< MIME type searched */
+	gchar		*desktop;				/**< first desktop file listed for it, NULL if none */
+}ClpAppMgrMimeCacheLookup;
+
+
+/** \brief Internal function checking one key of mimeinfo.cache for the MIME type searched
+ *
+ * \warning This function is internal to the Library
+ */
+static gboolean
+clp_app_mgr_mime_cache_lookup_func(const ClpAppMgrKeyFileEntry *entry, gpointer user_data)
+{
+	ClpAppMgrMimeCacheLookup *lookup = user_data;
+
+	if (clp_app_mgr_keyfile_entry_in_group(entry, "MIME Cache") && strlen(lookup->mime_type) == entry->key_len
+		&& g_ascii_strncasecmp(entry->key, lookup->mime_type, entry->key_len) == 0)
+	{
+		const gchar *separator = memchr(entry->value, ';', entry->value_len);
+		gsize length = separator ? (gsize) (separator - entry->value) : entry->value_len;
+
+		g_free(lookup->desktop);
+		lookup->desktop = length ? g_strndup(entry->value, length) : NULL;
+	}
+	return TRUE;
+}
+
+
+/** \brief Internal function resolving the default handler of a MIME type from mimeinfo.cache and the desktop files
+ *
+ * \return The target, NULL if the MIME type has no handler
+ *
+ * \warning This function is internal to the Library
+ */
+static ClpAppMgrDispatchTarget*
+clp_app_mgr_dispatch_target_from_files(const gchar *mime_type)
+{
+	ClpAppMgrDispatchTarget *target = NULL;
+	ClpAppMgrMimeCacheLookup lookup = { mime_type, NULL };
+	const gchar *keys[] = { "ExecType", "X-ExecType", "Services", "X-Services", NULL };
+	gchar *appname, *key, *values[4];
+	guint i;
+
+	clp_app_mgr_keyfile_parse(APPLICATION_INFO_PATH"mimeinfo.cache", clp_app_mgr_mime_cache_lookup_func, &lookup);
+	if (lookup.desktop == NULL)
+		return NULL;
+
+	appname = g_strndup(lookup.desktop, strcspn(lookup.desktop, "."));
+	key = g_strconcat(APPLICATION_INFO_PATH, lookup.desktop, NULL);
+	g_free(lookup.desktop);
+
+	if (clp_app_mgr_keyfile_get_start_values(key, keys, values))
+	{
+		target = clp_app_mgr_dispatch_target_new(appname, values[0] ? values[0] : values[1], values[2] ? values[2] : values[3]);
+		for (i = 0; i < G_N_ELEMENTS(values); i++)
+			g_free(values[i]);
+	}
+	else
+		CLP_APPMGR_WARN_V("Unable to read %s", key);
+	g_free(key);
+	g_free(appname);
+	return target;
+}
+
+
+/** \brief Internal function getting the default handler of a MIME type
+ *
+ * \param mime_type MIME type of the content
+ *
+ * \return A reference to the target, to be released with clp_app_mgr_dispatch_target_unref(). NULL if the
+ * MIME type has no handler.
+ *
+ * Targets are resolved once per MIME type and kept until the desktop files, mimeinfo.cache or the registry keys
+ * locating the middleware modules change, so handling the same kind of content again is a hash lookup. A target
+ * is resolved without the lock held, and a middleware module whose proxy could not be created is not kept.
+ *
+ * \warning This function is internal to the Library
+ */
+static ClpAppMgrDispatchTarget*
+clp_app_mgr_dispatch_target_get(const gchar *mime_type)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	guint desktop_generation = clp_app_mgr_monitor_get_generation(CLP_APP_MGR_MONITOR_DESKTOP);
+	guint mime_generation = clp_app_mgr_monitor_get_generation(CLP_APP_MGR_MONITOR_MIME);
+	guint dbus_generation = clp_app_mgr_monitor_get_generation(CLP_APP_MGR_MONITOR_DBUS);
+	gchar *key = g_ascii_strdown(mime_type, -1);
+	ClpAppMgrDispatchTarget *target;
+	ClpAppMgrDesktopDb *db;
+	GHashTable *targets;
+	gpointer cached;
+
+	G_LOCK(dispatch_targets);
+	if (dispatch_targets.targets == NULL || dispatch_targets.desktop_generation != desktop_generation
+		|| dispatch_targets.mime_generation != mime_generation || dispatch_targets.dbus_generation != dbus_generation)
+	{
+		if (dispatch_targets.targets)
+			g_hash_table_destroy(dispatch_targets.targets);
+		dispatch_targets.targets = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify) clp_app_mgr_dispatch_target_unref);
+		dispatch_targets.desktop_generation = desktop_generation;
+		dispatch_targets.mime_generation = mime_generation;
+		dispatch_targets.dbus_generation = dbus_generation;
+	}
+	targets = dispatch_targets.targets;
+	if (g_hash_table_lookup_extended(targets, key, NULL, &cached))
+	{
+		target = cached;
+		if (target)
+			g_atomic_int_inc(&target->ref_count);
+		G_UNLOCK(dispatch_targets);
+		g_free(key);
+		CLP_APPMGR_EXIT_FUNCTION();
+		return target;
+	}
+	G_UNLOCK(dispatch_targets);
+
+	/* the registry and the bus are queried without the lock, other threads keep dispatching meanwhile */
+	db = clp_app_mgr_desktop_db_get();
+	if (db)
+	{
+		target = clp_app_mgr_dispatch_target_from_db(db, key);
+		clp_app_mgr_desktop_db_unref(db);
+	}
+	else
+		target = clp_app_mgr_dispatch_target_from_files(key);
+
+	G_LOCK(dispatch_targets);
+	/* kept only if the table it was resolved for is still current and no other thread resolved it first */
+	if ((target == NULL || !target->dbus_call || target->proxy) && dispatch_targets.targets == targets
+		&& !g_hash_table_lookup_extended(targets, key, NULL, NULL))
+	{
+		g_hash_table_insert(targets, key, target);
+		key = NULL;
+		if (target)
+			g_atomic_int_inc(&target->ref_count);
+	}
+	G_UNLOCK(dispatch_targets);
+	g_free(key);
+
+	CLP_APPMGR_EXIT_FUNCTION();
+	return target;
+}
+
+
+/** \brief Internal function invoking the default handler of a MIME type
+ *
+ * \param target The default handler
+ * \param mime_type MIME type of the content
+ * \param mime_data The content
+ *
+ * \return CLP_APP_MGR_DBUS_CALL_FAIL if the handler is a middleware module that cannot be reached,
+ * CLP_APP_MGR_SUCCESS otherwise
+ *
+ * \warning This function is internal to the Library
+ */
+static gint
+clp_app_mgr_dispatch_mime(ClpAppMgrDispatchTarget *target, const gchar *mime_type, const gchar *mime_data)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	if( target->dbus_call && !target->proxy )
+	{
+		CLP_APPMGR_WARN_V("The middleware module %s cannot be reached, %s is not handled", target->appname, mime_type);
+		CLP_APPMGR_EXIT_FUNCTION();
+		return CLP_APP_MGR_DBUS_CALL_FAIL;
+	}
+	if( target->dbus_call )
+	{
+		CLP_APPMGR_INFO_V("The service handler is Middleware module. Calling a remote %s method with args - %s %s", target->service, mime_type, mime_data);
+		dbus_g_proxy_call_no_reply(target->proxy, target->service, G_TYPE_STRING, mime_type, G_TYPE_STRING, mime_data, G_TYPE_INVALID, G_TYPE_INVALID);
+	}
+	else if( !target->dbus_call && target->service )
+		clp_app_mgr_service_invoke(target->appname, target->service, mime_data,NULL);
+	else if( !target->dbus_call && !target->service )
+		clp_app_mgr_service_invoke(target->appname, mime_data,NULL);
+	CLP_APPMGR_EXIT_FUNCTION();
+	return CLP_APP_MGR_SUCCESS;
+}
+
+
 /** \brief Handle Content (Invoke default service) function for this string based MIME 
  *
  * \param mime_type MIME type for the string to be handled
@@ -1995,6 +2636,8 @@ gint clp_app_mgr_service_invoke(const gchar *application, ...)
 gint clp_app_mgr_handle_mime(const gchar *mime_type, const gchar *mime_data)
 {
 	CLP_APPMGR_ENTER_FUNCTION();
+	ClpAppMgrDispatchTarget *target;
+	gint return_code;
 
 	if(mime_type==NULL || mime_data== NULL)
 	{
@@ -2010,100 +2653,18 @@ gint clp_app_mgr_handle_mime(const gchar *mime_type, const gchar *mime_data)
 		return CLP_APP_MGR_FAILURE;
 	}
 
-	gchar *contents, **arr_str, **arr_mime, **arr_desktop, **arr_srvc, *key;
-	gsize length;
-	GError *error;
-	int i, dbus_call_flag=0, success_flag=0, service_not_empty=0;
-	gchar **str_srvc;
-	
-	g_file_get_contents(APPLICATION_INFO_PATH"mimeinfo.cache",&contents,&length,&error);
-
-	arr_str = g_strsplit(contents,"\n",MAX_NO_OF_LINES);
-	g_free(contents);
-	
-	for( i=1; *(arr_str+i)!=NULL; i++ )
-	{
-		arr_mime = g_strsplit(*(arr_str+i),"=",2);
-		
-		if( *arr_mime==NULL )	break;   //Because it was printing for the (null) value also n giving seg fault
-		
-		if( g_strcasecmp(mime_type,*arr_mime)==0 )
-		{
-			arr_desktop = g_strsplit(*(arr_mime+1),";",MAX_NO_OF_APPS_PER_MIME_TYPE);
-			gchar *appname = g_strdup (*(g_strsplit(*arr_desktop,".",2)));
-			CLP_APPMGR_INFO_V(" Default Application = %s\n",appname);
-
-			key = g_strconcat(APPLICATION_INFO_PATH,*arr_desktop,NULL);
-			if( g_strcasecmp(key,APPLICATION_INFO_PATH)==0 )	break;
-			g_file_get_contents(key,&contents,&length,&error);
-			g_free(key);
-					
-			arr_str = g_strsplit(contents,"\n",MAX_NO_OF_LINES);
-			g_free(contents);
-
-			for( i=1; *(arr_str+i)!=NULL; i++ )
-			{
-		                arr_mime = g_strsplit(*(arr_str+i),"=",2);
-				if( *arr_mime==NULL )   break;   //Because it was printing for the (null) value also n giving seg fault
-
-				if( g_strcasecmp("ExecType",*arr_mime)==0 || g_strcasecmp("X-ExecType",*arr_mime)==0 )
-					if( g_strcasecmp("dbus",*(arr_mime+1))==0 )
-						dbus_call_flag = 1;
-
-			        if( g_strcasecmp("Services",*arr_mime)==0 || g_strcasecmp("X-Services",*arr_mime)==0 )
-		                {
-					arr_srvc = g_strsplit(*(arr_mime+1),";",MAX_NO_OF_APPS_PER_MIME_TYPE);
-					if( *arr_srvc!=NULL )
-					{
-						str_srvc = g_strsplit(*arr_srvc,",",2);
-						CLP_APPMGR_INFO_V(" Default Service = %s\n",*str_srvc);
-						service_not_empty = 1;
-					}
-				}
-			}
-
-			if( dbus_call_flag==1 && service_not_empty==1 )
-			{
-				GConfClient *client = gconf_client_get_default();
-				gchar *key_path = g_strconcat("/appmgr/",appname,"/info/DBusService",NULL);
-				gchar *dbus_service = gconf_client_get_string (client, key_path, NULL);
-				g_free(key_path);
-				key_path = g_strconcat("/appmgr/",appname,"/info/DBusObjPath",NULL);
-				gchar *dbus_objpath = gconf_client_get_string (client, key_path, NULL);
-				g_free(key_path);
-				key_path = g_strconcat("/appmgr/",appname,"/info/DBusInterface",NULL);
-				gchar *dbus_interface = gconf_client_get_string (client, key_path, NULL);
-				g_free(key_path);
-					
-				CLP_APPMGR_INFO("The service handler is Middleware module. Calling a remote HandleMime method !!");
-				DBusGConnection *connection;
-				DBusGProxy *proxy;
-				GError *gerror=NULL;
-				connection = dbus_g_bus_get(DBUS_BUS_SYSTEM, &gerror);
-				proxy = dbus_g_proxy_new_for_name(connection, dbus_service, dbus_objpath, dbus_interface);
-				CLP_APPMGR_INFO_V("Calling - %s %s %s with args - %s %s",dbus_service, dbus_objpath, dbus_interface, mime_type, mime_data);
-				dbus_g_proxy_call_no_reply(proxy, *str_srvc, G_TYPE_STRING, mime_type, G_TYPE_STRING, mime_data, G_TYPE_INVALID, G_TYPE_INVALID);
-			}
-			else if( dbus_call_flag==0 && service_not_empty==1 )
-				clp_app_mgr_service_invoke(appname, *str_srvc, mime_data,NULL);
-			else if( dbus_call_flag==0 && service_not_empty==0 )
-				clp_app_mgr_service_invoke(appname, mime_data,NULL);
-			success_flag = 1;
-			break;
-		}
-	}
-
-	if(success_flag)
-	{
-		CLP_APPMGR_EXIT_FUNCTION();
-		return CLP_APP_MGR_SUCCESS;
-	}
-	else
+	target = clp_app_mgr_dispatch_target_get(mime_type);
+	if (target == NULL)
 	{
 		CLP_APPMGR_WARN_V(" Unsupported Content - %s",mime_type);
 		CLP_APPMGR_EXIT_FUNCTION();
 		return CLP_APP_MGR_FAILURE;
 	}
+	return_code = clp_app_mgr_dispatch_mime(target, mime_type, mime_data);
+	clp_app_mgr_dispatch_target_unref(target);
+
+	CLP_APPMGR_EXIT_FUNCTION();
+	return return_code;
 }
 
 
@@ -2130,7 +2691,7 @@ gint clp_app_mgr_handle_string(const gchar *data)
 		return CLP_APP_MGR_FAILURE;
 	}
 
-	gchar *mime_type = (gchar*) xdg_mime_get_mime_type_from_file_name (data);
+	gchar *mime_type = clp_app_mgr_mime_from_string (data);
 	CLP_APPMGR_EXIT_FUNCTION();
 	return (clp_app_mgr_handle_mime(mime_type, data));
 }
@@ -2152,17 +2713,122 @@ gint clp_app_mgr_handle_file(const gchar *filepath)
 {
 	CLP_APPMGR_ENTER_FUNCTION();
 
-	if(filepath==NULL)
+	if(filepath==NULL)
+	{
+		CLP_APPMGR_WARN("Parameter 'filepath' is NULL and hence it cannot be handled");
+		CLP_APPMGR_EXIT_FUNCTION();
+		return CLP_APP_MGR_FAILURE;
+	}
+	 
+	gchar *mime_type = clp_app_mgr_mime_from_file (filepath);
+
+	CLP_APPMGR_EXIT_FUNCTION();
+	return (clp_app_mgr_handle_mime(mime_type, filepath));
+}
+
+
+typedef struct _ClpAppMgrDispatchGroup				/**< Files of a batch going to the same handler */
+{
+	ClpAppMgrDispatchTarget	*target;			/**< the handler, referenced */
+	GPtrArray		*argv;				/**< its default service if any, then the files */
+}ClpAppMgrDispatchGroup;
+
+
+/** \brief Handle Content (Invoke default service) function for many files at once
+ *
+ * \param filepaths NULL terminated list of file names alongwith the path for which default service is to be invoked
+ *
+ * \return CLP_APP_MGR_SUCCESS - All the files were handed to their handler
+ * \return CLP_APP_MGR_FAILURE - Some file has no handler or some handler could not be launched. The other files
+ * are handled all the same.
+ *
+ * The files are read ahead in parallel, then their MIME types are sniffed and they are grouped by default
+ * handler. Each handler is launched once with its default service, if it declares one, followed by all its files,
+ * in the order they were given. A middleware module only takes one file per call, it gets one call per file.
+ */
+gint clp_app_mgr_handle_files(const gchar * const *filepaths)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	GPtrArray *groups;
+	guint n_files, i, j;
+	gint rv = CLP_APP_MGR_SUCCESS;
+
+	if(filepaths==NULL)
+	{
+		CLP_APPMGR_WARN("Parameter 'filepaths' is NULL and hence it cannot be handled");
+		CLP_APPMGR_EXIT_FUNCTION();
+		return CLP_APP_MGR_FAILURE;
+	}
+
+	for (n_files = 0; filepaths[n_files]; n_files++)
+		;
+	clp_app_mgr_prefetch_files(filepaths, n_files, xdg_mime_get_max_buffer_extents());
+
+	groups = g_ptr_array_new();
+	for (i = 0; i < n_files; i++)
+	{
+		const gchar *mime_type = clp_app_mgr_mime_cache_file (filepaths[i]);
+		ClpAppMgrDispatchTarget *target;
+		ClpAppMgrDispatchGroup *group = NULL;
+
+		if (mime_type == NULL || strcmp(mime_type,"application/octet-stream")==0)
+		{
+			CLP_APPMGR_WARN_V("No valid mime type for %s and hence it cannot be handled", filepaths[i]);
+			rv = CLP_APP_MGR_FAILURE;
+			continue;
+		}
+		target = clp_app_mgr_dispatch_target_get(mime_type);
+		if (target == NULL)
+		{
+			CLP_APPMGR_WARN_V(" Unsupported Content - %s",mime_type);
+			rv = CLP_APP_MGR_FAILURE;
+			continue;
+		}
+		if (target->dbus_call)
+		{
+			if (clp_app_mgr_dispatch_mime(target, mime_type, filepaths[i]) != CLP_APP_MGR_SUCCESS)
+				rv = CLP_APP_MGR_FAILURE;
+			clp_app_mgr_dispatch_target_unref(target);
+			continue;
+		}
+
+		for (j = 0; j < groups->len && group == NULL; j++)
+		{
+			ClpAppMgrDispatchGroup *candidate = g_ptr_array_index(groups, j);
+			if (strcmp(candidate->target->appname, target->appname) == 0
+				&& g_strcmp0(candidate->target->service, target->service) == 0)
+				group = candidate;
+		}
+		if (group)
+			clp_app_mgr_dispatch_target_unref(target);
+		else
+		{
+			group = g_new(ClpAppMgrDispatchGroup, 1);
+			group->target = target;
+			group->argv = g_ptr_array_new();
+			if (target->service)
+				g_ptr_array_add(group->argv, target->service);
+			g_ptr_array_add(groups, group);
+		}
+		g_ptr_array_add(group->argv, (gpointer) filepaths[i]);
+	}
+
+	for (i = 0; i < groups->len; i++)
 	{
-		CLP_APPMGR_WARN("Parameter 'filepath' is NULL and hence it cannot be handled");
-		CLP_APPMGR_EXIT_FUNCTION();
-		return CLP_APP_MGR_FAILURE;
+		ClpAppMgrDispatchGroup *group = g_ptr_array_index(groups, i);
+
+		CLP_APPMGR_INFO_V("Handing %u arguments to %s", group->argv->len, group->target->appname);
+		/* same argument string as clp_app_mgr_handle_file() sends for one file */
+		if (clp_app_mgr_launch_or_forward(group->target->appname, group->argv->len, (gchar**) group->argv->pdata, FALSE, -1) != CLP_APP_MGR_SUCCESS)
+			rv = CLP_APP_MGR_FAILURE;
+		g_ptr_array_free(group->argv, TRUE);
+		clp_app_mgr_dispatch_target_unref(group->target);
+		g_free(group);
 	}
-	 
-	gchar *mime_type = (gchar*) xdg_mime_get_mime_type_for_file (filepath,NULL);
+	g_ptr_array_free(groups, TRUE);
 
 	CLP_APPMGR_EXIT_FUNCTION();
-	return (clp_app_mgr_handle_mime(mime_type, filepath));
+	return rv;
 }
 
 /* service discovery end */
@@ -2172,15 +2838,15 @@ gint clp_app_mgr_handle_file(const gchar *filepath)
 
 /**\brief Internal Function to Get the list of windows from DBUS message
  *
- * \return GSList of ClpAppMgrWindowInfo
+ * \return ClpAppMgrArray of ClpAppMgrWindowInfo
  *
- * The function will get the list of windows in the form of GSList. 
- * The data part is ClpAppMgrWindowInfo structure which comtains the required information about the Application.
+ * The function will get the list of windows in the form of one ClpAppMgrArray block. 
+ * The records are ClpAppMgrWindowInfo structures which contain the required information about the Application.
  */
-static GSList *clp_app_mgr_wm_parse_window_list(DBusMessage *msg)
+static ClpAppMgrArray *clp_app_mgr_wm_parse_window_list(DBusMessage *msg)
 {
 	CLP_APPMGR_ENTER_FUNCTION();
-	GSList *window_list=NULL;
+	ClpAppMgrArrayBuilder builder;
 	DBusMessageIter iter, array_iter_read, struct_iter_read;
 	gint num_elem, i;
 	
@@ -2189,6 +2855,7 @@ static GSList *clp_app_mgr_wm_parse_window_list(DBusMessage *msg)
 	gchar *title=NULL;
 	gchar *icon=NULL;
 	
+	clp_app_mgr_array_builder_init(&builder, sizeof(ClpAppMgrWindowInfo));
 	dbus_message_iter_init(msg, &iter);
 	dbus_message_iter_get_basic(&iter, &num_elem);
 
@@ -2199,48 +2866,41 @@ static GSList *clp_app_mgr_wm_parse_window_list(DBusMessage *msg)
 	}
 	
 	for (i = 0; i < num_elem; i++) {
-		ClpAppMgrWindowInfo *new_window = (ClpAppMgrWindowInfo*)g_malloc0(sizeof (ClpAppMgrWindowInfo));
+		ClpAppMgrWindowInfo *new_window = clp_app_mgr_array_builder_append(&builder);
 
 		dbus_message_iter_recurse(&array_iter_read, &struct_iter_read);
 		
 		dbus_message_iter_get_basic(&struct_iter_read, &title);
-		new_window->title = g_strdup(title);
+		clp_app_mgr_array_builder_set_string(&builder, G_STRUCT_OFFSET(ClpAppMgrWindowInfo, title), title);
 		dbus_message_iter_next(&struct_iter_read);
-		CLP_APPMGR_INFO_V("\npid:%d,id:%d,title:%s,icon:%s",new_window->pid,new_window->windowid,new_window->title,new_window->icon);
 		
 		dbus_message_iter_get_basic(&struct_iter_read, &icon);
-		new_window->icon = g_strdup(icon);
+		clp_app_mgr_array_builder_set_string(&builder, G_STRUCT_OFFSET(ClpAppMgrWindowInfo, icon), icon);
 		dbus_message_iter_next(&struct_iter_read);
-		CLP_APPMGR_INFO_V("\npid:%d,id:%d,title:%s,icon:%s",new_window->pid,new_window->windowid,new_window->title,new_window->icon);
 
 		dbus_message_iter_get_basic(&struct_iter_read, &pid);
 		new_window->pid = pid;
 		dbus_message_iter_next(&struct_iter_read);
-		CLP_APPMGR_INFO_V("\npid:%d,id:%d,title:%s,icon:%s",new_window->pid,new_window->windowid,new_window->title,new_window->icon);
 		
 		dbus_message_iter_get_basic(&struct_iter_read, &windowid);
 		new_window->windowid = windowid;
 		dbus_message_iter_next(&array_iter_read);
-		CLP_APPMGR_INFO_V("\npid:%d,id:%d,title:%s,icon:%s",new_window->pid,new_window->windowid,new_window->title,new_window->icon);
 		
-		window_list = g_slist_append(window_list, new_window);
-
-
-		CLP_APPMGR_INFO_V("\npid:%d,id:%d,title:%s,icon:%s",new_window->pid,new_window->windowid,new_window->title,new_window->icon);
+		CLP_APPMGR_INFO_V("\npid:%d,id:%d,title:%s,icon:%s",pid,windowid,title,icon);
 	}
 
 	CLP_APPMGR_EXIT_FUNCTION();
-	return window_list;
+	return clp_app_mgr_array_builder_finish(&builder);
 }
 
 
 /** \brief List the displayable windows in the system
  *
- * \return List of windows currently registered with the window manager 
+ * \return ClpAppMgrArray of ClpAppMgrWindowInfo, to be freed with clp_app_mgr_array_free(). NULL if the window manager did not answer.
  *
- * The function gives the list of windows. Mainly useful for the switcher 
+ * Same information as clp_app_mgr_wm_get_window_list(), returned as one contiguous block.
  */
-GSList* clp_app_mgr_wm_get_window_list()
+ClpAppMgrArray* clp_app_mgr_wm_get_window_list_v2(void)
 {
 	CLP_APPMGR_ENTER_FUNCTION();
 
@@ -2248,7 +2908,7 @@ GSList* clp_app_mgr_wm_get_window_list()
 	DBusError error;
 	dbus_error_init(&error);
 			        
-	GSList *window_list=NULL;
+	ClpAppMgrArray *window_list=NULL;
 				        
 	msg = dbus_message_new_method_call (CLP_WIN_MGR_DBUS_SERVICE, CLP_WIN_MGR_DBUS_OBJECT, CLP_WIN_MGR_DBUS_INTERFACE, CLP_WIN_MGR_GET_WINDOW_LIST_METHOD);      
         if (NULL == msg)
@@ -2259,20 +2919,59 @@ GSList* clp_app_mgr_wm_get_window_list()
 	}
 
 	DBusMessage *reply = dbus_connection_send_with_reply_and_block (appclient_context.bus_conn, msg, -1, &error);
+	dbus_message_unref(msg);
 	if (reply==NULL)
 	{       
 	       CLP_APPMGR_WARN_V("Got Reply Null : error: %s", error.message);
+	       dbus_error_free(&error);
 	       CLP_APPMGR_EXIT_FUNCTION();
 	       return NULL;
 	}
 								        
 	window_list = clp_app_mgr_wm_parse_window_list(reply);
+	dbus_message_unref(reply);
 	CLP_APPMGR_EXIT_FUNCTION();
 	
 	return window_list;
 }
 
 
+/** \brief List the displayable windows in the system
+ *
+ * \return List of windows currently registered with the window manager 
+ *
+ * The function gives the list of windows. Mainly useful for the switcher 
+ */
+GSList* clp_app_mgr_wm_get_window_list()
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	ClpAppMgrArray *array = clp_app_mgr_wm_get_window_list_v2();
+	GSList *window_list=NULL;
+	guint i;
+
+	if (array == NULL)
+	{
+		CLP_APPMGR_EXIT_FUNCTION();
+		return NULL;
+	}
+	for (i = array->n_records; i > 0; i--)
+	{
+		const ClpAppMgrWindowInfo *record = &CLP_APP_MGR_ARRAY_INDEX(array, ClpAppMgrWindowInfo, i - 1);
+		ClpAppMgrWindowInfo *new_window = (ClpAppMgrWindowInfo*)g_malloc0(sizeof (ClpAppMgrWindowInfo));
+
+		new_window->pid = record->pid;
+		new_window->windowid = record->windowid;
+		new_window->title = g_strdup(record->title);
+		new_window->icon = g_strdup(record->icon);
+		window_list = g_slist_prepend(window_list, new_window);
+	}
+	clp_app_mgr_array_free(array);
+
+	CLP_APPMGR_EXIT_FUNCTION();
+	return window_list;
+}
+
+
 /** \brief Locks the screen
  *
  * \return CLP_APP_MGR_SUCCESS - lock screen successful
@@ -3242,9 +3941,8 @@ clp_app_mgr_power_off(void)
 	
 	//g_timeout_add(15000,forceful_power_off_handler,NULL);
 	
-	GConfClient *client = gconf_client_get_default();
+	GConfClient *client = clp_app_mgr_registry_client();
 	gconf_client_set_bool(client,"/appmgr/Shutdown",TRUE,NULL);
-	g_object_unref(G_OBJECT(client));
 	
 	DBusMessage *mesg;
 	mesg = dbus_message_new_signal (CLP_APP_MGR_DBUS_OBJECT,CLP_APP_MGR_DBUS_INTERFACE,CLP_APP_MGR_DBUS_SIGNAL_STOP);
@@ -3288,7 +3986,7 @@ gint clp_app_mgr_get_priority(pid_t pid, guint *our_priority)
 	CLP_APPMGR_ENTER_FUNCTION();
 	GSList *appdirs = NULL;
 	GError *err = NULL;
-	GConfClient *client = gconf_client_get_default();
+	GConfClient *client = clp_app_mgr_registry_client();
 	appdirs = gconf_client_all_dirs(client, "/appmgr", &err);
 	
 	/*traverse the list of applications and read the info*/
@@ -3336,20 +4034,41 @@ gint clp_app_mgr_get_priority(pid_t pid, guint *our_priority)
  *
  * Returned back in the get_active_apps call. The application switcher should not display inactive applications.
  * It allows application to be invisibile from switching for periods of time. 
+ * The change is announced at once with a VisibilityChanged signal, the registry write is buffered so that an
+ * application toggling its visibility costs one gconf write per CLP_APP_MGR_WRITEBACK_DEADLINE at most.
  * 
  */
 gint clp_app_mgr_set_visibility(gboolean visibility)
 {
 	CLP_APPMGR_ENTER_FUNCTION();
 	
-	gchar app_id[NAME_SIZE];
-	GError *err = NULL;
-	GConfClient *client = gconf_client_get_default();
-	sprintf(app_id, "%d", appclient_context.app_id);
+	visibility = visibility ? TRUE : FALSE;
+	if (appclient_context.init_done && appclient_context.visibility == visibility)
+	{
+		CLP_APPMGR_EXIT_FUNCTION();
+		return CLP_APP_MGR_SUCCESS;
+	}
+
 	gchar *key_path = g_strconcat(GCONF_APPS_DIR, "/", appclient_context.app_name,"/info/Visibility", NULL);
 	CLP_APPMGR_INFO_V("Key Path - %s\n", key_path);
-	gconf_client_set_bool(client, key_path, visibility, &err);
+	clp_app_mgr_writeback_set_bool(key_path, visibility);
 	g_free(key_path);
+
+	if (appclient_context.init_done)
+	{
+		appclient_context.visibility = visibility;
+		DBusMessage *msg = dbus_message_new_signal (CLP_APP_MGR_DBUS_OBJECT, CLP_APP_MGR_DBUS_INTERFACE, CLP_APP_MGR_DBUS_SIGNAL_VISIBILITY);
+		if (msg == NULL)
+		{
+			CLP_APPMGR_WARN("Out Of Memory!");
+			CLP_APPMGR_EXIT_FUNCTION();
+			return CLP_APP_MGR_OUT_OF_MEMORY;
+		}
+		dbus_bool_t dbus_visibility = visibility;
+		dbus_message_append_args (msg, DBUS_TYPE_INT32, &appclient_context.pid, DBUS_TYPE_BOOLEAN, &dbus_visibility, DBUS_TYPE_INVALID);
+		dbus_connection_send (appclient_context.bus_conn, msg, NULL);
+		dbus_message_unref (msg);
+	}
 	CLP_APPMGR_EXIT_FUNCTION();
 	return CLP_APP_MGR_SUCCESS;
 }
@@ -3378,6 +4097,75 @@ clp_app_mgr_menupos_compare(gpointer a, gpointer b)
 }
 
 
+/**\brief Get the requested fields of the currently installed applications
+ * 
+ * \param appclass Menu path prefix of the applications to be retrived, "menu" or "/" for the top level menu. Pass NULL to retrive all the apps.
+ * \param fields Mask of CLP_APP_MGR_FIELD_NAME, CLP_APP_MGR_FIELD_GENERIC_NAME, CLP_APP_MGR_FIELD_ICON,
+ * CLP_APP_MGR_FIELD_EXEC_NAME, CLP_APP_MGR_FIELD_MENU_PATH, CLP_APP_MGR_FIELD_NODISPLAY and CLP_APP_MGR_FIELD_MENUPOS
+ * 
+ * \return ClpAppMgrArray of ClpAppMgrInstalledApp, to be freed with clp_app_mgr_array_free()
+ *
+ * Fields left out of the mask are 0 or NULL and their strings are not copied into the result.
+ */
+ClpAppMgrArray*
+clp_app_mgr_get_installed_apps_fields(const gchar *appclass, guint fields)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	ClpAppMgrMenuIndex *index = clp_app_mgr_menu_index_get();
+	ClpAppMgrInstalledApp * const *apps;
+	ClpAppMgrArrayBuilder builder;
+	gboolean top_level = appclass && (!strcmp(appclass,"menu") || !strcmp(appclass,"/"));
+	guint n_apps, i;
+
+	apps = clp_app_mgr_menu_index_lookup(index, "/", !top_level, &n_apps);
+	clp_app_mgr_array_builder_init(&builder, sizeof(ClpAppMgrInstalledApp));
+
+	for (i = 0; i < n_apps; i++)
+	{
+		const ClpAppMgrInstalledApp *record = apps[i];
+
+		/* the menu path is matched as a plain string prefix, as it always was */
+		if (appclass && !top_level && !g_str_has_prefix(record->menu_path, appclass))
+			continue;
+
+		ClpAppMgrInstalledApp *app = clp_app_mgr_array_builder_append(&builder);
+		if (fields & CLP_APP_MGR_FIELD_NODISPLAY)
+			app->nodisplay = record->nodisplay;
+		if (fields & CLP_APP_MGR_FIELD_MENUPOS)
+			app->menupos = record->menupos;
+		if (fields & CLP_APP_MGR_FIELD_NAME)
+			clp_app_mgr_array_builder_set_string(&builder, G_STRUCT_OFFSET(ClpAppMgrInstalledApp, name), record->name);
+		if (fields & CLP_APP_MGR_FIELD_GENERIC_NAME)
+			clp_app_mgr_array_builder_set_string(&builder, G_STRUCT_OFFSET(ClpAppMgrInstalledApp, generic_name), record->generic_name);
+		if (fields & CLP_APP_MGR_FIELD_ICON)
+			clp_app_mgr_array_builder_set_string(&builder, G_STRUCT_OFFSET(ClpAppMgrInstalledApp, icon), record->icon);
+		if (fields & CLP_APP_MGR_FIELD_EXEC_NAME)
+			clp_app_mgr_array_builder_set_string(&builder, G_STRUCT_OFFSET(ClpAppMgrInstalledApp, exec_name), record->exec_name);
+		if (fields & CLP_APP_MGR_FIELD_MENU_PATH)
+			clp_app_mgr_array_builder_set_string(&builder, G_STRUCT_OFFSET(ClpAppMgrInstalledApp, menu_path), record->menu_path);
+	}
+	clp_app_mgr_menu_index_unref(index);
+
+	CLP_APPMGR_EXIT_FUNCTION();
+	return clp_app_mgr_array_builder_finish(&builder);
+}
+
+
+/**\brief Get the list of currently installed application
+ * 
+ * \param appclass Menu path prefix of the applications to be retrived, "menu" or "/" for the top level menu. Pass NULL to retrive all the apps.
+ * 
+ * \return ClpAppMgrArray of ClpAppMgrInstalledApp, to be freed with clp_app_mgr_array_free()
+ *
+ * Same information as clp_app_mgr_get_installed_apps(), returned as one contiguous block in menu order.
+ */
+ClpAppMgrArray*
+clp_app_mgr_get_installed_apps_v2(const gchar *appclass)
+{
+	return clp_app_mgr_get_installed_apps_fields(appclass, CLP_APP_MGR_FIELD_ALL);
+}
+
+
 /**\brief Get the list of currently installed application
  * 
  * \param appclass Generic Name of the applications to be retrived. Pass NULL to retrive all the apps.
@@ -3386,121 +4174,108 @@ clp_app_mgr_menupos_compare(gpointer a, gpointer b)
  *
  * The function will get the list of currently installed applications in the form of GList. 
  * The data part is ClpAppMgrInstalledApp structure which comtains the required information about the Application.
+ * The list is a copy of the menu index, clp_app_mgr_menu_index_lookup() gives the same records without copying.
  */
 GList*
 clp_app_mgr_get_installed_apps(gchar *appclass)
 {
 	CLP_APPMGR_ENTER_FUNCTION();
+	ClpAppMgrArray *array = clp_app_mgr_get_installed_apps_v2(appclass);
 	GList *installed_apps = NULL;
+	guint i;
 
-	GSList *appdirs = NULL;
-	GError *err = NULL;
-	GConfClient *client = gconf_client_get_default();
-
-	appdirs = gconf_client_all_dirs(client, "/appmgr", &err);
-	
-	/*traverse the list of applications and read the info*/
-	while (appdirs)
+	for (i = array->n_records; i > 0; i--)
 	{
+		const ClpAppMgrInstalledApp *record = &CLP_APP_MGR_ARRAY_INDEX(array, ClpAppMgrInstalledApp, i - 1);
 		ClpAppMgrInstalledApp *app = (ClpAppMgrInstalledApp*) g_malloc0 (sizeof(ClpAppMgrInstalledApp));
-		gchar *key_path = g_strconcat(appdirs->data,"/info/", NULL);
 
-		CLP_APPMGR_INFO_V("key_path : %s  -- ",key_path);
-		gchar *temp;
+		app->name = g_strdup(record->name);
+		app->generic_name = g_strdup(record->generic_name);
+		app->icon = g_strdup(record->icon);
+		app->exec_name = g_strdup(record->exec_name);
+		app->menu_path = g_strdup(record->menu_path);
+		app->nodisplay = record->nodisplay;
+		app->menupos = record->menupos;
+		installed_apps = g_list_prepend(installed_apps, app);
+	}
+	clp_app_mgr_array_free(array);
 
-		err=NULL;
-		temp = g_strconcat (key_path, "Name", NULL);
-		app->name = gconf_client_get_string (client, temp, &err);
-		g_free(temp);
-		if(app->name==NULL)
+	CLP_APPMGR_EXIT_FUNCTION();
+	print_me(installed_apps);
+	return installed_apps;
+}
+
+
+/** \brief Get several properties of the application
+ * 
+ * \param application Name of the application
+ * \param properties NULL terminated array of property names
+ *
+ * \return ClpAppMgrArray of ClpAppMgrProperty, one record per name in the same order, to be freed with
+ * clp_app_mgr_array_free(). The value of a property that is not set is NULL. NULL if the .desktop file of the
+ * application cannot be read.
+ *
+ * The overlay log of the application is read first, see clp_app_mgr_set_property(). The other properties are
+ * served from the compiled desktop database when the application is in it, else the start group of the .desktop
+ * file is read once for all of them.
+ */
+ClpAppMgrArray* clp_app_mgr_get_properties (const gchar *application, const gchar * const *properties)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	gchar **file_values = NULL;
+	ClpAppMgrDesktopDb *db;
+	ClpAppMgrArrayBuilder builder;
+	gint app = -1;
+	guint i;
+
+	if ((db = clp_app_mgr_desktop_db_get()) != NULL)
+		app = clp_app_mgr_desktop_db_find_app(db, application);
+
+	clp_app_mgr_array_builder_init(&builder, sizeof(ClpAppMgrProperty));
+	for (i = 0; properties && properties[i]; i++)
+	{
+		ClpAppMgrProperty *record = clp_app_mgr_array_builder_append(&builder);
+		gchar *value;
+
+		clp_app_mgr_array_builder_set_string(&builder, G_STRUCT_OFFSET(ClpAppMgrProperty, key), properties[i]);
+		if (clp_app_mgr_overlay_lookup(application, properties[i], &value))
 		{
-			CLP_APPMGR_WARN("app->name is NULL. It means the gconf repository is not properly updated.");
-			appdirs=appdirs->next;
+			clp_app_mgr_array_builder_set_string(&builder, G_STRUCT_OFFSET(ClpAppMgrProperty, value), value);
+			g_free(value);
 			continue;
 		}
-		
-		err=NULL;
-		temp = g_strconcat (key_path, "Command", NULL);
-		if(temp==NULL)
+		if (app >= 0)
 		{
-			CLP_APPMGR_WARN("app->exec_name is NULL. It means the gconf repository is not properly updated.");
-			appdirs=appdirs->next;
+			clp_app_mgr_array_builder_set_string(&builder, G_STRUCT_OFFSET(ClpAppMgrProperty, value),
+				clp_app_mgr_desktop_db_get_value(db, app, properties[i]));
 			continue;
 		}
-		gchar **temp_name = g_strsplit((gchar *)(gconf_client_get_string (client, temp, &err))," ",2);
-		app->exec_name = g_strdup(temp_name[0]);
-		g_free(temp);
-		g_strfreev(temp_name);
-
-		err=NULL;
-		temp = g_strconcat (key_path, "GenericName", NULL);
-		app->generic_name = gconf_client_get_string (client, temp, &err);
-		g_free(temp);
-		if(app->generic_name==NULL)
-		{
-			CLP_APPMGR_WARN("app->generic_name is NULL. It means the gconf repository is not properly updated.");
-		}
-		
-		err=NULL;
-		temp = g_strconcat (key_path, "Icon", NULL);
-		app->icon = gconf_client_get_string (client, temp, &err);
-		g_free(temp);
-		if(app->icon==NULL)
-		{
-			CLP_APPMGR_WARN("app->icon is NULL. It means the gconf repository is not properly updated.");
-			app->icon = g_strdup(CLP_APP_MGR_NO_ICON);
-		}
-
-		err=NULL;
-		temp = g_strconcat (key_path, "NoDisplay", NULL);
-		app->nodisplay = gconf_client_get_bool (client, temp, &err);
-		g_free(temp);
 
-		err=NULL;
-		temp = g_strconcat (key_path, "MenuPath", NULL);
-		app->menu_path = gconf_client_get_string (client, temp, &err);
-		g_free(temp);
-		if(app->menu_path==NULL)
+		if (file_values == NULL)
 		{
-			CLP_APPMGR_WARN("app->menu_path is NULL. It means the gconf repository is not properly updated.");
-			app->menu_path = g_strdup("/");
-		}
-		
-		err=NULL;
-		temp = g_strconcat (key_path, "MenuPos", NULL);
-		app->menupos = gconf_client_get_int (client, temp, &err);
-		g_free(temp);
-		
-		appdirs = appdirs->next;
-	
-		if(appclass == NULL) {
-			CLP_APPMGR_INFO_V("Name: %s    NoDisplay: %d",app->name, app->nodisplay);
-			installed_apps = g_list_append(installed_apps, app);
-			continue;
-		}
-		else if(!strcmp(appclass,"menu") || !strcmp(appclass,"/")) {
-			if(!strcmp(app->menu_path, "/"))
-			{		
-				CLP_APPMGR_INFO_V("Name: %s    NoDisplay: %d MenuPath: %s",app->name, app->nodisplay, app->menu_path);
-				installed_apps = g_list_append(installed_apps, app);
-				continue;
-			}
-		}
-		else {
-			if(g_str_has_prefix(app->menu_path, appclass))
+			file_values = g_new0(gchar*, g_strv_length((gchar **) properties) + 1);
+			if (!clp_app_mgr_keyfile_get_start_values(clp_app_mgr_app_names_get(application)->desktop_file, properties, file_values))
 			{
-				CLP_APPMGR_INFO_V("Name: %s    NoDisplay: %d MenuPath: %s",app->name, app->nodisplay, app->menu_path);
-				installed_apps = g_list_append(installed_apps, app);
-				continue;
+				CLP_APPMGR_WARN_V("Unable to read the desktop file of %s", application);
+				g_free(file_values);
+				clp_app_mgr_desktop_db_unref(db);
+				clp_app_mgr_array_free(clp_app_mgr_array_builder_finish(&builder));
+				CLP_APPMGR_EXIT_FUNCTION();
+				return NULL;
 			}
 		}
-		g_free(key_path);
-		g_free(app);
+		clp_app_mgr_array_builder_set_string(&builder, G_STRUCT_OFFSET(ClpAppMgrProperty, value), file_values[i]);
 	}
 
+	if (file_values)
+	{
+		for (i = 0; properties[i]; i++)
+			g_free(file_values[i]);
+		g_free(file_values);
+	}
+	clp_app_mgr_desktop_db_unref(db);
 	CLP_APPMGR_EXIT_FUNCTION();
-	print_me(installed_apps);
-	return installed_apps;
+	return clp_app_mgr_array_builder_finish(&builder);
 }
 
 
@@ -3512,95 +4287,100 @@ clp_app_mgr_get_installed_apps(gchar *appclass)
  * \return Return the value of the property
  *
  * The function reads the .desktop file of the provided application and reads the property value
- * and returns it to the user. 
+ * and returns it to the user. A value set with clp_app_mgr_set_property() and still in the overlay log
+ * takes precedence over the desktop file. clp_app_mgr_get_properties() reads several properties at once.
  */
 gchar* clp_app_mgr_get_property (const gchar *application, const gchar *property)
 {
 	CLP_APPMGR_ENTER_FUNCTION();
-	GError *load_error = NULL, *error;
-	GKeyFile *keyfile;
-	gchar *desktop_file=NULL;
-	gchar *return_value;
-	
-	keyfile = g_key_file_new ();
-	
-	desktop_file = g_strconcat(APPLICATION_INFO_PATH, application, ".desktop", NULL);
-	
-	g_key_file_load_from_file (keyfile, desktop_file, G_KEY_FILE_NONE, &load_error);
-	
-	if (load_error != NULL) 
-	{
-		g_propagate_error (&error, load_error);
-		CLP_APPMGR_EXIT_FUNCTION();
-		return NULL;
-	}
-	load_error = NULL;
-	return_value = g_key_file_get_value (keyfile, g_key_file_get_start_group (keyfile), property, &load_error);
-	if (load_error != NULL) 
+	const gchar *properties[] = { property, NULL };
+	ClpAppMgrArray *array = clp_app_mgr_get_properties(application, properties);
+	gchar *return_value = NULL;
+
+	if (array)
 	{
-		g_propagate_error (&error, load_error);
-		CLP_APPMGR_EXIT_FUNCTION();
-		return NULL;
+		return_value = g_strdup(CLP_APP_MGR_ARRAY_INDEX(array, ClpAppMgrProperty, 0).value);
+		clp_app_mgr_array_free(array);
 	}
-	
-	g_free(desktop_file);	
-	g_key_file_free (keyfile);
 	CLP_APPMGR_EXIT_FUNCTION();
 	return return_value;
 }
 
 
-/** \brief Set the property of the application
+/** \brief Set several properties of the application
  * 
  * \param application Name of the application
- * \param property The property name
- * \param value The value to be set
+ * \param properties NULL terminated array of property names
+ * \param values The values to be set, one per property name
  *
- * The function opens the .desktop file of the provided application and sets the property value
- * from the user. 
+ * The values are appended to the overlay log of the application with a single write, see clp-app-mgr-overlay.h.
+ * The log is written into the .desktop file once it grows large, or at once with the values when one of the
+ * properties is read by the library itself (Exec, X-Services, MimeType...). If the log cannot be written the function
+ * opens the .desktop file of the provided application once, sets all the values and rewrites it.
  */
-void clp_app_mgr_set_property (const gchar *application, const gchar *property, const gchar *value)
+void clp_app_mgr_set_properties (const gchar *application, const gchar * const *properties, const gchar * const *values)
 {
 	CLP_APPMGR_ENTER_FUNCTION();
-	GError *load_error = NULL, *error=NULL, *write_error=NULL;
+	GError *write_error = NULL;
 	GKeyFile *keyfile;
-	gchar *desktop_file=NULL;
+	const gchar *desktop_file;
 	gchar *data;
 	gsize length;
-	gboolean res;
-	
-	keyfile = g_key_file_new ();
-	
-	desktop_file = g_strconcat(APPLICATION_INFO_PATH, application, ".desktop", NULL);
-
-	g_key_file_load_from_file (keyfile, desktop_file, G_KEY_FILE_NONE, &load_error);
+	guint i, n_properties = properties ? g_strv_length((gchar **) properties) : 0;
 
-	if (load_error != NULL) 
+	if (n_properties == 0 || clp_app_mgr_overlay_set(application, properties, values, n_properties))
 	{
-		g_propagate_error (&error, load_error);
 		CLP_APPMGR_EXIT_FUNCTION();
 		return;
 	}
-	g_key_file_set_value (keyfile, g_key_file_get_start_group (keyfile), property, value);
-	
-	data = g_key_file_to_data (keyfile, &length, &write_error);
-	if (write_error) {
-		g_propagate_error (&error, write_error);
+
+	keyfile = g_key_file_new ();
+	desktop_file = clp_app_mgr_app_names_get(application)->desktop_file;
+	if (!g_key_file_load_from_file (keyfile, desktop_file, G_KEY_FILE_NONE, NULL))
+	{
+		CLP_APPMGR_WARN_V("Unable to read %s", desktop_file);
+		g_key_file_free (keyfile);
 		CLP_APPMGR_EXIT_FUNCTION();
 		return;
 	}
-	write_error = NULL;
-	res = g_file_set_contents (desktop_file, data, length, &write_error);
-	if (write_error) {
-		g_propagate_error (&error, write_error);
+	for (i = 0; i < n_properties; i++)
+		g_key_file_set_value (keyfile, g_key_file_get_start_group (keyfile), properties[i], values[i]);
+	
+	data = g_key_file_to_data (keyfile, &length, NULL);
+	g_key_file_free (keyfile);
+	if (!g_file_set_contents (desktop_file, data, length, &write_error))
+	{
+		CLP_APPMGR_WARN_V("Unable to write %s : %s", desktop_file, write_error->message);
+		g_error_free (write_error);
 		g_free (data);
 		CLP_APPMGR_EXIT_FUNCTION();
 		return;
 	}
+	/* Revalidate the desktop caches now rather than on the inotify event */
+	clp_app_mgr_monitor_bump(CLP_APP_MGR_MONITOR_DESKTOP);
+	clp_app_mgr_desktop_db_schedule_compile();
 	
 	g_free(data);
-	g_free (desktop_file);	
-	g_key_file_free (keyfile);
+	CLP_APPMGR_EXIT_FUNCTION();
+	return;
+}
+
+
+/** \brief Set the property of the application
+ * 
+ * \param application Name of the application
+ * \param property The property name
+ * \param value The value to be set
+ *
+ * The value is appended to the overlay log of the application, see clp_app_mgr_set_properties().
+ */
+void clp_app_mgr_set_property (const gchar *application, const gchar *property, const gchar *value)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	const gchar *properties[] = { property, NULL };
+	const gchar *values[] = { value, NULL };
+
+	clp_app_mgr_set_properties(application, properties, values);
 	CLP_APPMGR_EXIT_FUNCTION();
 	return;
 }
@@ -3621,6 +4401,107 @@ clp_app_mgr_register_message_handler(const app_message message_handler)
 	return;
 }
 
+/** \brief Deliver the pending list change notification
+ *
+ * Idle callback. Diffs the current snapshot of the active applications against the one of the previous
+ * notification and calls the handler with the changes, if any.
+ */
+static gboolean
+app_list_change_dispatch(gpointer data)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+	ClpAppMgrActiveSnapshot *snapshot;
+	GList *changes;
+
+	appclient_context.app_list_idle = 0;
+	if (appclient_context.app_list_change_callback == NULL)
+	{
+		CLP_APPMGR_EXIT_FUNCTION();
+		return FALSE;
+	}
+
+	snapshot = clp_app_mgr_active_snapshot_get();
+	changes = clp_app_mgr_active_snapshot_diff(appclient_context.app_list_snapshot, snapshot);
+	clp_app_mgr_active_snapshot_unref(appclient_context.app_list_snapshot);
+	appclient_context.app_list_snapshot = snapshot;
+
+	if (changes)
+	{
+		CLP_APPMGR_INFO_V("Application list changed, %u changes up to snapshot %u", g_list_length(changes), clp_app_mgr_active_snapshot_get_serial(snapshot));
+		(appclient_context.app_list_change_callback)(changes);
+		g_list_foreach(changes, (GFunc) g_free, NULL);
+		g_list_free(changes);
+	}
+	CLP_APPMGR_EXIT_FUNCTION();
+	return FALSE;
+}
+
+
+/** \brief Schedule a list change notification
+ *
+ * Several signals arriving together are coalesced into one notification.
+ */
+static void
+app_list_change_schedule(void)
+{
+	if (appclient_context.app_list_change_callback && appclient_context.app_list_idle == 0)
+		appclient_context.app_list_idle = g_idle_add(app_list_change_dispatch, NULL);
+}
+
+
+/** \brief gconf notification of a change in the application registry
+ *
+ * Launched applications register their PID and change their visibility in the registry.
+ */
+static void
+app_list_registry_changed(GConfClient *client, guint cnxn_id, GConfEntry *entry, gpointer data)
+{
+	app_list_change_schedule();
+}
+
+
+/** \brief Register application list change handler
+ *
+ * \param list_change_handler callback function to be called when the list of active applications changes, NULL to stop the notifications
+ *
+ * list_change_handler is called from the main loop with a GList of ClpAppMgrAppListChange describing the instances
+ * added, removed or updated since the previous call. The changes of one call carry the serial of the snapshot they
+ * lead to, see clp_app_mgr_active_snapshot_get_serial(). The list belongs to the library and is freed once the
+ * handler returns. The handler may be registered before clp_app_mgr_init(), the changes are only seen after it.
+ */
+void
+clp_app_mgr_register_app_list_change_handler(const app_list_change list_change_handler)
+{
+	CLP_APPMGR_ENTER_FUNCTION();
+
+	appclient_context.app_list_change_callback = list_change_handler;
+	if (list_change_handler == NULL)
+	{
+		if (appclient_context.app_list_idle)
+			g_source_remove(appclient_context.app_list_idle);
+		appclient_context.app_list_idle = 0;
+		if (appclient_context.app_list_notify)
+			gconf_client_notify_remove(clp_app_mgr_registry_client(), appclient_context.app_list_notify);
+		appclient_context.app_list_notify = 0;
+		clp_app_mgr_active_snapshot_unref(appclient_context.app_list_snapshot);
+		appclient_context.app_list_snapshot = NULL;
+		CLP_APPMGR_EXIT_FUNCTION();
+		return;
+	}
+
+	/* changes are reported from the list as it is now */
+	if (appclient_context.app_list_snapshot == NULL)
+		appclient_context.app_list_snapshot = clp_app_mgr_active_snapshot_get();
+	if (appclient_context.app_list_notify == 0)
+	{
+		GConfClient *client = clp_app_mgr_registry_client();
+		appclient_context.app_list_notify = gconf_client_notify_add(client, GCONF_APPS_DIR, app_list_registry_changed, NULL, NULL, NULL);
+		clp_app_mgr_registry_watch();
+	}
+	CLP_APPMGR_EXIT_FUNCTION();
+}
+
+
 /** \brief Sends the message to another application
  *
  * \param application Name of the application to which the message is to be sent followed by NULL terminated message
@@ -3652,9 +4533,9 @@ gint clp_app_mgr_send_message(const gchar *application, va_list ap)
        	DBusError error;
 	dbus_error_init(&error);
 
-	gchar **split = g_strsplit(application,":",2);
-	gchar *dbusinterface = g_strconcat (CLP_APP_MGR_DBUS_INTERFACE,".", split[0], split[1], NULL);
-	gchar *dbusobject = g_strconcat (CLP_APP_MGR_DBUS_OBJECT, "/", split[0], split[1], NULL);
+	const ClpAppMgrAppNames *names = clp_app_mgr_app_names_get(application);
+	const gchar *dbusinterface = names->interface;
+	const gchar *dbusobject = names->object_path;
 
 	CLP_APPMGR_INFO_V("Sending Message to %s application on %s interface and %s objectpath !", application, dbusinterface, dbusobject);
 
@@ -0,0 +1,25 @@
+#include <glib.h>
+#include <stdio.h>
+#include "../src/clp-app-mgr-desktop-db.h"
+
+/* Usage: desktop-db-compiler [desktop file directory [output file]]
+ * Run at install time, and whenever a desktop file or mimeinfo.cache changes. */
+int main(int argc, char *argv[])
+{
+	GError *error = NULL;
+	const gchar *directory = NULL, *output = NULL;
+
+	if (argc > 1)
+		directory = argv[1];
+	if (argc > 2)
+		output = argv[2];
+
+	if (!clp_app_mgr_desktop_db_compile(directory, output, &error))
+	{
+		g_printerr(" Failed to compile the desktop database: %s\n", error ? error->message : "unknown error");
+		if (error)
+			g_error_free(error);
+		return 1;
+	}
+	return 0;
+}